@@ -0,0 +1,69 @@
+#include "base/asset_id.h"
+
+#include <atomic>
+#include <mutex>
+
+#include "base/flat_hash_map.h"
+#include "base/log.h"
+
+namespace base {
+
+namespace {
+
+// Names are stored in chunks that are never moved or freed, so they can be
+// read without locking.
+constexpr size_t kChunkSize = 1024;
+constexpr size_t kMaxChunks = 1024;
+
+struct InternTable {
+  FlatHashMap<std::string,
+              uint32_t,
+              std::hash<std::string_view>,
+              std::equal_to<>>
+      ids;
+  std::atomic<std::string*> chunks[kMaxChunks] = {};
+  uint32_t next_id = 1;
+  std::mutex lock;
+};
+
+InternTable& GetInternTable() {
+  // Intentionally never destroyed. Ids may be used after static destructors
+  // have run.
+  static InternTable* table = new InternTable;
+  return *table;
+}
+
+}  // namespace
+
+AssetId::AssetId(std::string_view name) {
+  InternTable& table = GetInternTable();
+  std::lock_guard<std::mutex> scoped_lock(table.lock);
+  auto it = table.ids.find(name);
+  if (it != table.ids.end()) {
+    value_ = it->second;
+    return;
+  }
+
+  uint32_t id = table.next_id++;
+  size_t chunk = id / kChunkSize;
+  CHECK(chunk < kMaxChunks) << "Too many asset ids.";
+  std::string* names = table.chunks[chunk].load(std::memory_order_relaxed);
+  if (!names) {
+    names = new std::string[kChunkSize];
+    table.chunks[chunk].store(names, std::memory_order_release);
+  }
+  names[id % kChunkSize] = name;
+  table.ids.try_emplace(std::string(name), id);
+  value_ = id;
+}
+
+const std::string& AssetId::GetName() const {
+  static const std::string* empty_name = new std::string;
+  if (!value_)
+    return *empty_name;
+  std::string* names = GetInternTable().chunks[value_ / kChunkSize].load(
+      std::memory_order_acquire);
+  return names[value_ % kChunkSize];
+}
+
+}  // namespace base
@@ -0,0 +1,43 @@
+#ifndef BASE_ASSET_ID_H
+#define BASE_ASSET_ID_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+namespace base {
+
+// Interned name of an asset, or of anything else that is looked up by name,
+// such as a shader uniform. The name is hashed once when it's interned. After
+// that, ids are cheap to copy, compare and hash, which makes them better keys
+// than strings. Names are never removed from the intern table. Thread-safe.
+class AssetId {
+ public:
+  // Constructs an invalid id.
+  AssetId() = default;
+
+  // Interns the name if it hasn't been seen before.
+  explicit AssetId(std::string_view name);
+
+  // Returns the name the id was created from. Empty for an invalid id.
+  const std::string& GetName() const;
+
+  uint32_t value() const { return value_; }
+  bool IsValid() const { return value_ != 0; }
+
+  bool operator==(const AssetId& other) const = default;
+
+ private:
+  uint32_t value_ = 0;
+};
+
+}  // namespace base
+
+template <>
+struct std::hash<base::AssetId> {
+  size_t operator()(const base::AssetId& id) const { return id.value(); }
+};
+
+#endif  // BASE_ASSET_ID_H
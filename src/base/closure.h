@@ -1,47 +1,200 @@
 #ifndef BASE_CLOSURE_H
 #define BASE_CLOSURE_H
 
+#include <cstddef>
 #include <functional>
 #include <memory>
-#include <string>
-#include <tuple>
+#include <new>
+#include <source_location>
+#include <type_traits>
+#include <utility>
 
-#ifdef _DEBUG
+#include "base/log.h"
 
-#define HERE std::make_tuple(__func__, __FILE__, __LINE__)
+#define HERE base::Location::Current()
 
 // Helper for logging location info, e.g. LOG(0) << LOCATION(from)
-#define LOCATION(from)                                                 \
-  std::get<0>(from) << "() [" << [](std::string path) -> std::string { \
-    size_t last_slash_pos = path.find_last_of("\\/");                  \
-    if (last_slash_pos != std::string::npos)                           \
-      path = path.substr(last_slash_pos + 1);                          \
-    return path;                                                       \
-  }(std::get<1>(from)) << ":"                                          \
-                       << std::get<2>(from) << "]"
-
-#else
-
-#define HERE nullptr
-#define LOCATION(from) ""
-
-#endif
+#define LOCATION(from)                                        \
+  (from).function_name() << " [" << (from).base_name() << ":" \
+                         << (from).line() << "]"
 
 namespace base {
 
 using Closure = std::function<void()>;
 
-#ifdef _DEBUG
-
-// Provides location info (function name, file name and line number) where of a
-// Closure was constructed.
-using Location = std::tuple<std::string, std::string, int>;
+template <typename Signature>
+class OnceCallback;
+
+// Move-only counterpart of std::function. Callables that fit in kInlineSize
+// bytes are stored inline, so wrapping a typical lambda doesn't allocate.
+// Larger callables are moved to the heap.
+template <typename R, typename... Args>
+class OnceCallback<R(Args...)> {
+ public:
+  static constexpr size_t kInlineSize = 56;
+
+  OnceCallback() = default;
+  OnceCallback(std::nullptr_t) {}
+
+  template <typename F>
+    requires(!std::is_same_v<std::decay_t<F>, OnceCallback> &&
+             std::is_invocable_r_v<R, std::decay_t<F>&, Args...>)
+  OnceCallback(F&& func) {
+    using Functor = std::decay_t<F>;
+    if constexpr (std::is_constructible_v<bool, const Functor&>) {
+      // Empty std::function or null function pointer.
+      if (!static_cast<bool>(func))
+        return;
+    }
+
+    if constexpr (kStoredInline<Functor>) {
+      new (storage_) Functor(std::forward<F>(func));
+      ops_ = &InlineOps<Functor>::kOps;
+    } else {
+      new (storage_) Functor*(new Functor(std::forward<F>(func)));
+      ops_ = &HeapOps<Functor>::kOps;
+    }
+  }
+
+  OnceCallback(OnceCallback&& other) noexcept { MoveFrom(other); }
+
+  ~OnceCallback() { Reset(); }
+
+  OnceCallback& operator=(OnceCallback&& other) noexcept {
+    if (this != &other) {
+      Reset();
+      MoveFrom(other);
+    }
+    return *this;
+  }
+
+  OnceCallback& operator=(std::nullptr_t) {
+    Reset();
+    return *this;
+  }
+
+  R operator()(Args... args) {
+    DCHECK(ops_) << "Empty or moved-from callback.";
+    return ops_->invoke(storage_, std::forward<Args>(args)...);
+  }
+
+  explicit operator bool() const { return !!ops_; }
+
+  void Reset() {
+    if (ops_) {
+      ops_->destroy(storage_);
+      ops_ = nullptr;
+    }
+  }
+
+ private:
+  struct Ops {
+    R (*invoke)(void* storage, Args&&... args);
+    // Move-constructs the callable into dst and destroys the one in src.
+    void (*relocate)(void* dst, void* src);
+    void (*destroy)(void* storage);
+  };
 
-#else
+  template <typename Functor>
+  static constexpr bool kStoredInline =
+      sizeof(Functor) <= kInlineSize && alignof(Functor) <= alignof(void*) &&
+      std::is_nothrow_move_constructible_v<Functor>;
+
+  // Discards the return value of the functor if R is void.
+  template <typename Functor>
+  static R InvokeFunctor(Functor& func, Args&&... args) {
+    if constexpr (std::is_void_v<R>)
+      std::invoke(func, std::forward<Args>(args)...);
+    else
+      return std::invoke(func, std::forward<Args>(args)...);
+  }
+
+  template <typename Functor>
+  struct InlineOps {
+    static R Invoke(void* storage, Args&&... args) {
+      return InvokeFunctor(*static_cast<Functor*>(storage),
+                           std::forward<Args>(args)...);
+    }
+    static void Relocate(void* dst, void* src) {
+      Functor* func = static_cast<Functor*>(src);
+      new (dst) Functor(std::move(*func));
+      func->~Functor();
+    }
+    static void Destroy(void* storage) {
+      static_cast<Functor*>(storage)->~Functor();
+    }
+    static constexpr Ops kOps = {Invoke, Relocate, Destroy};
+  };
 
-using Location = std::nullptr_t;
+  template <typename Functor>
+  struct HeapOps {
+    static Functor* Get(void* storage) {
+      return *static_cast<Functor**>(storage);
+    }
+    static R Invoke(void* storage, Args&&... args) {
+      return InvokeFunctor(*Get(storage), std::forward<Args>(args)...);
+    }
+    static void Relocate(void* dst, void* src) {
+      new (dst) Functor*(Get(src));
+    }
+    static void Destroy(void* storage) { delete Get(storage); }
+    static constexpr Ops kOps = {Invoke, Relocate, Destroy};
+  };
 
-#endif
+  alignas(void*) unsigned char storage_[kInlineSize];
+  const Ops* ops_ = nullptr;
+
+  void MoveFrom(OnceCallback& other) {
+    if (other.ops_) {
+      other.ops_->relocate(storage_, other.storage_);
+      ops_ = other.ops_;
+      other.ops_ = nullptr;
+    }
+  }
+
+  OnceCallback(const OnceCallback&) = delete;
+  OnceCallback& operator=(const OnceCallback&) = delete;
+};
+
+// Move-only closure. Can be constructed from any callable including
+// move-only lambdas and Closure.
+using OnceClosure = OnceCallback<void()>;
+
+// Provides location info (function name, file name and line number) of where a
+// task was posted. Holds pointers to string literals, so it's cheap enough to
+// keep in release builds.
+class Location {
+ public:
+  constexpr Location() = default;
+  constexpr explicit Location(const std::source_location& location)
+      : function_name_(location.function_name()),
+        file_name_(location.file_name()),
+        line_(location.line()) {}
+
+  static constexpr Location Current(
+      std::source_location location = std::source_location::current()) {
+    return Location(location);
+  }
+
+  const char* function_name() const { return function_name_; }
+  const char* file_name() const { return file_name_; }
+  int line() const { return line_; }
+
+  // File name without the directory.
+  const char* base_name() const {
+    const char* name = file_name_;
+    for (const char* p = file_name_; *p; ++p) {
+      if (*p == '/' || *p == '\\')
+        name = p + 1;
+    }
+    return name;
+  }
+
+ private:
+  const char* function_name_ = "";
+  const char* file_name_ = "";
+  int line_ = 0;
+};
 
 // Bind a method to an object with a std::weak_ptr.
 template <typename Class, typename ReturnType, typename... Args>
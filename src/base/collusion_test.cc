@@ -1,11 +1,105 @@
 #include "base/collusion_test.h"
 
 #include <algorithm>
+#include <bit>
 #include <cmath>
 #include <limits>
 
+#include "base/vecmath_simd.h"
+
 namespace base {
 
+namespace {
+
+size_t CountHits(const uint32_t* hit_mask, size_t count) {
+  size_t num_hits = 0;
+  for (size_t i = 0; i < HitMaskSize(count); ++i)
+    num_hits += std::popcount(hit_mask[i]);
+  return num_hits;
+}
+
+#if defined(VECMATH_SIMD)
+
+using namespace internal;
+
+constexpr size_t kLanes = 4;
+
+// Tests 4 boxes at a time. Returns the number of boxes tested.
+size_t IntersectBoxes(const BoxArrays& boxes,
+                      const Vector2f& point,
+                      uint32_t* hit_mask) {
+  F32x4 point_x = SplatF32x4(point.x);
+  F32x4 point_y = SplatF32x4(point.y);
+  F32x4 half = SplatF32x4(0.5f);
+  size_t i = 0;
+  for (; i + kLanes <= boxes.count; i += kLanes) {
+    F32x4 dx = Abs(Sub(point_x, LoadF32x4(boxes.center_x + i)));
+    F32x4 dy = Abs(Sub(point_y, LoadF32x4(boxes.center_y + i)));
+    F32x4 half_size_x = Mul(LoadF32x4(boxes.size_x + i), half);
+    F32x4 half_size_y = Mul(LoadF32x4(boxes.size_y + i), half);
+    F32x4 hit = And(CmpLt(dx, half_size_x), CmpLt(dy, half_size_y));
+    hit_mask[i / 32] |= uint32_t(MoveMask(hit)) << (i % 32);
+  }
+  return i;
+}
+
+size_t IntersectBoxes(const BoxArrays& boxes,
+                      const Vector2f& origin,
+                      const Vector2f& dir,
+                      uint32_t* hit_mask,
+                      float* entry_distance) {
+  F32x4 origin_x = SplatF32x4(origin.x);
+  F32x4 origin_y = SplatF32x4(origin.y);
+  F32x4 dir_x = SplatF32x4(dir.x);
+  F32x4 dir_y = SplatF32x4(dir.y);
+  F32x4 half = SplatF32x4(0.5f);
+  F32x4 zero = SplatF32x4(0);
+  F32x4 max_float = SplatF32x4(std::numeric_limits<float>::max());
+  size_t i = 0;
+  for (; i + kLanes <= boxes.count; i += kLanes) {
+    F32x4 center_x = LoadF32x4(boxes.center_x + i);
+    F32x4 center_y = LoadF32x4(boxes.center_y + i);
+    F32x4 half_size_x = Mul(LoadF32x4(boxes.size_x + i), half);
+    F32x4 half_size_y = Mul(LoadF32x4(boxes.size_y + i), half);
+    F32x4 min_x = Sub(center_x, half_size_x);
+    F32x4 max_x = Add(center_x, half_size_x);
+    F32x4 min_y = Sub(center_y, half_size_y);
+    F32x4 max_y = Add(center_y, half_size_y);
+
+    // Same steps as the scalar version.
+    F32x4 tmin = zero;
+    F32x4 tmax = max_float;
+    F32x4 inside = CmpLe(zero, zero);
+    if (dir.x != 0) {
+      F32x4 tx1 = Div(Sub(min_x, origin_x), dir_x);
+      F32x4 tx2 = Div(Sub(max_x, origin_x), dir_x);
+      tmin = Max(tmin, Min(tx1, tx2));
+      tmax = Min(tmax, Max(tx1, tx2));
+    } else {
+      inside = And(CmpLe(min_x, origin_x), CmpLe(origin_x, max_x));
+    }
+    if (dir.y != 0) {
+      F32x4 ty1 = Div(Sub(min_y, origin_y), dir_y);
+      F32x4 ty2 = Div(Sub(max_y, origin_y), dir_y);
+      tmin = Max(tmin, Min(ty1, ty2));
+      tmax = Min(tmax, Max(ty1, ty2));
+    } else {
+      inside = And(inside,
+                   And(CmpLe(min_y, origin_y), CmpLe(origin_y, max_y)));
+    }
+
+    F32x4 hit = And(CmpLe(tmin, tmax), inside);
+    hit_mask[i / 32] |= uint32_t(MoveMask(hit)) << (i % 32);
+    if (entry_distance)
+      StoreF32x4(entry_distance + i, tmin);
+  }
+  return i;
+}
+
+#endif  // defined(VECMATH_SIMD)
+
+}  // namespace
+
 bool Intersection(const Vector2f& center,
                   const Vector2f& size,
                   const Vector2f& point) {
@@ -22,11 +116,13 @@ bool Intersection(const Vector2f& center,
 bool Intersection(const Vector2f& center,
                   const Vector2f& size,
                   const Vector2f& origin,
-                  const Vector2f& dir) {
+                  const Vector2f& dir,
+                  float* entry_distance) {
   Vector2f min = center - size / 2;
   Vector2f max = center + size / 2;
 
-  float tmin = std::numeric_limits<float>::min();
+  // The ray starts at origin, boxes behind it are not hit.
+  float tmin = 0;
   float tmax = std::numeric_limits<float>::max();
 
   if (dir.x != 0.0) {
@@ -35,6 +131,9 @@ bool Intersection(const Vector2f& center,
 
     tmin = std::max(tmin, std::min(tx1, tx2));
     tmax = std::min(tmax, std::max(tx1, tx2));
+  } else if (origin.x < min.x || origin.x > max.x) {
+    // Parallel to the slab and outside of it.
+    return false;
   }
 
   if (dir.y != 0.0) {
@@ -43,9 +142,49 @@ bool Intersection(const Vector2f& center,
 
     tmin = std::max(tmin, std::min(ty1, ty2));
     tmax = std::min(tmax, std::max(ty1, ty2));
+  } else if (origin.y < min.y || origin.y > max.y) {
+    return false;
   }
 
-  return tmax >= tmin;
+  bool hit = tmax >= tmin;
+  if (hit && entry_distance)
+    *entry_distance = tmin;
+  return hit;
+}
+
+size_t Intersection(const BoxArrays& boxes,
+                    const Vector2f& point,
+                    uint32_t* hit_mask) {
+  std::fill_n(hit_mask, HitMaskSize(boxes.count), 0);
+  size_t i = 0;
+#if defined(VECMATH_SIMD)
+  i = IntersectBoxes(boxes, point, hit_mask);
+#endif
+  for (; i < boxes.count; ++i) {
+    if (Intersection({boxes.center_x[i], boxes.center_y[i]},
+                     {boxes.size_x[i], boxes.size_y[i]}, point))
+      hit_mask[i / 32] |= 1u << (i % 32);
+  }
+  return CountHits(hit_mask, boxes.count);
+}
+
+size_t Intersection(const BoxArrays& boxes,
+                    const Vector2f& origin,
+                    const Vector2f& dir,
+                    uint32_t* hit_mask,
+                    float* entry_distance) {
+  std::fill_n(hit_mask, HitMaskSize(boxes.count), 0);
+  size_t i = 0;
+#if defined(VECMATH_SIMD)
+  i = IntersectBoxes(boxes, origin, dir, hit_mask, entry_distance);
+#endif
+  for (; i < boxes.count; ++i) {
+    if (Intersection({boxes.center_x[i], boxes.center_y[i]},
+                     {boxes.size_x[i], boxes.size_y[i]}, origin, dir,
+                     entry_distance ? entry_distance + i : nullptr))
+      hit_mask[i / 32] |= 1u << (i % 32);
+  }
+  return CountHits(hit_mask, boxes.count);
 }
 
 }  // namespace base
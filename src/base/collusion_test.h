@@ -1,6 +1,9 @@
 #ifndef BASE_COLLUSION_TEST_H
 #define BASE_COLLUSION_TEST_H
 
+#include <cstddef>
+#include <cstdint>
+
 #include "base/vecmath.h"
 
 namespace base {
@@ -13,10 +16,43 @@ bool Intersection(const Vector2f& center,
 // Ray-AABB intersection test.
 // center, size: Center and size of the box.
 // origin, dir: Origin and direction of the ray.
+// entry_distance: If not null, set to where the ray enters the box in units of
+// dir's length, or 0 if origin is inside the box. Only set if there is a hit.
 bool Intersection(const Vector2f& center,
                   const Vector2f& size,
                   const Vector2f& origin,
-                  const Vector2f& dir);
+                  const Vector2f& dir,
+                  float* entry_distance = nullptr);
+
+// Boxes in structure-of-arrays form for the batch tests below.
+struct BoxArrays {
+  const float* center_x;
+  const float* center_y;
+  const float* size_x;
+  const float* size_y;
+  size_t count;
+};
+
+// Number of 32-bit words needed for the hit mask of the given number of boxes.
+constexpr size_t HitMaskSize(size_t count) {
+  return (count + 31) / 32;
+}
+
+// Batch versions of the above. Test 4 boxes at a time with SSE2 or NEON.
+// Entry distances may differ from the ones above in the last bits, as the
+// compiler can round the scalar math differently.
+// Bit i % 32 of hit_mask[i / 32] is set if box i is hit. Returns the number of
+// boxes hit. entry_distance, if not null, must have boxes.count elements. It's
+// set for the boxes that are hit, the others are left undefined.
+size_t Intersection(const BoxArrays& boxes,
+                    const Vector2f& point,
+                    uint32_t* hit_mask);
+
+size_t Intersection(const BoxArrays& boxes,
+                    const Vector2f& origin,
+                    const Vector2f& dir,
+                    uint32_t* hit_mask,
+                    float* entry_distance = nullptr);
 
 }  // namespace base
 
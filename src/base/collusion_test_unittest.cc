@@ -0,0 +1,106 @@
+#include "base/collusion_test.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "base/random.h"
+#include "base/unittest.h"
+
+using namespace base;
+
+namespace {
+
+// The release build uses fast-math, which may reorder or contract the scalar
+// math, so entry distances can differ in the last bits.
+bool Near(float a, float b) {
+  return std::abs(a - b) <= 1e-5f * std::max({1.0f, std::abs(a), std::abs(b)});
+}
+
+}  // namespace
+
+// The batch versions must hit the same boxes as testing the boxes one by one
+// with the scalar versions, at nearly the same entry distances.
+TEST(CollusionTest, BatchMatchesScalar) {
+  Random random(1);
+  for (int round = 0; round < 2000; ++round) {
+    // Leaves every possible remainder for the scalar path.
+    size_t count = random.Roll(70) - 1;
+    std::vector<float> center_x(count), center_y(count), size_x(count),
+        size_y(count);
+    for (size_t i = 0; i < count; ++i) {
+      center_x[i] = Lerp(-50.0f, 50.0f, random.Rand());
+      center_y[i] = Lerp(-50.0f, 50.0f, random.Rand());
+      size_x[i] = Lerp(0.0f, 12.0f, random.Rand());
+      size_y[i] = Lerp(0.0f, 12.0f, random.Rand());
+      // Zero-size boxes.
+      if (i % 9 == 0)
+        size_x[i] = 0;
+      // Slab edges on integer coordinates.
+      if (i % 13 == 0) {
+        center_x[i] = std::floor(center_x[i]);
+        size_x[i] = 4;
+      }
+    }
+    BoxArrays boxes = {center_x.data(), center_y.data(), size_x.data(),
+                       size_y.data(), count};
+
+    for (int query = 0; query < 50; ++query) {
+      Vector2f origin(Lerp(-50.0f, 50.0f, random.Rand()),
+                      Lerp(-50.0f, 50.0f, random.Rand()));
+      Vector2f dir(Lerp(-1.0f, 1.0f, random.Rand()),
+                   Lerp(-1.0f, 1.0f, random.Rand()));
+      // Axis-parallel directions.
+      if (query % 5 == 0)
+        dir.x = 0;
+      if (query % 7 == 0)
+        dir.y = 0;
+      // Origins on the slab edges of the integer aligned boxes.
+      if (query % 11 == 0)
+        origin.x = std::floor(origin.x) + 2;
+
+      // The extra word catches overruns.
+      constexpr uint32_t kGuard = 0xdeadbeef;
+      std::vector<uint32_t> hit_mask(HitMaskSize(count) + 1, kGuard);
+      std::vector<float> entry_distance(count, -1);
+      bool ray = query % 2;
+      size_t num_hits =
+          ray ? Intersection(boxes, origin, dir, hit_mask.data(),
+                             entry_distance.data())
+              : Intersection(boxes, origin, hit_mask.data());
+      EXPECT(hit_mask.back() == kGuard) << "Hit mask overrun.";
+
+      size_t expected_hits = 0;
+      for (size_t i = 0; i < count; ++i) {
+        Vector2f center(center_x[i], center_y[i]);
+        Vector2f size(size_x[i], size_y[i]);
+        float distance = -2;
+        bool expected = ray ? Intersection(center, size, origin, dir, &distance)
+                            : Intersection(center, size, origin);
+        bool hit = (hit_mask[i / 32] >> (i % 32)) & 1;
+        EXPECT(hit == expected) << "round: " << round << " query: " << query
+                                << " box: " << i;
+        if (ray && expected) {
+          EXPECT(Near(entry_distance[i], distance))
+              << entry_distance[i] << " vs " << distance << " round: " << round
+              << " query: " << query << " box: " << i;
+        }
+        expected_hits += expected;
+      }
+      EXPECT(num_hits == expected_hits);
+    }
+  }
+}
+
+TEST(CollusionTest, Ray) {
+  float distance = -1;
+  // Box behind the origin.
+  EXPECT(!Intersection({0, -5}, {2, 2}, {0, 0}, {0, 1}));
+  // Origin inside the box.
+  EXPECT(Intersection({0, 0}, {2, 2}, {0, 0}, {0, 1}, &distance));
+  EXPECT(distance == 0) << distance;
+  // Entry distance is in units of dir's length.
+  EXPECT(Intersection({0, 5}, {2, 2}, {0, 0}, {0, 2}, &distance));
+  EXPECT(distance == 2) << distance;
+}
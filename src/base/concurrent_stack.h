@@ -2,20 +2,30 @@
 #define BASE_CONCURRENT_STACK_H
 
 #include <atomic>
+#include <cstdint>
+#include <new>
 #include <utility>
 
+#include "base/node_pool.h"
+
 namespace base {
 
 // Lock-free concurrent stack. All methods are thread-safe and can be called on
 // any thread.
+// Nodes come from a NodePool that is shared by all stacks of the same type. The
+// head of the stack is a tagged index, which protects against the ABA problem.
+// Steady-state Push/Pop doesn't allocate.
 template <typename T>
 class ConcurrentStack {
   struct Node {
-    T item;
-    Node* next = nullptr;
-    Node(T item) : item(std::move(item)) {}
+    std::atomic<uint32_t> next{0};
+    alignas(T) unsigned char storage[sizeof(T)];
+
+    T* item() { return std::launder(reinterpret_cast<T*>(storage)); }
   };
 
+  using Pool = internal::NodePool<Node>;
+
  public:
   ConcurrentStack() = default;
 
@@ -29,57 +39,52 @@ class ConcurrentStack {
   }
 
   void Push(T item) {
-    Node* new_node = new Node(std::move(item));
-    new_node->next = head_.load(std::memory_order_relaxed);
-    while (!head_.compare_exchange_weak(new_node->next, new_node,
-                                        std::memory_order_release,
-                                        std::memory_order_relaxed))
-      ;
+    uint32_t index = Pool::Acquire();
+    new (GetNode(index).storage) T(std::move(item));
+    head_.Push(index, index);
   }
 
   bool Pop(T& item) {
-    Node* head_node = head_.load(std::memory_order_relaxed);
-    if (!head_node)
+    uint32_t index = head_.Pop();
+    if (!index)
       return false;
-    while (!head_.compare_exchange_weak(head_node, head_node->next,
-                                        std::memory_order_acquire,
-                                        std::memory_order_relaxed)) {
-      if (!head_node)
-        return false;
-    }
 
-    item = std::move(head_node->item);
-    delete head_node;
+    T* node_item = GetNode(index).item();
+    item = std::move(*node_item);
+    node_item->~T();
+    Pool::Release(index);
     return true;
   }
 
-  void Clear() {
-    Node* null_node = nullptr;
-    Node* head_node = head_.load(std::memory_order_relaxed);
-    while (!head_.compare_exchange_weak(head_node, null_node,
-                                        std::memory_order_relaxed))
-      ;
-
-    while (head_node) {
-      Node* next_node = head_node->next;
-      delete head_node;
-      head_node = next_node;
-    }
-  }
+  void Clear() { DestroyList(head_.PopAll()); }
 
-  bool Empty() const { return !head_.load(std::memory_order_relaxed); }
+  bool Empty() const { return head_.Empty(); }
 
  private:
-  std::atomic<Node*> head_ = nullptr;
+  typename Pool::TaggedHead head_;
 
-  void MoveAssign(ConcurrentStack<T>&& other) {
-    Node* null_node = nullptr;
-    Node* head_node = other.head_.load(std::memory_order_relaxed);
-    while (!other.head_.compare_exchange_weak(head_node, null_node,
-                                              std::memory_order_relaxed))
-      ;
+  static Node& GetNode(uint32_t index) { return Pool::GetNode(index); }
 
-    head_.store(head_node, std::memory_order_relaxed);
+  static void DestroyList(uint32_t index) {
+    while (index) {
+      Node& node = GetNode(index);
+      uint32_t next = node.next.load(std::memory_order_relaxed);
+      node.item()->~T();
+      Pool::Release(index);
+      index = next;
+    }
+  }
+
+  void MoveAssign(ConcurrentStack<T>&& other) {
+    Clear();
+
+    uint32_t first = other.head_.PopAll();
+    if (!first)
+      return;
+    uint32_t last = first;
+    while (uint32_t next = GetNode(last).next.load(std::memory_order_relaxed))
+      last = next;
+    head_.Push(first, last);
   }
 
   ConcurrentStack(const ConcurrentStack<T>&) = delete;
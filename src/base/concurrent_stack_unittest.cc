@@ -0,0 +1,78 @@
+#include "base/concurrent_stack.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "base/unittest.h"
+
+using namespace base;
+
+TEST(ConcurrentStack, PushPopOrder) {
+  // Spans several chunks of the node pool.
+  constexpr int kCount = 10000;
+  ConcurrentStack<int> stack;
+  for (int i = 0; i < kCount; ++i)
+    stack.Push(i);
+
+  for (int i = kCount - 1; i >= 0; --i) {
+    int value = -1;
+    EXPECT(stack.Pop(value));
+    EXPECT(value == i) << "value: " << value << " expected: " << i;
+  }
+  EXPECT(stack.Empty());
+}
+
+TEST(ConcurrentStack, Move) {
+  ConcurrentStack<int> stack;
+  stack.Push(1);
+  stack.Push(2);
+
+  ConcurrentStack<int> other(std::move(stack));
+  EXPECT(stack.Empty());
+
+  int value = 0;
+  EXPECT(other.Pop(value) && value == 2);
+  EXPECT(other.Pop(value) && value == 1);
+  EXPECT(!other.Pop(value));
+}
+
+// N producers and N consumers. Each pushed value must be popped exactly once.
+TEST(ConcurrentStack, Stress) {
+  constexpr int kThreads = 8;
+  constexpr int kValuesPerThread = 200000;
+  constexpr int kTotal = kThreads * kValuesPerThread;
+
+  ConcurrentStack<int> stack;
+  std::vector<std::atomic<int>> pop_count(kTotal);
+  std::atomic<int> popped{0};
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&, t]() -> void {
+      for (int i = 0; i < kValuesPerThread; ++i)
+        stack.Push(t * kValuesPerThread + i);
+    });
+    threads.emplace_back([&]() -> void {
+      while (popped.load(std::memory_order_relaxed) < kTotal) {
+        int value;
+        if (stack.Pop(value)) {
+          pop_count[value].fetch_add(1, std::memory_order_relaxed);
+          popped.fetch_add(1, std::memory_order_relaxed);
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (auto& thread : threads)
+    thread.join();
+
+  EXPECT(stack.Empty());
+  int wrong = 0;
+  for (int i = 0; i < kTotal; ++i) {
+    if (pop_count[i].load(std::memory_order_relaxed) != 1)
+      ++wrong;
+  }
+  EXPECT(wrong == 0) << wrong << " values not popped exactly once.";
+}
@@ -0,0 +1,43 @@
+#include "base/delayed_task_queue.h"
+
+#include <algorithm>
+
+namespace base {
+
+namespace internal {
+
+namespace {
+
+// Comparator for a min-heap. std heap functions keep the largest element on
+// top.
+bool IsLater(const DelayedTask& a, const DelayedTask& b) {
+  if (a.deadline != b.deadline)
+    return a.deadline > b.deadline;
+  return a.sequence > b.sequence;
+}
+
+}  // namespace
+
+void DelayedTaskQueue::Push(DelayedTask task) {
+  task.sequence = next_sequence_++;
+  heap_.push_back(std::move(task));
+  std::push_heap(heap_.begin(), heap_.end(), IsLater);
+}
+
+bool DelayedTaskQueue::PopDue(Clock::time_point now, DelayedTask& task) {
+  if (heap_.empty() || heap_.front().deadline > now)
+    return false;
+
+  std::pop_heap(heap_.begin(), heap_.end(), IsLater);
+  task = std::move(heap_.back());
+  heap_.pop_back();
+  return true;
+}
+
+Clock::time_point DelayedTaskQueue::NextDeadline() const {
+  return heap_.empty() ? Clock::time_point::max() : heap_.front().deadline;
+}
+
+}  // namespace internal
+
+}  // namespace base
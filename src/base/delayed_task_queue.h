@@ -0,0 +1,95 @@
+#ifndef BASE_DELAYED_TASK_QUEUE_H
+#define BASE_DELAYED_TASK_QUEUE_H
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "base/closure.h"
+
+namespace base {
+
+namespace internal {
+
+using Clock = std::chrono::steady_clock;
+
+inline Clock::time_point DeadlineFromNow(double delay_seconds) {
+  return Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                            std::chrono::duration<double>(delay_seconds));
+}
+
+struct DelayedTask {
+  Clock::time_point deadline;
+  Location from;
+  OnceClosure task;
+  // Assigned by DelayedTaskQueue to keep FIFO order for equal deadlines.
+  uint64_t sequence = 0;
+};
+
+// Min-heap of delayed tasks ordered by deadline. Not thread-safe.
+class DelayedTaskQueue {
+ public:
+  DelayedTaskQueue() = default;
+  ~DelayedTaskQueue() = default;
+
+  void Push(DelayedTask task);
+
+  // Pops the task with the earliest deadline if the deadline is not later than
+  // now.
+  bool PopDue(Clock::time_point now, DelayedTask& task);
+
+  // Returns Clock::time_point::max() if the queue is empty.
+  Clock::time_point NextDeadline() const;
+
+  bool Empty() const { return heap_.empty(); }
+
+  void Clear() { heap_.clear(); }
+
+ private:
+  std::vector<DelayedTask> heap_;
+  uint64_t next_sequence_ = 0;
+
+  DelayedTaskQueue(DelayedTaskQueue const&) = delete;
+  DelayedTaskQueue& operator=(DelayedTaskQueue const&) = delete;
+};
+
+// Runs the task and posts itself again with the same interval for as long as
+// the task returns true. Runner can be TaskRunner or ThreadPool. The state is
+// shared between the repetitions, so the relay itself fits in OnceClosure's
+// inline storage and reposting doesn't allocate.
+template <typename Runner>
+class RepeatingTaskRelay {
+ public:
+  RepeatingTaskRelay(Location from,
+                     std::function<bool()> task,
+                     double interval,
+                     Runner* runner)
+      : state_(std::make_shared<State>(
+            State{from, std::move(task), interval, runner})) {}
+
+  void operator()() {
+    if (state_->task()) {
+      State& state = *state_;
+      state.runner->PostDelayedTask(state.from, std::move(*this),
+                                    state.interval);
+    }
+  }
+
+ private:
+  struct State {
+    Location from;
+    std::function<bool()> task;
+    double interval;
+    Runner* runner;
+  };
+
+  std::shared_ptr<State> state_;
+};
+
+}  // namespace internal
+
+}  // namespace base
+
+#endif  // BASE_DELAYED_TASK_QUEUE_H
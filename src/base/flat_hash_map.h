@@ -0,0 +1,459 @@
+#ifndef BASE_FLAT_HASH_MAP_H
+#define BASE_FLAT_HASH_MAP_H
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// Builds with FLAT_HASH_MAP_NO_SIMD defined use the portable group on all
+// targets.
+#if !defined(FLAT_HASH_MAP_NO_SIMD)
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FLAT_HASH_MAP_SSE2
+#include <emmintrin.h>
+#endif
+#endif
+
+#include "base/log.h"
+
+namespace base {
+
+namespace internal {
+
+// Each slot has a control byte. Full slots store the low 7 bits of the hash of
+// their key, so most mismatches are rejected without touching the slot.
+using ControlByte = int8_t;
+constexpr ControlByte kEmpty = -128;
+constexpr ControlByte kDeleted = -2;
+
+// Bit mask of the slots in a group that matched a query. Each slot is
+// represented by 1 << kShift bits.
+template <int kShift>
+class GroupMask {
+ public:
+  explicit GroupMask(uint64_t mask) : mask_(mask) {}
+
+  explicit operator bool() const { return mask_ != 0; }
+
+  size_t Lowest() const { return std::countr_zero(mask_) >> kShift; }
+  void ClearLowest() { mask_ &= mask_ - 1; }
+
+ private:
+  uint64_t mask_;
+};
+
+// Control bytes of kWidth consecutive slots, matched in parallel. Portable
+// version that operates on 8 control bytes in a 64-bit word. Assumes a
+// little-endian target. Always compiled so it can be tested on any target.
+class PortableGroup {
+ public:
+  static constexpr size_t kWidth = 8;
+
+  using Mask = GroupMask<3>;
+
+  explicit PortableGroup(const ControlByte* ctrl) {
+    memcpy(&ctrl_, ctrl, kWidth);
+  }
+
+  // May report false positives for slots after a true match, which are
+  // rejected when comparing keys.
+  Mask Match(ControlByte h2) const {
+    uint64_t x = ctrl_ ^ (kLsbs * static_cast<uint8_t>(h2));
+    return Mask((x - kLsbs) & ~x & kMsbs);
+  }
+
+  // kEmpty is the only control byte with the sign bit set and bit 1 clear.
+  Mask MatchEmpty() const { return Mask(ctrl_ & ~(ctrl_ << 6) & kMsbs); }
+
+  Mask MatchEmptyOrDeleted() const { return Mask(ctrl_ & kMsbs); }
+
+ private:
+  static constexpr uint64_t kLsbs = 0x0101010101010101ull;
+  static constexpr uint64_t kMsbs = 0x8080808080808080ull;
+
+  uint64_t ctrl_;
+};
+
+#if defined(FLAT_HASH_MAP_SSE2)
+
+// Matches 16 control bytes at once with SSE2.
+class Sse2Group {
+ public:
+  static constexpr size_t kWidth = 16;
+
+  using Mask = GroupMask<0>;
+
+  explicit Sse2Group(const ControlByte* ctrl)
+      : ctrl_(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl))) {}
+
+  Mask Match(ControlByte h2) const {
+    return Mask(static_cast<uint32_t>(
+        _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl_, _mm_set1_epi8(h2)))));
+  }
+
+  Mask MatchEmpty() const { return Match(kEmpty); }
+
+  Mask MatchEmptyOrDeleted() const {
+    return Mask(static_cast<uint32_t>(_mm_movemask_epi8(ctrl_)));
+  }
+
+ private:
+  __m128i ctrl_;
+};
+
+using Group = Sse2Group;
+
+#else
+
+using Group = PortableGroup;
+
+#endif
+
+}  // namespace internal
+
+// Open-addressing hash map in the style of Abseil's SwissTable. Elements are
+// stored inline in a flat array, next to an array of control bytes that are
+// probed a group at a time with SIMD. Lookups usually take a single cache miss
+// and iteration is a linear scan. Keeps at most 7/8 of the slots full.
+// Inserting may invalidate iterators and pointers to elements. Erasing only
+// invalidates the erased element.
+// Heterogeneous lookup is supported if Hash and KeyEqual accept the type, e.g.
+// std::string keys can be looked up with std::string_view by using
+// std::hash<std::string_view> and std::equal_to<>.
+template <typename Key,
+          typename Value,
+          typename Hash = std::hash<Key>,
+          typename KeyEqual = std::equal_to<Key>>
+class FlatHashMap {
+  union Slot;
+
+ public:
+  using key_type = Key;
+  using mapped_type = Value;
+  using value_type = std::pair<const Key, Value>;
+
+  template <bool kConst>
+  class Iterator {
+   public:
+    using Reference =
+        std::conditional_t<kConst, const value_type&, value_type&>;
+    using Pointer = std::conditional_t<kConst, const value_type*, value_type*>;
+
+    Iterator() = default;
+    // Allows converting iterator to const_iterator. A template, so it doesn't
+    // suppress the implicit copy constructor and assignment.
+    template <bool kOtherConst>
+      requires(kConst && !kOtherConst)
+    Iterator(const Iterator<kOtherConst>& other)
+        : ctrl_(other.ctrl_), end_(other.end_), slot_(other.slot_) {}
+
+    Reference operator*() const { return slot_->value; }
+    Pointer operator->() const { return &slot_->value; }
+
+    Iterator& operator++() {
+      ++ctrl_;
+      ++slot_;
+      SkipEmptySlots();
+      return *this;
+    }
+
+    bool operator==(const Iterator& other) const {
+      return ctrl_ == other.ctrl_;
+    }
+
+   private:
+    friend class FlatHashMap;
+    template <bool>
+    friend class Iterator;
+
+    const internal::ControlByte* ctrl_ = nullptr;
+    const internal::ControlByte* end_ = nullptr;
+    Slot* slot_ = nullptr;
+
+    Iterator(const internal::ControlByte* ctrl,
+             const internal::ControlByte* end,
+             Slot* slot)
+        : ctrl_(ctrl), end_(end), slot_(slot) {}
+
+    void SkipEmptySlots() {
+      while (ctrl_ != end_ && *ctrl_ < 0) {
+        ++ctrl_;
+        ++slot_;
+      }
+    }
+  };
+
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+
+  FlatHashMap() = default;
+  ~FlatHashMap() { DestroySlots(); }
+
+  FlatHashMap(FlatHashMap&& other) noexcept { Swap(other); }
+  FlatHashMap& operator=(FlatHashMap&& other) noexcept {
+    FlatHashMap tmp(std::move(other));
+    Swap(tmp);
+    return *this;
+  }
+
+  iterator begin() { return MakeIterator(0, true); }
+  iterator end() { return MakeIterator(capacity_, false); }
+  const_iterator begin() const {
+    return const_cast<FlatHashMap*>(this)->begin();
+  }
+  const_iterator end() const { return const_cast<FlatHashMap*>(this)->end(); }
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  size_t capacity() const { return capacity_; }
+
+  template <typename K = Key>
+  iterator find(const K& key) {
+    size_t index = FindIndex(key, HashOf(key));
+    return index == kNotFound ? end() : MakeIterator(index, false);
+  }
+
+  template <typename K = Key>
+  const_iterator find(const K& key) const {
+    return const_cast<FlatHashMap*>(this)->find(key);
+  }
+
+  template <typename K = Key>
+  bool contains(const K& key) const {
+    return FindIndex(key, HashOf(key)) != kNotFound;
+  }
+
+  Value& operator[](const Key& key) { return try_emplace(key).first->second; }
+  Value& operator[](Key&& key) {
+    return try_emplace(std::move(key)).first->second;
+  }
+
+  // Inserts an element constructed from args if the key doesn't exist.
+  // Returns the element with the key and whether it was inserted.
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(const Key& key, Args&&... args) {
+    return TryEmplace(key, std::forward<Args>(args)...);
+  }
+
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(Key&& key, Args&&... args) {
+    return TryEmplace(std::move(key), std::forward<Args>(args)...);
+  }
+
+  template <typename K = Key>
+  size_t erase(const K& key) {
+    size_t index = FindIndex(key, HashOf(key));
+    if (index == kNotFound)
+      return 0;
+    EraseIndex(index);
+    return 1;
+  }
+
+  // Returns an iterator to the next element.
+  iterator erase(iterator it) {
+    DCHECK(it != end());
+    EraseIndex(it.ctrl_ - ctrl_.get());
+    return ++it;
+  }
+
+  // Destroys all elements and keeps the capacity.
+  void clear() {
+    DestroySlots();
+    if (capacity_)
+      memset(ctrl_.get(), internal::kEmpty, capacity_ + kWidth);
+    size_ = 0;
+    growth_left_ = MaxLoad(capacity_);
+  }
+
+  void reserve(size_t count) {
+    size_t capacity = CapacityFor(count);
+    if (capacity > capacity_)
+      Resize(capacity);
+  }
+
+ private:
+  using Group = internal::Group;
+
+  union Slot {
+    value_type value;
+
+    Slot() {}
+    ~Slot() {}
+  };
+
+  static constexpr size_t kWidth = Group::kWidth;
+  static constexpr size_t kNotFound = ~size_t(0);
+  // Larger requests fail to allocate.
+  static constexpr size_t kMaxCapacity = size_t{1} << (sizeof(size_t) * 8 - 2);
+
+  // Control bytes for capacity_ slots, followed by a copy of the first kWidth
+  // so that a group can be loaded at any slot without wrapping around.
+  std::unique_ptr<internal::ControlByte[]> ctrl_;
+  std::unique_ptr<Slot[]> slots_;
+  size_t capacity_ = 0;  // Zero or a power of two no less than kWidth.
+  size_t size_ = 0;
+  // Number of empty slots that can be filled before growing.
+  size_t growth_left_ = 0;
+
+  static size_t MaxLoad(size_t capacity) { return capacity - capacity / 8; }
+
+  // Smallest capacity with MaxLoad(capacity) >= count.
+  static size_t CapacityFor(size_t count) {
+    count = std::min(count, MaxLoad(kMaxCapacity));
+    return std::max(kWidth, std::bit_ceil(count + (count + 6) / 7));
+  }
+
+  // Mixes the bits as std::hash is the identity function for integers in
+  // some implementations.
+  template <typename K>
+  static uint64_t HashOf(const K& key) {
+    uint64_t hash = uint64_t(Hash()(key)) * 0x9e3779b97f4a7c15ull;
+    return hash ^ (hash >> 32);
+  }
+
+  static size_t H1(uint64_t hash) { return size_t(hash >> 7); }
+  static internal::ControlByte H2(uint64_t hash) {
+    return internal::ControlByte(hash & 0x7f);
+  }
+
+  iterator MakeIterator(size_t index, bool skip_empty) {
+    iterator it(ctrl_.get() + index, ctrl_.get() + capacity_,
+                slots_.get() + index);
+    if (skip_empty)
+      it.SkipEmptySlots();
+    return it;
+  }
+
+  // Probes groups in a triangular sequence, which visits every group once
+  // when the capacity is a power of two.
+  template <typename K>
+  size_t FindIndex(const K& key, uint64_t hash) const {
+    if (!capacity_)
+      return kNotFound;
+    size_t mask = capacity_ - 1;
+    size_t pos = H1(hash) & mask;
+    for (size_t step = kWidth;; step += kWidth) {
+      Group group(ctrl_.get() + pos);
+      for (auto match = group.Match(H2(hash)); match; match.ClearLowest()) {
+        size_t index = (pos + match.Lowest()) & mask;
+        if (KeyEqual()(slots_[index].value.first, key))
+          return index;
+      }
+      if (group.MatchEmpty())
+        return kNotFound;
+      pos = (pos + step) & mask;
+    }
+  }
+
+  size_t FindInsertIndex(uint64_t hash) const {
+    size_t mask = capacity_ - 1;
+    size_t pos = H1(hash) & mask;
+    for (size_t step = kWidth;; step += kWidth) {
+      auto match = Group(ctrl_.get() + pos).MatchEmptyOrDeleted();
+      if (match)
+        return (pos + match.Lowest()) & mask;
+      pos = (pos + step) & mask;
+    }
+  }
+
+  template <typename K, typename... Args>
+  std::pair<iterator, bool> TryEmplace(K&& key, Args&&... args) {
+    uint64_t hash = HashOf(key);
+    size_t index = FindIndex(key, hash);
+    if (index != kNotFound)
+      return {MakeIterator(index, false), false};
+
+    index = PrepareInsert(hash);
+    new (&slots_[index].value)
+        value_type(std::piecewise_construct,
+                   std::forward_as_tuple(std::forward<K>(key)),
+                   std::forward_as_tuple(std::forward<Args>(args)...));
+    return {MakeIterator(index, false), true};
+  }
+
+  size_t PrepareInsert(uint64_t hash) {
+    if (!capacity_)
+      Resize(kWidth);
+    size_t index = FindInsertIndex(hash);
+    if (growth_left_ == 0 && ctrl_[index] != internal::kDeleted) {
+      // Grows if more than half full. Otherwise there are enough deleted slots
+      // to reclaim by rehashing in place.
+      Resize(CapacityFor(size_ * 2));
+      index = FindInsertIndex(hash);
+    }
+    if (ctrl_[index] == internal::kEmpty)
+      --growth_left_;
+    SetCtrl(index, H2(hash));
+    ++size_;
+    return index;
+  }
+
+  void EraseIndex(size_t index) {
+    slots_[index].value.~value_type();
+    SetCtrl(index, internal::kDeleted);
+    --size_;
+  }
+
+  void SetCtrl(size_t index, internal::ControlByte h2) {
+    ctrl_[index] = h2;
+    if (index < kWidth)
+      ctrl_[capacity_ + index] = h2;
+  }
+
+  void Resize(size_t capacity) {
+    DCHECK(capacity >= kWidth && std::has_single_bit(capacity));
+    DCHECK(MaxLoad(capacity) >= size_);
+
+    auto old_ctrl = std::move(ctrl_);
+    auto old_slots = std::move(slots_);
+    size_t old_capacity = capacity_;
+
+    ctrl_ = std::make_unique<internal::ControlByte[]>(capacity + kWidth);
+    memset(ctrl_.get(), internal::kEmpty, capacity + kWidth);
+    slots_ = std::make_unique<Slot[]>(capacity);
+    capacity_ = capacity;
+    growth_left_ = MaxLoad(capacity) - size_;
+
+    for (size_t i = 0; i < old_capacity; ++i) {
+      if (old_ctrl[i] < 0)
+        continue;
+      value_type& value = old_slots[i].value;
+      uint64_t hash = HashOf(value.first);
+      size_t index = FindInsertIndex(hash);
+      SetCtrl(index, H2(hash));
+      new (&slots_[index].value) value_type(std::move(value));
+      value.~value_type();
+    }
+  }
+
+  void DestroySlots() {
+    for (size_t i = 0; i < capacity_; ++i) {
+      if (ctrl_[i] >= 0)
+        slots_[i].value.~value_type();
+    }
+  }
+
+  void Swap(FlatHashMap& other) {
+    std::swap(ctrl_, other.ctrl_);
+    std::swap(slots_, other.slots_);
+    std::swap(capacity_, other.capacity_);
+    std::swap(size_, other.size_);
+    std::swap(growth_left_, other.growth_left_);
+  }
+
+  FlatHashMap(const FlatHashMap&) = delete;
+  FlatHashMap& operator=(const FlatHashMap&) = delete;
+};
+
+}  // namespace base
+
+#endif  // BASE_FLAT_HASH_MAP_H
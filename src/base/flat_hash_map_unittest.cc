@@ -0,0 +1,211 @@
+#include "base/flat_hash_map.h"
+
+#include <bit>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "base/random.h"
+#include "base/unittest.h"
+
+using namespace base;
+
+// Compares FlatHashMap with std::unordered_map under random operations. Build
+// with FLAT_HASH_MAP_NO_SIMD defined to run the map on the portable group.
+
+namespace {
+
+// Maps many keys to the same hash, so probe sequences get long and collide.
+struct CollidingHash {
+  size_t operator()(int key) const { return key % 7; }
+};
+
+// Counts live instances, so leaked or double-destroyed values are caught.
+struct Counted {
+  static inline int live = 0;
+
+  explicit Counted(int v = 0) : value(v) { ++live; }
+  Counted(const Counted& other) : value(other.value) { ++live; }
+  Counted(Counted&& other) noexcept : value(other.value) { ++live; }
+  Counted& operator=(const Counted&) = default;
+  ~Counted() { --live; }
+
+  int value;
+};
+
+template <typename Map>
+bool SameContents(const Map& map, const std::unordered_map<int, int>& ref) {
+  if (map.size() != ref.size())
+    return false;
+  size_t visited = 0;
+  for (const auto& [key, value] : map) {
+    auto it = ref.find(key);
+    if (it == ref.end() || it->second != value.value)
+      return false;
+    ++visited;
+  }
+  return visited == ref.size();
+}
+
+template <typename Hash>
+void RandomOps(unsigned seed) {
+  using Map = FlatHashMap<int, Counted, Hash>;
+  Random random(seed);
+  {
+    Map map;
+    std::unordered_map<int, int> ref;
+    for (int i = 0; i < 200000; ++i) {
+      // A small key range keeps erasing and reinserting the same keys, which
+      // fills the table with deleted slots.
+      int key = random.Roll(i < 100000 ? 300 : 5000);
+      int op = random.Roll(100);
+      if (op <= 40) {
+        auto [it, inserted] = map.try_emplace(key, i);
+        bool ref_inserted = ref.try_emplace(key, i).second;
+        EXPECT(inserted == ref_inserted) << "key: " << key;
+        EXPECT(it->first == key && it->second.value == ref[key]);
+      } else if (op <= 50) {
+        map[key].value = i;
+        ref[key] = i;
+      } else if (op <= 85) {
+        EXPECT(map.erase(key) == ref.erase(key)) << "key: " << key;
+      } else if (op <= 99) {
+        auto it = map.find(key);
+        auto ref_it = ref.find(key);
+        EXPECT((it == map.end()) == (ref_it == ref.end())) << "key: " << key;
+        if (it != map.end()) {
+          EXPECT(it->second.value == ref_it->second);
+        }
+        EXPECT(map.contains(key) == (ref_it != ref.end()));
+      } else if (i % 2) {
+        size_t capacity = map.capacity();
+        map.clear();
+        ref.clear();
+        EXPECT(map.empty() && map.capacity() == capacity);
+      } else {
+        map.reserve(ref.size() + random.Roll(1000));
+      }
+
+      if (i % 10000 == 0) {
+        EXPECT(SameContents(map, ref)) << "op: " << i;
+      }
+    }
+    EXPECT(SameContents(map, ref));
+    EXPECT(Counted::live == int(ref.size())) << Counted::live;
+  }
+  EXPECT(Counted::live == 0) << Counted::live;
+}
+
+template <typename Mask>
+uint64_t ToBits(Mask mask) {
+  uint64_t bits = 0;
+  for (; mask; mask.ClearLowest())
+    bits |= uint64_t{1} << mask.Lowest();
+  return bits;
+}
+
+template <typename Group>
+void GroupMatches(unsigned seed) {
+  Random random(seed);
+  for (int i = 0; i < 100000; ++i) {
+    internal::ControlByte ctrl[Group::kWidth];
+    for (auto& c : ctrl) {
+      int r = random.Roll(4);
+      c = r == 1   ? internal::kEmpty
+          : r == 2 ? internal::kDeleted
+                   : internal::ControlByte(random.Roll(8) - 1);
+    }
+    Group group(ctrl);
+    auto h2 = internal::ControlByte(random.Roll(8) - 1);
+
+    uint64_t expected = 0;
+    for (size_t j = 0; j < Group::kWidth; ++j)
+      expected |= uint64_t(ctrl[j] == h2) << j;
+    uint64_t match = ToBits(group.Match(h2));
+    // The portable group may report false positives above a true match.
+    uint64_t false_positives = match & ~expected;
+    EXPECT((match & expected) == expected) << "Missed a match.";
+    EXPECT(!false_positives ||
+           (expected && std::countr_zero(false_positives) >
+                            std::countr_zero(expected)))
+        << "False positive.";
+
+    uint64_t empty = 0, empty_or_deleted = 0;
+    for (size_t j = 0; j < Group::kWidth; ++j) {
+      empty |= uint64_t(ctrl[j] == internal::kEmpty) << j;
+      empty_or_deleted |= uint64_t(ctrl[j] < 0) << j;
+    }
+    EXPECT(ToBits(group.MatchEmpty()) == empty);
+    EXPECT(ToBits(group.MatchEmptyOrDeleted()) == empty_or_deleted);
+  }
+}
+
+}  // namespace
+
+TEST(FlatHashMap, RandomOps) {
+  RandomOps<std::hash<int>>(1);
+}
+
+TEST(FlatHashMap, RandomOpsCollidingHash) {
+  RandomOps<CollidingHash>(2);
+}
+
+TEST(FlatHashMap, EraseWhileIterating) {
+  FlatHashMap<int, int> map;
+  for (int i = 0; i < 1000; ++i)
+    map[i] = i;
+
+  std::vector<int> visits(1000, 0);
+  for (auto it = map.begin(); it != map.end();) {
+    ++visits[it->first];
+    if (it->first % 3 == 0)
+      it = map.erase(it);
+    else
+      ++it;
+  }
+  int wrong = 0;
+  for (int i = 0; i < 1000; ++i) {
+    if (visits[i] != 1 || map.contains(i) != (i % 3 != 0))
+      ++wrong;
+  }
+  EXPECT(wrong == 0) << wrong << " keys visited or erased wrongly.";
+  EXPECT(map.size() == 666) << map.size();
+}
+
+TEST(FlatHashMap, ReserveAndClear) {
+  FlatHashMap<int, int> map;
+  map.reserve(1000);
+  size_t capacity = map.capacity();
+  for (int i = 0; i < 1000; ++i)
+    map[i] = i;
+  EXPECT(map.capacity() == capacity) << "Grew after reserve.";
+
+  // Reserving less than the size keeps the contents and capacity.
+  map.reserve(10);
+  EXPECT(map.capacity() == capacity && map.size() == 1000);
+  EXPECT(map.find(999) != map.end() && map.find(999)->second == 999);
+
+  map.clear();
+  EXPECT(map.empty() && map.begin() == map.end());
+  EXPECT(!map.contains(1));
+  map[1] = 2;
+  EXPECT(map.size() == 1 && map[1] == 2);
+}
+
+TEST(FlatHashMap, HeterogeneousLookup) {
+  FlatHashMap<std::string, int, std::hash<std::string_view>, std::equal_to<>>
+      map;
+  map["one"] = 1;
+  map["two"] = 2;
+  EXPECT(map.contains(std::string_view("one")));
+  EXPECT(map.find(std::string_view("two"))->second == 2);
+  EXPECT(map.erase(std::string_view("one")) == 1);
+  EXPECT(!map.contains(std::string_view("one")));
+}
+
+TEST(FlatHashMap, GroupMatches) {
+  GroupMatches<internal::PortableGroup>(3);
+  GroupMatches<internal::Group>(4);
+}
@@ -0,0 +1,86 @@
+#include "base/frame_arena.h"
+
+#include <algorithm>
+
+#include "base/log.h"
+
+namespace base {
+
+namespace {
+
+// Blocks are cache line aligned. Bigger alignments are handled by padding.
+constexpr size_t kBlockAlignment = 64;
+
+}  // namespace
+
+FrameArena::FrameArena(size_t block_size) : block_size_(block_size) {}
+
+FrameArena::~FrameArena() = default;
+
+// static
+FrameArena& FrameArena::ForCurrentThread() {
+  static thread_local FrameArena arena;
+  return arena;
+}
+
+void FrameArena::Reset() {
+  peak_used_ = GetPeakBytesUsed();
+
+  // Merge the blocks so that the next frame fits in a single block.
+  if (blocks_.size() > 1) {
+    size_t total_size = GetCapacity();
+    blocks_.clear();
+    blocks_.push_back(
+        {AlignedMemPtr<uint8_t>(static_cast<uint8_t*>(
+             AlignedAlloc(total_size, kBlockAlignment))),
+         total_size});
+  }
+
+  block_ = 0;
+  offset_ = 0;
+  used_ = 0;
+}
+
+size_t FrameArena::GetPeakBytesUsed() const {
+  return std::max(peak_used_, used_);
+}
+
+size_t FrameArena::GetCapacity() const {
+  size_t capacity = 0;
+  for (auto& block : blocks_)
+    capacity += block.size;
+  return capacity;
+}
+
+void* FrameArena::AllocateSlow(size_t size, size_t alignment) {
+  DCHECK(IsPow2(alignment));
+
+  // Move on to the next block that is big enough. Blocks are left behind by
+  // Rewind.
+  size_t needed = size + alignment - 1;
+  for (++block_; block_ < blocks_.size(); ++block_) {
+    if (blocks_[block_].size >= needed)
+      break;
+  }
+
+  if (block_ >= blocks_.size()) {
+    size_t block_size = std::max(block_size_, needed);
+    blocks_.push_back(
+        {AlignedMemPtr<uint8_t>(static_cast<uint8_t*>(
+             AlignedAlloc(block_size, kBlockAlignment))),
+         block_size});
+    block_ = blocks_.size() - 1;
+  }
+
+  offset_ = 0;
+  return Allocate(size, alignment);
+}
+
+void FrameArena::Rewind(size_t block, size_t offset, size_t used) {
+  peak_used_ = GetPeakBytesUsed();
+  block_ = block;
+  offset_ = offset;
+  used_ = used;
+}
+
+}  // namespace base
@@ -0,0 +1,113 @@
+#ifndef BASE_FRAME_ARENA_H
+#define BASE_FRAME_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+#include "base/mem.h"
+
+namespace base {
+
+// Bump allocator for transient data that doesn't outlive a frame. Allocation
+// is a pointer increment, deallocation is a no-op and Reset() releases
+// everything at once. Memory is carved out of blocks that are kept across
+// resets. If a frame spills into multiple blocks, they are merged into one big
+// enough for the whole frame on the next reset.
+// It's a std::pmr::memory_resource, so it can back std::pmr containers, e.g.
+//   std::pmr::vector<int> v(&FrameArena::ForCurrentThread());
+// Not thread-safe. Each thread has its own arena. The main thread's arena is
+// reset by the engine at the beginning of Update and Draw. ThreadPool rewinds
+// the arena of the worker thread after each task.
+class FrameArena : public std::pmr::memory_resource {
+ public:
+  static constexpr size_t kDefaultBlockSize = 64 * 1024;
+
+  // Rewinds the arena to where it was on construction.
+  class Scope {
+   public:
+    explicit Scope(FrameArena& arena)
+        : arena_(arena),
+          block_(arena.block_),
+          offset_(arena.offset_),
+          used_(arena.used_) {}
+    ~Scope() { arena_.Rewind(block_, offset_, used_); }
+
+   private:
+    FrameArena& arena_;
+    size_t block_;
+    size_t offset_;
+    size_t used_;
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+  };
+
+  explicit FrameArena(size_t block_size = kDefaultBlockSize);
+  ~FrameArena() override;
+
+  static FrameArena& ForCurrentThread();
+
+  void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t)) {
+    if (block_ < blocks_.size()) {
+      uintptr_t base = reinterpret_cast<uintptr_t>(blocks_[block_].data.get());
+      uintptr_t ptr = (base + offset_ + alignment - 1) & ~(alignment - 1);
+      if (ptr + size <= base + blocks_[block_].size) {
+        used_ += ptr + size - (base + offset_);
+        offset_ = ptr + size - base;
+        return reinterpret_cast<void*>(ptr);
+      }
+    }
+    return AllocateSlow(size, alignment);
+  }
+
+  template <typename T>
+  T* AllocateArray(size_t count) {
+    return static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+  }
+
+  // Invalidates all allocations.
+  void Reset();
+
+  // Bytes allocated since the last reset, including alignment padding.
+  size_t GetBytesUsed() const { return used_; }
+  // Highest GetBytesUsed() value seen since construction.
+  size_t GetPeakBytesUsed() const;
+  size_t GetCapacity() const;
+
+ private:
+  struct Block {
+    AlignedMemPtr<uint8_t> data;
+    size_t size;
+  };
+
+  std::vector<Block> blocks_;
+  size_t block_size_;
+  // Current block and offset into it.
+  size_t block_ = 0;
+  size_t offset_ = 0;
+
+  size_t used_ = 0;
+  size_t peak_used_ = 0;
+
+  void* AllocateSlow(size_t size, size_t alignment);
+  void Rewind(size_t block, size_t offset, size_t used);
+
+  // std::pmr::memory_resource implementation
+  void* do_allocate(size_t size, size_t alignment) final {
+    return Allocate(size, alignment);
+  }
+  void do_deallocate(void* ptr, size_t size, size_t alignment) final {}
+  bool do_is_equal(
+      const std::pmr::memory_resource& other) const noexcept final {
+    return this == &other;
+  }
+
+  FrameArena(const FrameArena&) = delete;
+  FrameArena& operator=(const FrameArena&) = delete;
+};
+
+}  // namespace base
+
+#endif  // BASE_FRAME_ARENA_H
@@ -0,0 +1,103 @@
+#ifndef BASE_LINKED_LIST_H
+#define BASE_LINKED_LIST_H
+
+#include "base/log.h"
+
+namespace base {
+
+template <typename T>
+class LinkedList;
+
+// Intrusive doubly-linked list. Insertion and removal are O(1) and don't
+// allocate. Elements derive from LinkNode<T> and can be in one list at a time.
+// e.g.
+//   class Foo : public LinkNode<Foo> { ... };
+//   LinkedList<Foo> list;
+//   list.Append(&foo);
+//   for (LinkNode<Foo>* node = list.head(); node != list.end();
+//        node = node->next()) {
+//     node->value()->Bar();
+//   }
+//   foo.RemoveFromList();
+// Removing the node that is being visited while iterating is not safe.
+template <typename T>
+class LinkNode {
+ public:
+  LinkNode() = default;
+  ~LinkNode() {
+    if (IsInList())
+      RemoveFromList();
+  }
+
+  LinkNode(const LinkNode&) = delete;
+  LinkNode& operator=(const LinkNode&) = delete;
+
+  void InsertBefore(LinkNode<T>* e) {
+    DCHECK(!IsInList());
+    next_ = e;
+    previous_ = e->previous_;
+    e->previous_->next_ = this;
+    e->previous_ = this;
+  }
+
+  void InsertAfter(LinkNode<T>* e) {
+    DCHECK(!IsInList());
+    next_ = e->next_;
+    previous_ = e;
+    e->next_->previous_ = this;
+    e->next_ = this;
+  }
+
+  void RemoveFromList() {
+    DCHECK(IsInList());
+    previous_->next_ = next_;
+    next_->previous_ = previous_;
+    next_ = nullptr;
+    previous_ = nullptr;
+  }
+
+  bool IsInList() const { return next_ != nullptr; }
+
+  LinkNode<T>* previous() const { return previous_; }
+  LinkNode<T>* next() const { return next_; }
+
+  T* value() { return static_cast<T*>(this); }
+  const T* value() const { return static_cast<const T*>(this); }
+
+ private:
+  friend class LinkedList<T>;
+
+  LinkNode<T>* previous_ = nullptr;
+  LinkNode<T>* next_ = nullptr;
+};
+
+template <typename T>
+class LinkedList {
+ public:
+  // The root node is a sentinel, i.e. the list is circular through it.
+  LinkedList() { root_.previous_ = root_.next_ = &root_; }
+  ~LinkedList() {
+    // Unlink the remaining nodes, so they don't point into a dead list.
+    while (!empty())
+      head()->RemoveFromList();
+    root_.previous_ = root_.next_ = nullptr;
+  }
+
+  LinkedList(const LinkedList&) = delete;
+  LinkedList& operator=(const LinkedList&) = delete;
+
+  void Append(LinkNode<T>* e) { e->InsertBefore(&root_); }
+
+  LinkNode<T>* head() const { return root_.next(); }
+  LinkNode<T>* tail() const { return root_.previous(); }
+  const LinkNode<T>* end() const { return &root_; }
+
+  bool empty() const { return head() == end(); }
+
+ private:
+  LinkNode<T> root_;
+};
+
+}  // namespace base
+
+#endif  // BASE_LINKED_LIST_H
@@ -8,8 +8,15 @@
 #else
 #include <cstdio>
 #endif
+#include <algorithm>
+#include <chrono>
 #include <cstdlib>
-#include <string>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <semaphore>
+#include <thread>
+#include <vector>
 
 namespace base {
 
@@ -17,6 +24,232 @@ namespace {
 
 int g_max_log_verbosity_level = 0;
 
+// Size of the ring buffer of each thread. Messages are truncated to a quarter
+// of it.
+constexpr size_t kRingSize = 64 * 1024;
+constexpr size_t kMaxMessageSize = kRingSize / 4;
+
+// How often the background thread wakes up to write the queued messages. It's
+// also woken up when a ring buffer is half full.
+constexpr auto kFlushInterval = std::chrono::milliseconds(10);
+
+struct RecordHeader {
+  // Size of the record including the header and padding. Records that only
+  // fill up the end of the buffer have kPaddingBit set.
+  uint32_t size;
+  int32_t verbosity_level;
+  int32_t line;
+  uint32_t message_size;
+  const char* file;
+};
+
+constexpr uint32_t kPaddingBit = 0x80000000;
+
+size_t AlignRecordSize(size_t size) {
+  return (size + alignof(RecordHeader) - 1) & ~(alignof(RecordHeader) - 1);
+}
+
+// Single producer single consumer ring buffer of log records. The owner thread
+// produces. The consumer is serialized by Logger::flush_lock_.
+class LogRing {
+ public:
+  // Returns false if there was not enough space.
+  bool Push(const char* file,
+            int line,
+            int verbosity_level,
+            const char* message,
+            size_t message_size) {
+    message_size = std::min(message_size, kMaxMessageSize);
+    size_t record_size = AlignRecordSize(sizeof(RecordHeader) + message_size);
+
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    size_t head = head_.load(std::memory_order_acquire);
+    size_t offset = tail % kRingSize;
+    size_t contiguous = kRingSize - offset;
+    size_t padding = contiguous < record_size ? contiguous : 0;
+    if (tail + padding + record_size - head > kRingSize)
+      return false;
+
+    if (padding) {
+      uint32_t padding_size = uint32_t(padding) | kPaddingBit;
+      memcpy(buffer_ + offset, &padding_size, sizeof(padding_size));
+      tail += padding;
+      offset = 0;
+    }
+
+    RecordHeader header = {uint32_t(record_size), verbosity_level, line,
+                           uint32_t(message_size), file};
+    memcpy(buffer_ + offset, &header, sizeof(header));
+    memcpy(buffer_ + offset + sizeof(header), message, message_size);
+    tail_.store(tail + record_size, std::memory_order_release);
+    return true;
+  }
+
+  // Calls write(header, message) for each queued record.
+  template <typename Writer>
+  void Consume(Writer write) {
+    size_t head = head_.load(std::memory_order_relaxed);
+    size_t tail = tail_.load(std::memory_order_acquire);
+    while (head != tail) {
+      size_t offset = head % kRingSize;
+      uint32_t size;
+      memcpy(&size, buffer_ + offset, sizeof(size));
+      if (!(size & kPaddingBit)) {
+        RecordHeader header;
+        memcpy(&header, buffer_ + offset, sizeof(header));
+        write(header, buffer_ + offset + sizeof(header));
+      }
+      head += size & ~kPaddingBit;
+    }
+    head_.store(head, std::memory_order_release);
+  }
+
+  bool IsHalfFull() const {
+    return tail_.load(std::memory_order_relaxed) -
+               head_.load(std::memory_order_relaxed) >=
+           kRingSize / 2;
+  }
+
+  bool Empty() const {
+    return head_.load(std::memory_order_acquire) ==
+           tail_.load(std::memory_order_acquire);
+  }
+
+  void Close() { closed_.store(true, std::memory_order_release); }
+  bool IsClosed() const { return closed_.load(std::memory_order_acquire); }
+
+  void AddDropped() { dropped_.fetch_add(1, std::memory_order_relaxed); }
+  size_t TakeDropped() {
+    return dropped_.exchange(0, std::memory_order_relaxed);
+  }
+
+ private:
+  alignas(64) std::atomic<size_t> head_{0};
+  alignas(64) std::atomic<size_t> tail_{0};
+  std::atomic<size_t> dropped_{0};
+  std::atomic<bool> closed_{false};
+  alignas(RecordHeader) char buffer_[kRingSize];
+};
+
+void WriteMessage(int verbosity_level,
+                  const char* file,
+                  int line,
+                  const char* message,
+                  size_t message_size) {
+  const char* filename = file;
+  for (const char* p = file; *p; ++p) {
+    if (*p == '/' || *p == '\\')
+      filename = p + 1;
+  }
+  int size = int(message_size);
+#if defined(__ANDROID__)
+  __android_log_print(ANDROID_LOG_ERROR, "kaliber", "%d [%s:%d] %.*s",
+                      verbosity_level, filename, line, size, message);
+#elif defined(_WIN32)
+  OutputDebugStringA(std::format("{} [{}:{}] {}\n", verbosity_level, filename,
+                                 line, std::string_view(message, size))
+                         .c_str());
+#else
+  printf("%d [%s:%d] %.*s\n", verbosity_level, filename, line, size, message);
+#endif
+}
+
+void FlushOutput() {
+#if !defined(__ANDROID__) && !defined(_WIN32)
+  fflush(stdout);
+#endif
+}
+
+// Owns the ring buffers of all threads and the background thread that writes
+// their messages. Intentionally never destroyed, threads may log during
+// shutdown.
+class Logger {
+ public:
+  static Logger& Get() {
+    static Logger* logger = new Logger;
+    return *logger;
+  }
+
+  LogRing* GetThreadLocalRing() {
+    // Registered on first use. Marked closed on thread exit and released by
+    // the background thread once drained.
+    struct RingOwner {
+      std::shared_ptr<LogRing> ring;
+      ~RingOwner() {
+        if (ring)
+          ring->Close();
+      }
+    };
+    static thread_local RingOwner owner;
+    if (!owner.ring)
+      owner.ring = Register();
+    return owner.ring.get();
+  }
+
+  // Doesn't block. Only the first call releases the semaphore until the
+  // background thread has been woken up, so it never exceeds its max.
+  void WakeUp() {
+    if (!wake_pending_.exchange(true, std::memory_order_acq_rel))
+      wake_up_.release();
+  }
+
+  void Flush() {
+    std::vector<std::shared_ptr<LogRing>> rings;
+    {
+      std::lock_guard<std::mutex> scoped_lock(rings_lock_);
+      rings = rings_;
+    }
+
+    std::lock_guard<std::mutex> scoped_lock(flush_lock_);
+    for (auto& ring : rings) {
+      ring->Consume([](const RecordHeader& header, const char* message) {
+        WriteMessage(header.verbosity_level, header.file, header.line, message,
+                     header.message_size);
+      });
+      if (size_t dropped = ring->TakeDropped()) {
+        std::string message =
+            std::to_string(dropped) + " log messages dropped";
+        WriteMessage(0, __FILE__, __LINE__, message.data(), message.size());
+      }
+    }
+    FlushOutput();
+
+    // Release the rings of the threads that are gone.
+    std::lock_guard<std::mutex> rings_scoped_lock(rings_lock_);
+    std::erase_if(rings_, [](const std::shared_ptr<LogRing>& ring) {
+      return ring->IsClosed() && ring->Empty();
+    });
+  }
+
+ private:
+  std::vector<std::shared_ptr<LogRing>> rings_;
+  std::mutex rings_lock_;
+  // Serializes consumers.
+  std::mutex flush_lock_;
+  std::binary_semaphore wake_up_{0};
+  std::atomic<bool> wake_pending_{false};
+
+  Logger() {
+    std::thread([this]() -> void {
+      for (;;) {
+        // Cleared before flushing, so that rings filling up during the flush
+        // wake us up again.
+        if (wake_up_.try_acquire_for(kFlushInterval))
+          wake_pending_.store(false, std::memory_order_release);
+        Flush();
+      }
+    }).detach();
+    std::atexit([]() -> void { Logger::Get().Flush(); });
+  }
+
+  std::shared_ptr<LogRing> Register() {
+    auto ring = std::make_shared<LogRing>();
+    std::lock_guard<std::mutex> scoped_lock(rings_lock_);
+    rings_.push_back(ring);
+    return ring;
+  }
+};
+
 }  // namespace
 
 // This is never instantiated, it's just used for EAT_STREAM_PARAMETERS to have
@@ -28,28 +261,58 @@ int GlobalMaxLogVerbosityLevel() {
   return g_max_log_verbosity_level;
 }
 
+void FlushLogs() {
+  Logger::Get().Flush();
+}
+
+bool LogRateLimiter::ShouldLog(double seconds) {
+  int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch())
+                    .count();
+  int64_t next_time = next_time_.load(std::memory_order_relaxed);
+  if (now < next_time)
+    return false;
+  // Only one thread wins if multiple threads log at the same time.
+  return next_time_.compare_exchange_strong(
+      next_time, now + int64_t(seconds * 1000000000.0),
+      std::memory_order_relaxed);
+}
+
+LogStreamBuf::LogStreamBuf() {
+  setp(buffer_, buffer_ + kInlineSize);
+}
+
+const char* LogStreamBuf::data() const {
+  return overflow_.empty() ? buffer_ : overflow_.data();
+}
+
+size_t LogStreamBuf::size() const {
+  return overflow_.empty() ? pptr() - pbase() : overflow_.size();
+}
+
+LogStreamBuf::int_type LogStreamBuf::overflow(int_type ch) {
+  // Move to the string and continue writing there.
+  if (overflow_.empty())
+    overflow_.assign(buffer_, pptr() - pbase());
+  if (ch != traits_type::eof())
+    overflow_.push_back(traits_type::to_char_type(ch));
+  setp(nullptr, nullptr);
+  return traits_type::not_eof(ch);
+}
+
 LogMessage::LogMessage(const char* file, int line, int verbosity_level)
-    : file_(file), line_(line), verbosity_level_(verbosity_level) {}
+    : file_(file),
+      line_(line),
+      verbosity_level_(verbosity_level),
+      stream_(&buffer_) {}
 
 LogMessage::~LogMessage() {
-  stream_ << std::endl;
-  std::string message(stream_.str());
-  std::string filename(file_);
-  size_t last_slash_pos = filename.find_last_of("\\/");
-  if (last_slash_pos != std::string::npos)
-    filename = filename.substr(last_slash_pos + 1);
-#if defined(__ANDROID__)
-  __android_log_print(ANDROID_LOG_ERROR, "kaliber", "%d [%s:%d] %s",
-                      verbosity_level_, filename.c_str(), line_,
-                      message.c_str());
-#elif defined(_WIN32)
-  OutputDebugStringA(
-      std::format("{} [{}:{}] {}", verbosity_level_, filename, line_, message)
-          .c_str());
-#else
-  printf("%d [%s:%d] %s", verbosity_level_, filename.c_str(), line_,
-         message.c_str());
-#endif
+  LogRing* ring = Logger::Get().GetThreadLocalRing();
+  if (!ring->Push(file_, line_, verbosity_level_, buffer_.data(),
+                  buffer_.size()))
+    ring->AddDropped();
+  if (ring->IsHalfFull())
+    Logger::Get().WakeUp();
 }
 
 // static
@@ -76,7 +339,13 @@ LogAbort LogAbort::NotReached(const char* file, int line) {
 LogAbort::LogAbort(LogMessage* log) : log_(log) {}
 
 LogAbort::~LogAbort() {
-  delete log_;
+  // Write the earlier messages first. The fatal message is written directly,
+  // it would be dropped if the ring buffer is full. log_ is intentionally
+  // leaked so that it's not queued too.
+  FlushLogs();
+  WriteMessage(log_->verbosity_level_, log_->file_, log_->line_,
+               log_->buffer_.data(), log_->buffer_.size());
+  FlushOutput();
   std::abort();
 }
 
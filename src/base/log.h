@@ -1,7 +1,12 @@
 #ifndef BASE_LOG_H
 #define BASE_LOG_H
 
-#include <sstream>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <streambuf>
+#include <string>
 
 // Adapted from Chromium's logging implementation.
 
@@ -11,6 +16,11 @@
 // CHECK(condition) terminates the process if the condition is false.
 // NOTREACHED annotates unreachable codepaths and terminates the process if
 // reached.
+// LOG_EVERY_N_SEC logs at most once in the given number of seconds per call
+// site. Suitable for hot and realtime paths.
+// Messages are queued in a per-thread ring buffer and written by a background
+// thread, so logging never blocks on I/O. Messages above the
+// MAX_LOG_VERBOSITY_LEVEL (if defined) are stripped at compile time.
 #define LOG(verbosity_level)      \
   LAZY_STREAM(                    \
       LOG_IS_ON(verbosity_level), \
@@ -19,6 +29,9 @@
   LAZY_STREAM(                                   \
       LOG_IS_ON(verbosity_level) && (condition), \
       ::base::LogMessage(__FILE__, __LINE__, verbosity_level).stream())
+#define LOG_EVERY_N_SEC(verbosity_level, seconds)                    \
+  LAZY_STREAM(LOG_IS_ON(verbosity_level) && LOG_RATE_LIMIT(seconds), \
+              ::base::LogMessage(__FILE__, __LINE__, verbosity_level).stream())
 #define CHECK(condition)                                              \
   LAZY_STREAM(!(condition),                                           \
               ::base::LogAbort::Check(__FILE__, __LINE__, #condition) \
@@ -38,6 +51,8 @@
   LAZY_STREAM(                                   \
       LOG_IS_ON(verbosity_level) && (condition), \
       ::base::LogMessage(__FILE__, __LINE__, verbosity_level).stream())
+#define DLOG_EVERY_N_SEC(verbosity_level, seconds) \
+  LOG_EVERY_N_SEC(verbosity_level, seconds)
 #define DCHECK(condition)                                              \
   LAZY_STREAM(!(condition),                                            \
               ::base::LogAbort::DCheck(__FILE__, __LINE__, #condition) \
@@ -47,6 +62,7 @@
 // "debug mode" logging is compiled away to nothing for release builds.
 #define DLOG(verbosity_level) EAT_STREAM_PARAMETERS
 #define DLOG_IF(verbosity_level, condition) EAT_STREAM_PARAMETERS
+#define DLOG_EVERY_N_SEC(verbosity_level, seconds) EAT_STREAM_PARAMETERS
 #define DCHECK(condition) EAT_STREAM_PARAMETERS
 #endif
 
@@ -55,6 +71,14 @@
 #define LAZY_STREAM(condition, stream) \
   !(condition) ? (void)0 : ::base::LogMessage::Voidify() & (stream)
 
+// Evaluates to true at most once in the given number of seconds. Each
+// expansion has its own limiter.
+#define LOG_RATE_LIMIT(seconds)                 \
+  ([]() -> ::base::LogRateLimiter& {            \
+    static ::base::LogRateLimiter rate_limiter; \
+    return rate_limiter;                        \
+  }().ShouldLog(seconds))
+
 // Avoid any pointless instructions to be emitted by the compiler.
 #define EAT_STREAM_PARAMETERS \
   LAZY_STREAM(false, *::base::LogMessage::swallow_stream)
@@ -71,6 +95,37 @@ namespace base {
 
 int GlobalMaxLogVerbosityLevel();
 
+// Writes the queued messages of all threads. Blocks until done.
+void FlushLogs();
+
+// Per call site state for LOG_EVERY_N_SEC.
+class LogRateLimiter {
+ public:
+  bool ShouldLog(double seconds);
+
+ private:
+  std::atomic<int64_t> next_time_{0};
+};
+
+// Stream buffer that formats into a fixed size buffer, so short messages don't
+// allocate. Spills over to a string for longer messages.
+class LogStreamBuf : public std::streambuf {
+ public:
+  static constexpr size_t kInlineSize = 256;
+
+  LogStreamBuf();
+
+  const char* data() const;
+  size_t size() const;
+
+ protected:
+  int_type overflow(int_type ch) override;
+
+ private:
+  char buffer_[kInlineSize];
+  std::string overflow_;
+};
+
 class LogMessage {
  public:
   class Voidify {
@@ -90,10 +145,13 @@ class LogMessage {
   static std::ostream* swallow_stream;
 
  protected:
+  friend class LogAbort;
+
   const char* file_;
   int line_;
   int verbosity_level_;
-  std::ostringstream stream_;
+  LogStreamBuf buffer_;
+  std::ostream stream_;
 };
 
 class LogAbort {
@@ -0,0 +1,89 @@
+#ifndef BASE_MPSC_QUEUE_H
+#define BASE_MPSC_QUEUE_H
+
+#include <atomic>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+#include "base/node_pool.h"
+
+namespace base {
+
+// Lock-free multi-producer single-consumer queue. Push can be called on any
+// thread and never blocks. Pop and Empty must only be called by one thread at a
+// time. Items are popped in the order of their Push.
+// Adapted from Dmitry Vyukov's MPSC node-based queue. The consumer always owns
+// a stub node whose item has already been popped. Nodes come from a NodePool
+// that is shared by all queues of the same type, so steady-state Push/Pop
+// doesn't allocate.
+template <typename T>
+class MpscQueue {
+  struct Node {
+    std::atomic<uint32_t> next{0};
+    alignas(T) unsigned char storage[sizeof(T)];
+
+    T* item() { return std::launder(reinterpret_cast<T*>(storage)); }
+  };
+
+  using Pool = internal::NodePool<Node>;
+
+ public:
+  MpscQueue() : head_(Pool::Acquire()), tail_(head_) {
+    GetNode(head_).next.store(0, std::memory_order_relaxed);
+  }
+
+  ~MpscQueue() {
+    for (;;) {
+      uint32_t next = GetNode(head_).next.load(std::memory_order_relaxed);
+      Pool::Release(head_);
+      if (!next)
+        break;
+      GetNode(next).item()->~T();
+      head_ = next;
+    }
+  }
+
+  void Push(T item) {
+    uint32_t index = Pool::Acquire();
+    Node& node = GetNode(index);
+    node.next.store(0, std::memory_order_relaxed);
+    new (node.storage) T(std::move(item));
+    uint32_t prev = tail_.exchange(index, std::memory_order_acq_rel);
+    // The consumer can't see the node until it's linked to prev. Pop may fail
+    // while a producer is between these two lines.
+    GetNode(prev).next.store(index, std::memory_order_release);
+  }
+
+  bool Pop(T& item) {
+    uint32_t next = GetNode(head_).next.load(std::memory_order_acquire);
+    if (!next)
+      return false;
+
+    // The next node becomes the stub.
+    T* next_item = GetNode(next).item();
+    item = std::move(*next_item);
+    next_item->~T();
+    Pool::Release(head_);
+    head_ = next;
+    return true;
+  }
+
+  bool Empty() const {
+    return !GetNode(head_).next.load(std::memory_order_acquire);
+  }
+
+ private:
+  // Consumer and producers work on different cache lines.
+  alignas(64) uint32_t head_;
+  alignas(64) std::atomic<uint32_t> tail_;
+
+  static Node& GetNode(uint32_t index) { return Pool::GetNode(index); }
+
+  MpscQueue(const MpscQueue<T>&) = delete;
+  MpscQueue<T>& operator=(const MpscQueue<T>&) = delete;
+};
+
+}  // namespace base
+
+#endif  // BASE_MPSC_QUEUE_H
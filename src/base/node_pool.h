@@ -0,0 +1,181 @@
+#ifndef BASE_NODE_POOL_H
+#define BASE_NODE_POOL_H
+
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <mutex>
+
+#include "base/log.h"
+
+namespace base {
+
+namespace internal {
+
+// Lock-free storage for the nodes of linked containers. Shared by all
+// containers with the same node type. Node must have a std::atomic<uint32_t>
+// next member.
+// Nodes are identified by 32 bit indices, 0 is null. Node memory is never
+// released to the system, so reading a node that was released by another thread
+// in the meantime is safe. Released nodes are recycled via a per-thread cache
+// backed by a lock-free free list. Steady-state Acquire/Release doesn't
+// allocate. The storage grows in chunks of doubling size, so the number of live
+// nodes is only limited by the 32 bit index space.
+template <typename Node>
+class NodePool {
+ public:
+  // Head of a list of nodes, in the form of an index paired with a version tag
+  // that changes on every modification, which protects against the ABA
+  // problem.
+  class TaggedHead {
+   public:
+    void Push(uint32_t first, uint32_t last) {
+      uint64_t head = head_.load(std::memory_order_relaxed);
+      uint64_t new_head;
+      do {
+        GetNode(last).next.store(Index(head), std::memory_order_relaxed);
+        new_head = Pack(first, Tag(head) + 1);
+      } while (!head_.compare_exchange_weak(head, new_head,
+                                            std::memory_order_release,
+                                            std::memory_order_relaxed));
+    }
+
+    uint32_t Pop() {
+      uint64_t head = head_.load(std::memory_order_acquire);
+      uint64_t new_head;
+      do {
+        if (!Index(head))
+          return 0;
+        // The node may have been popped and pushed again by another thread.
+        // The tag check in compare_exchange will fail in that case.
+        uint32_t next =
+            GetNode(Index(head)).next.load(std::memory_order_relaxed);
+        new_head = Pack(next, Tag(head) + 1);
+      } while (!head_.compare_exchange_weak(head, new_head,
+                                            std::memory_order_acquire,
+                                            std::memory_order_acquire));
+      return Index(head);
+    }
+
+    // Detaches the whole list and returns the index of the first node.
+    uint32_t PopAll() {
+      uint64_t head = head_.load(std::memory_order_acquire);
+      while (!head_.compare_exchange_weak(head, Pack(0, Tag(head) + 1),
+                                          std::memory_order_acquire,
+                                          std::memory_order_acquire))
+        ;
+      return Index(head);
+    }
+
+    bool Empty() const {
+      return !Index(head_.load(std::memory_order_relaxed));
+    }
+
+   private:
+    std::atomic<uint64_t> head_{0};
+
+    static uint64_t Pack(uint32_t index, uint32_t tag) {
+      return (uint64_t{tag} << 32) | index;
+    }
+    static uint32_t Index(uint64_t head) { return uint32_t(head); }
+    static uint32_t Tag(uint64_t head) { return uint32_t(head >> 32); }
+  };
+
+  static Node& GetNode(uint32_t index) { return GetPool().Get(index); }
+
+  // Returns a free node. The contents of the node are unspecified.
+  static uint32_t Acquire() { return GetCache().Acquire(); }
+
+  static void Release(uint32_t index) { GetCache().Release(index); }
+
+ private:
+  // Chunk i holds kChunkSize << i nodes. kMaxChunks chunks use up the 32 bit
+  // index space.
+  static constexpr uint32_t kChunkSize = 1024;
+  static constexpr uint32_t kMaxChunks = 22;
+
+  // Per-thread cache of free nodes. Returned to the pool on thread exit.
+  class NodeCache {
+   public:
+    static constexpr size_t kCapacity = 64;
+
+    ~NodeCache() {
+      if (count_)
+        Flush(count_);
+    }
+
+    uint32_t Acquire() {
+      if (count_)
+        return nodes_[--count_];
+      return GetPool().AcquireShared();
+    }
+
+    void Release(uint32_t index) {
+      if (count_ == kCapacity)
+        Flush(kCapacity / 2);
+      nodes_[count_++] = index;
+    }
+
+   private:
+    uint32_t nodes_[kCapacity];
+    size_t count_ = 0;
+
+    // Links the topmost nodes together and returns them to the pool at once.
+    void Flush(size_t count) {
+      uint32_t last = nodes_[count_ - count];
+      for (size_t i = count_ - count; i < count_ - 1; ++i) {
+        GetNode(nodes_[i + 1])
+            .next.store(nodes_[i], std::memory_order_relaxed);
+      }
+      GetPool().free_list_.Push(nodes_[count_ - 1], last);
+      count_ -= count;
+    }
+  };
+
+  std::atomic<Node*> chunks_[kMaxChunks] = {};
+  uint32_t num_chunks_ = 0;
+  uint32_t num_nodes_ = 0;
+  uint64_t capacity_ = 0;
+  std::mutex grow_lock_;
+  TaggedHead free_list_;
+
+  static NodePool& GetPool() {
+    // Intentionally never destroyed. Nodes may be returned by thread-local
+    // caches after static destructors have run.
+    static NodePool* pool = new NodePool;
+    return *pool;
+  }
+
+  static NodeCache& GetCache() {
+    static thread_local NodeCache cache;
+    return cache;
+  }
+
+  Node& Get(uint32_t index) {
+    --index;
+    uint32_t chunk = std::bit_width(index / kChunkSize + 1) - 1;
+    uint32_t offset = index - kChunkSize * ((1u << chunk) - 1);
+    return chunks_[chunk].load(std::memory_order_relaxed)[offset];
+  }
+
+  uint32_t AcquireShared() {
+    if (uint32_t index = free_list_.Pop())
+      return index;
+
+    // Slow path. Only taken until the pool grows big enough.
+    std::lock_guard<std::mutex> scoped_lock(grow_lock_);
+    if (num_nodes_ == capacity_) {
+      CHECK(num_chunks_ < kMaxChunks) << "Out of node indices.";
+      size_t size = size_t{kChunkSize} << num_chunks_;
+      chunks_[num_chunks_++].store(new Node[size], std::memory_order_release);
+      capacity_ += size;
+    }
+    return ++num_nodes_;
+  }
+};
+
+}  // namespace internal
+
+}  // namespace base
+
+#endif  // BASE_NODE_POOL_H
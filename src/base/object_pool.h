@@ -0,0 +1,195 @@
+#ifndef BASE_OBJECT_POOL_H
+#define BASE_OBJECT_POOL_H
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "base/log.h"
+#include "base/spinlock.h"
+
+namespace base {
+
+// Slab allocator for objects of type T. Objects are carved out of slabs that
+// hold many objects each, so they are packed together in memory and their
+// addresses are stable for their lifetime. Acquiring and releasing is O(1) via
+// an intrusive free list. Memory is returned to the system when the pool is
+// destroyed. All objects must be deleted by then. Not thread-safe.
+template <typename T>
+class ObjectPool {
+ public:
+  // Slabs are sized to hold at least this many objects.
+  static constexpr size_t kMinObjectsPerSlab = 8;
+  static constexpr size_t kTargetSlabSize = 64 * 1024;
+
+  ObjectPool() = default;
+  ~ObjectPool() {
+    DCHECK(live_count_ == 0) << live_count_ << " objects leaked";
+  }
+
+  template <typename... Args>
+  T* New(Args&&... args) {
+    return new (Allocate()) T(std::forward<Args>(args)...);
+  }
+
+  void Delete(T* object) {
+    if (!object)
+      return;
+    object->~T();
+    Free(object);
+  }
+
+  // Allocates uninitialized storage for one object.
+  void* Allocate() {
+    if (!free_list_)
+      Grow();
+    Slot* slot = free_list_;
+    free_list_ = slot->next;
+    ++live_count_;
+    return slot;
+  }
+
+  void Free(void* storage) {
+    DCHECK(live_count_ > 0);
+    Slot* slot = static_cast<Slot*>(storage);
+    slot->next = free_list_;
+    free_list_ = slot;
+    --live_count_;
+  }
+
+  size_t GetLiveCount() const { return live_count_; }
+  size_t GetCapacity() const { return slabs_.size() * kObjectsPerSlab; }
+
+ private:
+  union Slot {
+    Slot* next;
+    alignas(T) unsigned char storage[sizeof(T)];
+  };
+
+  static constexpr size_t kObjectsPerSlab =
+      std::max(kMinObjectsPerSlab, kTargetSlabSize / sizeof(Slot));
+
+  std::vector<std::unique_ptr<Slot[]>> slabs_;
+  Slot* free_list_ = nullptr;
+  size_t live_count_ = 0;
+
+  void Grow() {
+    auto slab = std::make_unique<Slot[]>(kObjectsPerSlab);
+    // Link in reverse so that objects are handed out in address order.
+    for (size_t i = kObjectsPerSlab; i-- > 0;) {
+      slab[i].next = free_list_;
+      free_list_ = &slab[i];
+    }
+    slabs_.push_back(std::move(slab));
+  }
+
+  ObjectPool(const ObjectPool&) = delete;
+  ObjectPool& operator=(const ObjectPool&) = delete;
+};
+
+namespace internal {
+
+// Process-wide pool for objects of type T, shared by all threads. Each thread
+// keeps a small cache of free objects in front of the pool, so the lock is
+// taken once every kCapacity / 2 allocations in steady state.
+template <typename T>
+class SharedObjectPool {
+ public:
+  static void* Allocate() {
+    Cache& cache = GetCache();
+    if (cache.count == 0)
+      cache.Fill();
+    return cache.slots[--cache.count];
+  }
+
+  static void Free(void* storage) {
+    Cache& cache = GetCache();
+    if (cache.count == Cache::kCapacity)
+      cache.Flush(Cache::kCapacity / 2);
+    cache.slots[cache.count++] = storage;
+  }
+
+ private:
+  struct Pool {
+    ObjectPool<T> objects;
+    Spinlock lock;
+  };
+
+  // Free objects are returned to the pool on thread exit.
+  struct Cache {
+    static constexpr size_t kCapacity = 32;
+
+    void* slots[kCapacity];
+    size_t count = 0;
+
+    ~Cache() { Flush(count); }
+
+    void Fill() {
+      Pool& pool = GetPool();
+      std::lock_guard<Spinlock> scoped_lock(pool.lock);
+      for (; count < kCapacity / 2; ++count)
+        slots[count] = pool.objects.Allocate();
+    }
+
+    void Flush(size_t num_slots) {
+      Pool& pool = GetPool();
+      std::lock_guard<Spinlock> scoped_lock(pool.lock);
+      for (; num_slots > 0; --num_slots)
+        pool.objects.Free(slots[--count]);
+    }
+  };
+
+  static Pool& GetPool() {
+    // Intentionally never destroyed. Objects may be freed by thread-local
+    // caches after static destructors have run.
+    static Pool* pool = new Pool;
+    return *pool;
+  }
+
+  static Cache& GetCache() {
+    static thread_local Cache cache;
+    return cache;
+  }
+};
+
+}  // namespace internal
+
+// Allocator for node based containers such as std::list and std::map. Single
+// object allocations come from a process-wide slab pool per type, larger ones
+// from the heap. e.g.
+//   std::list<Foo, PoolAllocator<Foo>> foos;
+template <typename T>
+class PoolAllocator {
+ public:
+  using value_type = T;
+
+  PoolAllocator() = default;
+  template <typename U>
+  PoolAllocator(const PoolAllocator<U>&) {}
+
+  T* allocate(size_t n) {
+    if (n == 1)
+      return static_cast<T*>(internal::SharedObjectPool<T>::Allocate());
+    return static_cast<T*>(::operator new(n * sizeof(T)));
+  }
+
+  void deallocate(T* ptr, size_t n) {
+    if (n == 1)
+      internal::SharedObjectPool<T>::Free(ptr);
+    else
+      ::operator delete(ptr);
+  }
+
+  template <typename U>
+  bool operator==(const PoolAllocator<U>&) const {
+    return true;
+  }
+};
+
+}  // namespace base
+
+#endif  // BASE_OBJECT_POOL_H
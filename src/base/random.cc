@@ -0,0 +1,181 @@
+#include "base/random.h"
+
+#include <random>
+
+#include "base/vecmath_simd.h"
+
+namespace base {
+
+namespace {
+
+uint32_t RotateLeft(uint32_t x, int k) {
+  return (x << k) | (x >> (32 - k));
+}
+
+// Used for expanding the seed into the generator state, as recommended by the
+// xoshiro authors.
+uint64_t SplitMix64(uint64_t& x) {
+  uint64_t z = (x += 0x9e3779b97f4a7c15);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+  return z ^ (z >> 31);
+}
+
+#if defined(VECMATH_SSE2)
+
+using U32x4 = __m128i;
+
+U32x4 Load(const uint32_t* src) {
+  return _mm_load_si128(reinterpret_cast<const __m128i*>(src));
+}
+
+void Store(uint32_t* dst, U32x4 v) {
+  _mm_store_si128(reinterpret_cast<__m128i*>(dst), v);
+}
+
+U32x4 Add(U32x4 a, U32x4 b) {
+  return _mm_add_epi32(a, b);
+}
+
+U32x4 Xor(U32x4 a, U32x4 b) {
+  return _mm_xor_si128(a, b);
+}
+
+template <int k>
+U32x4 ShiftLeft(U32x4 x) {
+  return _mm_slli_epi32(x, k);
+}
+
+template <int k>
+U32x4 RotateLeft(U32x4 x) {
+  return _mm_or_si128(_mm_slli_epi32(x, k), _mm_srli_epi32(x, 32 - k));
+}
+
+void StoreFloats(float* dst, U32x4 x) {
+  __m128 f = _mm_cvtepi32_ps(_mm_srli_epi32(x, 8));
+  _mm_storeu_ps(dst, _mm_mul_ps(f, _mm_set1_ps(0x1.0p-24f)));
+}
+
+#elif defined(VECMATH_NEON)
+
+using U32x4 = uint32x4_t;
+
+U32x4 Load(const uint32_t* src) {
+  return vld1q_u32(src);
+}
+
+void Store(uint32_t* dst, U32x4 v) {
+  vst1q_u32(dst, v);
+}
+
+U32x4 Add(U32x4 a, U32x4 b) {
+  return vaddq_u32(a, b);
+}
+
+U32x4 Xor(U32x4 a, U32x4 b) {
+  return veorq_u32(a, b);
+}
+
+template <int k>
+U32x4 ShiftLeft(U32x4 x) {
+  return vshlq_n_u32(x, k);
+}
+
+template <int k>
+U32x4 RotateLeft(U32x4 x) {
+  return vsriq_n_u32(vshlq_n_u32(x, k), x, 32 - k);
+}
+
+void StoreFloats(float* dst, U32x4 x) {
+  float32x4_t f = vcvtq_f32_u32(vshrq_n_u32(x, 8));
+  vst1q_f32(dst, vmulq_n_f32(f, 0x1.0p-24f));
+}
+
+#endif
+
+}  // namespace
+
+Random::Random() {
+  std::random_device rd;
+  seed_ = rd();
+  Seed();
+}
+
+Random::Random(unsigned seed) : seed_(seed) {
+  Seed();
+}
+
+void Random::Fill(std::span<float> values) {
+  size_t i = 0;
+  for (; i < values.size() && index_ < kLanes; ++i)
+    values[i] = Rand();
+
+#if defined(VECMATH_SIMD)
+  if (i + kLanes <= values.size()) {
+    U32x4 s0 = Load(state_[0]);
+    U32x4 s1 = Load(state_[1]);
+    U32x4 s2 = Load(state_[2]);
+    U32x4 s3 = Load(state_[3]);
+    for (; i + kLanes <= values.size(); i += kLanes) {
+      StoreFloats(&values[i], Add(RotateLeft<7>(Add(s0, s3)), s0));
+      U32x4 t = ShiftLeft<9>(s1);
+      s2 = Xor(s2, s0);
+      s3 = Xor(s3, s1);
+      s1 = Xor(s1, s2);
+      s0 = Xor(s0, s3);
+      s2 = Xor(s2, t);
+      s3 = RotateLeft<11>(s3);
+    }
+    Store(state_[0], s0);
+    Store(state_[1], s1);
+    Store(state_[2], s2);
+    Store(state_[3], s3);
+  }
+#else
+  for (; i + kLanes <= values.size(); i += kLanes) {
+    Generate();
+    for (size_t j = 0; j < kLanes; ++j)
+      values[i + j] = ToFloat(buffer_[j]);
+    index_ = kLanes;
+  }
+#endif
+
+  for (; i < values.size(); ++i)
+    values[i] = Rand();
+}
+
+void Random::Seed() {
+  uint64_t x = seed_;
+  for (size_t i = 0; i < 4; ++i) {
+    for (size_t j = 0; j < kLanes; j += 2) {
+      uint64_t z = SplitMix64(x);
+      state_[i][j] = static_cast<uint32_t>(z);
+      state_[i][j + 1] = static_cast<uint32_t>(z >> 32);
+    }
+  }
+  index_ = kLanes;
+}
+
+void Random::Generate() {
+  for (size_t j = 0; j < kLanes; ++j) {
+    uint32_t s0 = state_[0][j];
+    uint32_t s1 = state_[1][j];
+    uint32_t s2 = state_[2][j];
+    uint32_t s3 = state_[3][j];
+    buffer_[j] = RotateLeft(s0 + s3, 7) + s0;
+    uint32_t t = s1 << 9;
+    s2 ^= s0;
+    s3 ^= s1;
+    s1 ^= s2;
+    s0 ^= s3;
+    s2 ^= t;
+    s3 = RotateLeft(s3, 11);
+    state_[0][j] = s0;
+    state_[1][j] = s1;
+    state_[2][j] = s2;
+    state_[3][j] = s3;
+  }
+  index_ = 0;
+}
+
+}  // namespace base
@@ -0,0 +1,115 @@
+#include "base/skyline_packer.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "base/log.h"
+
+namespace base {
+
+SkylinePacker::SkylinePacker(int width, int height)
+    : width_(width), height_(height) {
+  DCHECK(width > 0 && height > 0);
+  Reset();
+}
+
+SkylinePacker::~SkylinePacker() = default;
+
+bool SkylinePacker::Insert(int width, int height, int* x, int* y) {
+  DCHECK(width > 0 && height > 0);
+
+  // Find the lowest placement. Break ties by the narrowest segment to leave
+  // the wide ones for bigger rectangles.
+  size_t best_index = skyline_.size();
+  int best_top = std::numeric_limits<int>::max();
+  int best_width = std::numeric_limits<int>::max();
+  int best_y = 0;
+  for (size_t i = 0; i < skyline_.size(); ++i) {
+    int fit_y = Fit(i, width, height);
+    if (fit_y < 0)
+      continue;
+    int top = fit_y + height;
+    if (top < best_top ||
+        (top == best_top && skyline_[i].width < best_width)) {
+      best_index = i;
+      best_top = top;
+      best_width = skyline_[i].width;
+      best_y = fit_y;
+    }
+  }
+  if (best_index == skyline_.size())
+    return false;
+
+  *x = skyline_[best_index].x;
+  *y = best_y;
+  AddSegment(best_index, *x, best_y, width, height);
+  used_area_ += size_t(width) * height;
+  used_width_ = std::max(used_width_, *x + width);
+  used_height_ = std::max(used_height_, best_y + height);
+  return true;
+}
+
+void SkylinePacker::Reset() {
+  skyline_.clear();
+  skyline_.push_back({0, 0, width_});
+  used_area_ = 0;
+  used_width_ = 0;
+  used_height_ = 0;
+}
+
+float SkylinePacker::Occupancy() const {
+  return float(used_area_) / (float(width_) * height_);
+}
+
+int SkylinePacker::Fit(size_t index, int width, int height) const {
+  int x = skyline_[index].x;
+  if (x + width > width_)
+    return -1;
+
+  // The rectangle rests on the highest segment under it.
+  int y = 0;
+  int width_left = width;
+  for (size_t i = index; width_left > 0; ++i) {
+    DCHECK(i < skyline_.size());
+    y = std::max(y, skyline_[i].y);
+    if (y + height > height_)
+      return -1;
+    width_left -= skyline_[i].width;
+  }
+  return y;
+}
+
+void SkylinePacker::AddSegment(size_t index,
+                               int x,
+                               int y,
+                               int width,
+                               int height) {
+  skyline_.insert(skyline_.begin() + index, {x, y + height, width});
+
+  // Shrink or remove the segments now under the new one.
+  int right = x + width;
+  for (size_t i = index + 1; i < skyline_.size();) {
+    Segment& s = skyline_[i];
+    if (s.x >= right)
+      break;
+    int shrink = right - s.x;
+    if (shrink < s.width) {
+      s.x += shrink;
+      s.width -= shrink;
+      break;
+    }
+    skyline_.erase(skyline_.begin() + i);
+  }
+
+  // Merge neighbours at the same height.
+  for (size_t i = 0; i + 1 < skyline_.size();) {
+    if (skyline_[i].y == skyline_[i + 1].y) {
+      skyline_[i].width += skyline_[i + 1].width;
+      skyline_.erase(skyline_.begin() + i + 1);
+    } else {
+      ++i;
+    }
+  }
+}
+
+}  // namespace base
@@ -0,0 +1,58 @@
+#ifndef BASE_SKYLINE_PACKER_H
+#define BASE_SKYLINE_PACKER_H
+
+#include <cstddef>
+#include <vector>
+
+namespace base {
+
+// Packs rectangles into a fixed size bin using the skyline bottom-left
+// heuristic. The top edge of the packed area is kept as a list of horizontal
+// segments and each rectangle is placed where its top edge ends up lowest.
+// Fast and good enough for sprites, especially when the rectangles are
+// inserted in order of decreasing height.
+class SkylinePacker {
+ public:
+  SkylinePacker(int width, int height);
+  ~SkylinePacker();
+
+  // Returns false if the rectangle doesn't fit. Otherwise returns the position
+  // of its corner that is closest to the origin.
+  bool Insert(int width, int height, int* x, int* y);
+
+  void Reset();
+
+  int width() const { return width_; }
+  int height() const { return height_; }
+
+  // Bounds of the packed area.
+  int used_width() const { return used_width_; }
+  int used_height() const { return used_height_; }
+
+  // Ratio of the packed area to the bin area.
+  float Occupancy() const;
+
+ private:
+  struct Segment {
+    int x;
+    int y;
+    int width;
+  };
+
+  int width_;
+  int height_;
+  std::vector<Segment> skyline_;
+  size_t used_area_ = 0;
+  int used_width_ = 0;
+  int used_height_ = 0;
+
+  // Returns the y where a rectangle starting at the given segment would be
+  // placed, or -1 if it doesn't fit.
+  int Fit(size_t index, int width, int height) const;
+
+  void AddSegment(size_t index, int x, int y, int width, int height);
+};
+
+}  // namespace base
+
+#endif  // BASE_SKYLINE_PACKER_H
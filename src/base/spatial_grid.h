@@ -0,0 +1,308 @@
+#ifndef BASE_SPATIAL_GRID_H
+#define BASE_SPATIAL_GRID_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "base/collusion_test.h"
+#include "base/flat_hash_map.h"
+#include "base/log.h"
+#include "base/vecmath.h"
+
+namespace base {
+
+// Uniform hash grid for broadphase queries over axis-aligned boxes. Only
+// occupied cells are stored, so the world doesn't need to be bounded. Meant to
+// be cleared and refilled when the items move, e.g. once per tick.
+//   grid.Clear();
+//   for (auto& e : enemies)
+//     grid.Insert(&e, e.sprite.GetPosition(), e.sprite.GetSize());
+//   grid.QueryRadius(pos, radius, [&](Unit* e) -> bool {
+//     ...
+//     return true;
+//   });
+// Queries call fn once for every item that passes the exact test. Returning
+// false from fn stops the query. The cells are indexed on the first query
+// after an insertion. Cell size should be around the size of a typical item.
+template <typename T>
+class SpatialGrid {
+ public:
+  explicit SpatialGrid(float cell_size = 1) { SetCellSize(cell_size); }
+  ~SpatialGrid() = default;
+
+  // Also clears the grid.
+  void SetCellSize(float cell_size) {
+    DCHECK(cell_size > 0);
+    cell_size_ = cell_size;
+    inv_cell_size_ = 1 / cell_size;
+    Clear();
+  }
+
+  void Clear() {
+    items_.clear();
+    entries_.clear();
+    cells_.clear();
+    max_item_size_ = {0, 0};
+    indexed_ = true;
+  }
+
+  void Insert(const T& value, const Vector2f& center, const Vector2f& size) {
+    DCHECK(size.x >= 0 && size.y >= 0);
+
+    uint32_t index = static_cast<uint32_t>(items_.size());
+    items_.push_back({value, center, size, 0});
+
+    int32_t x0 = CellCoord(center.x - size.x / 2);
+    int32_t y0 = CellCoord(center.y - size.y / 2);
+    int32_t x1 = CellCoord(center.x + size.x / 2);
+    int32_t y1 = CellCoord(center.y + size.y / 2);
+    for (int32_t y = y0; y <= y1; ++y) {
+      for (int32_t x = x0; x <= x1; ++x)
+        entries_.push_back({CellKey(x, y), index});
+    }
+
+    if (index == 0) {
+      min_cell_x_ = x0;
+      min_cell_y_ = y0;
+      max_cell_x_ = x1;
+      max_cell_y_ = y1;
+    } else {
+      min_cell_x_ = std::min(min_cell_x_, x0);
+      min_cell_y_ = std::min(min_cell_y_, y0);
+      max_cell_x_ = std::max(max_cell_x_, x1);
+      max_cell_y_ = std::max(max_cell_y_, y1);
+    }
+    max_item_size_.x = std::max(max_item_size_.x, size.x);
+    max_item_size_.y = std::max(max_item_size_.y, size.y);
+    indexed_ = false;
+  }
+
+  // Items whose box overlaps the given box.
+  template <typename Fn>
+  void QueryBox(const Vector2f& center, const Vector2f& size, Fn fn) {
+    auto test = [&](const Item& item) -> bool {
+      return std::abs(item.center.x - center.x) * 2 < item.size.x + size.x &&
+             std::abs(item.center.y - center.y) * 2 < item.size.y + size.y;
+    };
+    QueryCells(center - size / 2, center + size / 2, test, fn);
+  }
+
+  // Items whose box overlaps the given circle.
+  template <typename Fn>
+  void QueryRadius(const Vector2f& center, float radius, Fn fn) {
+    auto test = [&](const Item& item) -> bool {
+      float dx = std::abs(item.center.x - center.x) - item.size.x / 2;
+      float dy = std::abs(item.center.y - center.y) - item.size.y / 2;
+      dx = std::max(dx, 0.0f);
+      dy = std::max(dy, 0.0f);
+      return dx * dx + dy * dy <= radius * radius;
+    };
+    Vector2f extent(radius, radius);
+    QueryCells(center - extent, center + extent, test, fn);
+  }
+
+  // Items whose box is hit by the ray, using the same test as Intersection()
+  // in collusion_test.h. Cells are visited in the order the ray crosses them,
+  // up to max_distance in units of dir's length. Items hit further away may be
+  // skipped.
+  template <typename Fn>
+  void QueryRay(const Vector2f& origin,
+                const Vector2f& dir,
+                float max_distance,
+                Fn fn) {
+    auto test = [&](const Item& item) -> bool {
+      return Intersection(item.center, item.size, origin, dir);
+    };
+
+    BeginQuery();
+    if (items_.empty())
+      return;
+
+    if (!std::isfinite(dir.x) || !std::isfinite(dir.y) ||
+        (dir.x == 0 && dir.y == 0)) {
+      // Degenerate direction. Can't walk the cells, so test every item.
+      for (Item& item : items_) {
+        if (test(item) && !fn(item.value))
+          return;
+      }
+      return;
+    }
+
+    // Clip the ray to the occupied cells.
+    Vector2f bounds_min(min_cell_x_ * cell_size_, min_cell_y_ * cell_size_);
+    Vector2f bounds_max((max_cell_x_ + 1) * cell_size_,
+                        (max_cell_y_ + 1) * cell_size_);
+    float t_enter = 0;
+    float t_exit = max_distance;
+    for (int i = 0; i < 2; ++i) {
+      if (dir[i] != 0) {
+        float t1 = (bounds_min[i] - origin[i]) / dir[i];
+        float t2 = (bounds_max[i] - origin[i]) / dir[i];
+        t_enter = std::max(t_enter, std::min(t1, t2));
+        t_exit = std::min(t_exit, std::max(t1, t2));
+      } else if (origin[i] < bounds_min[i] || origin[i] > bounds_max[i]) {
+        return;
+      }
+    }
+    if (t_enter > t_exit)
+      return;
+
+    // Walk the cells along the ray (Amanatides & Woo).
+    Vector2f start = origin + dir * t_enter;
+    int32_t x = std::clamp(CellCoord(start.x), min_cell_x_, max_cell_x_);
+    int32_t y = std::clamp(CellCoord(start.y), min_cell_y_, max_cell_y_);
+    int32_t step_x = dir.x > 0 ? 1 : (dir.x < 0 ? -1 : 0);
+    int32_t step_y = dir.y > 0 ? 1 : (dir.y < 0 ? -1 : 0);
+    constexpr float kInfinity = std::numeric_limits<float>::infinity();
+    float t_max_x = step_x
+                        ? ((x + (step_x > 0)) * cell_size_ - origin.x) / dir.x
+                        : kInfinity;
+    float t_max_y = step_y
+                        ? ((y + (step_y > 0)) * cell_size_ - origin.y) / dir.y
+                        : kInfinity;
+    float t_delta_x = step_x ? cell_size_ / std::abs(dir.x) : kInfinity;
+    float t_delta_y = step_y ? cell_size_ / std::abs(dir.y) : kInfinity;
+
+    while (x >= min_cell_x_ && x <= max_cell_x_ && y >= min_cell_y_ &&
+           y <= max_cell_y_) {
+      if (!VisitCell(x, y, test, fn))
+        return;
+      float t_next;
+      if (t_max_x < t_max_y) {
+        t_next = t_max_x;
+        x += step_x;
+        t_max_x += t_delta_x;
+      } else {
+        t_next = t_max_y;
+        y += step_y;
+        t_max_y += t_delta_y;
+      }
+      if (t_next > t_exit)
+        break;
+    }
+  }
+
+  size_t size() const { return items_.size(); }
+  bool empty() const { return items_.empty(); }
+
+  // Size of the largest item in each dimension. Useful for turning a query on
+  // item centers into a conservative query on boxes.
+  const Vector2f& max_item_size() const { return max_item_size_; }
+
+ private:
+  struct Item {
+    T value;
+    Vector2f center;
+    Vector2f size;
+    // Id of the last query that visited this item. Items that span multiple
+    // cells are tested only once per query.
+    uint32_t query_id;
+  };
+
+  // An item in a cell. Sorted by cell, so the items in a cell are contiguous.
+  struct Entry {
+    uint64_t cell;
+    uint32_t item;
+  };
+
+  // Range of entries in a cell.
+  struct Cell {
+    uint32_t begin;
+    uint32_t end;
+  };
+
+  float cell_size_ = 1;
+  float inv_cell_size_ = 1;
+
+  std::vector<Item> items_;
+  std::vector<Entry> entries_;
+  FlatHashMap<uint64_t, Cell> cells_;
+  bool indexed_ = true;
+  uint32_t query_id_ = 0;
+
+  int32_t min_cell_x_ = 0;
+  int32_t min_cell_y_ = 0;
+  int32_t max_cell_x_ = 0;
+  int32_t max_cell_y_ = 0;
+  Vector2f max_item_size_ = {0, 0};
+
+  static uint64_t CellKey(int32_t x, int32_t y) {
+    return (uint64_t(uint32_t(x)) << 32) | uint32_t(y);
+  }
+
+  int32_t CellCoord(float v) const {
+    return static_cast<int32_t>(std::floor(v * inv_cell_size_));
+  }
+
+  void BeginQuery() {
+    if (!indexed_)
+      Index();
+    if (++query_id_ == 0) {
+      for (Item& item : items_)
+        item.query_id = 0;
+      query_id_ = 1;
+    }
+  }
+
+  void Index() {
+    std::sort(entries_.begin(), entries_.end(),
+              [](const Entry& a, const Entry& b) {
+                return a.cell < b.cell || (a.cell == b.cell && a.item < b.item);
+              });
+    cells_.clear();
+    for (size_t begin = 0; begin < entries_.size();) {
+      uint64_t cell = entries_[begin].cell;
+      size_t end = begin + 1;
+      while (end < entries_.size() && entries_[end].cell == cell)
+        ++end;
+      cells_.try_emplace(cell, Cell{uint32_t(begin), uint32_t(end)});
+      begin = end;
+    }
+    indexed_ = true;
+  }
+
+  template <typename Test, typename Fn>
+  void QueryCells(const Vector2f& min,
+                  const Vector2f& max,
+                  Test& test,
+                  Fn& fn) {
+    BeginQuery();
+    if (items_.empty())
+      return;
+
+    int32_t x0 = std::max(CellCoord(min.x), min_cell_x_);
+    int32_t y0 = std::max(CellCoord(min.y), min_cell_y_);
+    int32_t x1 = std::min(CellCoord(max.x), max_cell_x_);
+    int32_t y1 = std::min(CellCoord(max.y), max_cell_y_);
+    for (int32_t y = y0; y <= y1; ++y) {
+      for (int32_t x = x0; x <= x1; ++x) {
+        if (!VisitCell(x, y, test, fn))
+          return;
+      }
+    }
+  }
+
+  // Returns false if fn stopped the query.
+  template <typename Test, typename Fn>
+  bool VisitCell(int32_t x, int32_t y, Test& test, Fn& fn) {
+    auto it = cells_.find(CellKey(x, y));
+    if (it == cells_.end())
+      return true;
+    for (uint32_t i = it->second.begin; i < it->second.end; ++i) {
+      Item& item = items_[entries_[i].item];
+      if (item.query_id == query_id_)
+        continue;
+      item.query_id = query_id_;
+      if (test(item) && !fn(item.value))
+        return false;
+    }
+    return true;
+  }
+};
+
+}  // namespace base
+
+#endif  // BASE_SPATIAL_GRID_H
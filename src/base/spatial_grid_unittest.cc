@@ -0,0 +1,183 @@
+#include "base/spatial_grid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "base/collusion_test.h"
+#include "base/random.h"
+#include "base/unittest.h"
+
+using namespace base;
+
+// Compares the grid queries with testing every item by brute force.
+
+namespace {
+
+struct Box {
+  Vector2f center;
+  Vector2f size;
+};
+
+enum class Query { kBox, kRadius, kRay };
+
+Vector2f RandomPoint(Random& random, float extent) {
+  return {Lerp(-extent, extent, random.Rand()),
+          Lerp(-extent, extent, random.Rand())};
+}
+
+Vector2f RandomSize(Random& random, float max_size) {
+  return {Lerp(0.0f, max_size, random.Rand()),
+          Lerp(0.0f, max_size, random.Rand())};
+}
+
+}  // namespace
+
+TEST(SpatialGrid, MatchesBruteForce) {
+  Random random(1);
+  for (int round = 0; round < 300; ++round) {
+    SpatialGrid<int> grid(round % 3 ? 5.0f : 13.0f);
+    std::vector<Box> boxes;
+    int count = random.Roll(200) - 1;
+    for (int i = 0; i < count; ++i) {
+      Box box = {RandomPoint(random, 50), RandomSize(random, 12)};
+      // Zero-size items.
+      if (i % 17 == 0)
+        box.size = {0, 0};
+      boxes.push_back(box);
+      grid.Insert(i, box.center, box.size);
+    }
+    EXPECT(grid.size() == size_t(count));
+
+    for (int q = 0; q < 100; ++q) {
+      // Some queries reach outside the occupied cells.
+      Vector2f center = RandomPoint(random, 65);
+      Vector2f size = RandomSize(random, 24);
+      float radius = Lerp(0.0f, 12.0f, random.Rand());
+      Vector2f dir(Lerp(-1.0f, 1.0f, random.Rand()),
+                   Lerp(-1.0f, 1.0f, random.Rand()));
+      // Axis-parallel and zero directions. Every third query is a ray.
+      if (q / 3 % 5 == 0)
+        dir.x = 0;
+      if (q / 3 % 7 == 0)
+        dir.y = 0;
+      float max_distance = q % 4 ? Lerp(0.0f, 100.0f, random.Rand()) : 1e30f;
+
+      std::vector<int> visits(count, 0);
+      auto fn = [&](int i) -> bool {
+        ++visits[i];
+        return true;
+      };
+      auto kind = static_cast<Query>(q % 3);
+      if (kind == Query::kBox)
+        grid.QueryBox(center, size, fn);
+      else if (kind == Query::kRadius)
+        grid.QueryRadius(center, radius, fn);
+      else
+        grid.QueryRay(center, dir, max_distance, fn);
+
+      int wrong = 0;
+      for (int i = 0; i < count; ++i) {
+        const Box& box = boxes[i];
+        // Items that may or may not be reported.
+        bool optional = false;
+        bool hit;
+        if (kind == Query::kBox) {
+          hit = std::abs(box.center.x - center.x) * 2 < box.size.x + size.x &&
+                std::abs(box.center.y - center.y) * 2 < box.size.y + size.y;
+        } else if (kind == Query::kRadius) {
+          float dx = std::abs(box.center.x - center.x) - box.size.x / 2;
+          float dy = std::abs(box.center.y - center.y) - box.size.y / 2;
+          dx = std::max(dx, 0.0f);
+          dy = std::max(dy, 0.0f);
+          hit = dx * dx + dy * dy <= radius * radius;
+        } else {
+          float distance = 0;
+          hit = Intersection(box.center, box.size, center, dir, &distance);
+          // Hits beyond max_distance may be skipped. Zero directions test
+          // every item.
+          optional = hit && distance > max_distance && (dir.x || dir.y);
+        }
+        // Items that span several cells are reported once.
+        if (visits[i] > 1 || (!optional && visits[i] != int(hit)))
+          ++wrong;
+      }
+      EXPECT(wrong == 0) << wrong << " wrong items. round: " << round
+                         << " query: " << q;
+    }
+
+    if (round % 5 == 0) {
+      grid.Clear();
+      EXPECT(grid.empty());
+      int visited = 0;
+      grid.QueryRadius({0, 0}, 100, [&](int) -> bool { return ++visited; });
+      EXPECT(visited == 0) << "Items left after Clear.";
+    }
+  }
+}
+
+TEST(SpatialGrid, EarlyStop) {
+  SpatialGrid<int> grid(4);
+  for (int i = 0; i < 100; ++i)
+    grid.Insert(i, {float(i % 10) * 3, float(i / 10) * 3}, {2, 2});
+
+  int visited = 0;
+  auto stop_at_3 = [&](int) -> bool { return ++visited < 3; };
+  grid.QueryBox({15, 15}, {100, 100}, stop_at_3);
+  EXPECT(visited == 3) << "QueryBox: " << visited;
+
+  visited = 0;
+  grid.QueryRadius({15, 15}, 100, stop_at_3);
+  EXPECT(visited == 3) << "QueryRadius: " << visited;
+
+  visited = 0;
+  grid.QueryRay({-10, 0.5f}, {1, 0}, 1e30f, stop_at_3);
+  EXPECT(visited == 3) << "QueryRay: " << visited;
+
+  visited = 0;
+  grid.QueryRay({0, 0}, {0, 0}, 1e30f, stop_at_3);
+  EXPECT(visited == 1) << "QueryRay with zero direction: " << visited;
+}
+
+TEST(SpatialGrid, RayOrder) {
+  // Cells are visited in the order the ray crosses them.
+  SpatialGrid<int> grid(1);
+  for (int i = 0; i < 10; ++i)
+    grid.Insert(i, {float(i) * 2 + 0.5f, 0.5f}, {0.5f, 0.5f});
+
+  std::vector<int> order;
+  grid.QueryRay({100, 0.5f}, {-1, 0}, 1e30f, [&](int i) -> bool {
+    order.push_back(i);
+    return true;
+  });
+  EXPECT(order.size() == 10) << order.size();
+  EXPECT(std::is_sorted(order.rbegin(), order.rend())) << "Out of order.";
+
+  // Stops walking the cells past max_distance. Item 2 starts at 4.25.
+  order.clear();
+  grid.QueryRay({-0.5f, 0.5f}, {1, 0}, 4, [&](int i) -> bool {
+    order.push_back(i);
+    return true;
+  });
+  EXPECT(order == std::vector<int>({0, 1}));
+}
+
+TEST(SpatialGrid, Clear) {
+  SpatialGrid<int> grid(2);
+  grid.Insert(1, {0, 0}, {1, 1});
+  grid.Insert(2, {10, 10}, {30, 1});
+  EXPECT(grid.max_item_size().x == 30);
+
+  grid.Clear();
+  EXPECT(grid.empty() && grid.max_item_size().x == 0);
+  int visited = 0;
+  auto count = [&](int) -> bool { return ++visited; };
+  grid.QueryBox({0, 0}, {100, 100}, count);
+  grid.QueryRay({-50, 0}, {1, 0}, 1e30f, count);
+  EXPECT(visited == 0);
+
+  // Usable again after Clear, including in cells used before.
+  grid.Insert(3, {0, 0}, {1, 1});
+  grid.QueryBox({0, 0}, {1, 1}, count);
+  EXPECT(visited == 1);
+}
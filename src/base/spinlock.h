@@ -31,6 +31,11 @@ class Spinlock {
     }
   }
 
+  bool try_lock() {
+    return !lock_.load(std::memory_order_relaxed) &&
+           !lock_.exchange(true, std::memory_order_acquire);
+  }
+
   void unlock() { lock_.store(false, std::memory_order_release); }
 
  private:
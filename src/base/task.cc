@@ -0,0 +1,67 @@
+#include "base/task.h"
+
+#include <new>
+
+#include "base/concurrent_stack.h"
+
+namespace base {
+
+namespace internal {
+
+namespace {
+
+// Frames are rounded up to a multiple of kSizeClassStep. Bigger frames are not
+// pooled.
+constexpr size_t kSizeClassStep = 64;
+constexpr size_t kNumSizeClasses = 16;
+
+// Free frames, indexed by size class. Frames are allocated and freed on any
+// thread.
+class FramePool {
+ public:
+  void* Allocate(size_t size_class) {
+    void* frame;
+    if (free_frames_[size_class].Pop(frame))
+      return frame;
+    return ::operator new((size_class + 1) * kSizeClassStep);
+  }
+
+  void Free(void* frame, size_t size_class) {
+    free_frames_[size_class].Push(frame);
+  }
+
+ private:
+  ConcurrentStack<void*> free_frames_[kNumSizeClasses];
+};
+
+FramePool& GetFramePool() {
+  // Intentionally never destroyed. Detached tasks may complete after static
+  // destructors have run.
+  static FramePool* pool = new FramePool;
+  return *pool;
+}
+
+size_t GetSizeClass(size_t size) {
+  return (size + kSizeClassStep - 1) / kSizeClassStep - 1;
+}
+
+}  // namespace
+
+void* AllocateCoroutineFrame(size_t size) {
+  size_t size_class = GetSizeClass(size);
+  if (size_class >= kNumSizeClasses)
+    return ::operator new(size);
+  return GetFramePool().Allocate(size_class);
+}
+
+void FreeCoroutineFrame(void* frame, size_t size) {
+  size_t size_class = GetSizeClass(size);
+  if (size_class >= kNumSizeClasses)
+    ::operator delete(frame);
+  else
+    GetFramePool().Free(frame, size_class);
+}
+
+}  // namespace internal
+
+}  // namespace base
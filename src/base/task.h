@@ -0,0 +1,349 @@
+#ifndef BASE_TASK_H
+#define BASE_TASK_H
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "base/closure.h"
+#include "base/task_runner.h"
+#include "base/thread_pool.h"
+
+namespace base {
+
+template <typename T>
+class Task;
+
+namespace internal {
+
+// Coroutine frames are recycled in size classes to avoid hitting the heap on
+// every call.
+void* AllocateCoroutineFrame(size_t size);
+void FreeCoroutineFrame(void* frame, size_t size);
+
+class PooledPromise {
+ public:
+  static void* operator new(size_t size) {
+    return AllocateCoroutineFrame(size);
+  }
+  static void operator delete(void* frame, size_t size) {
+    FreeCoroutineFrame(frame, size);
+  }
+};
+
+class PromiseBase : public PooledPromise {
+ public:
+  // Resumes the awaiting coroutine, if any, once the task is done. Destroys
+  // the coroutine frame of a detached task.
+  struct FinalAwaiter {
+    bool await_ready() noexcept { return false; }
+
+    template <typename Promise>
+    std::coroutine_handle<> await_suspend(
+        std::coroutine_handle<Promise> handle) noexcept {
+      PromiseBase& promise = handle.promise();
+      if (promise.continuation)
+        return promise.continuation;
+      if (promise.detached)
+        handle.destroy();
+      return std::noop_coroutine();
+    }
+
+    void await_resume() noexcept {}
+  };
+
+  // Tasks are lazy. They start once awaited or detached.
+  std::suspend_always initial_suspend() noexcept { return {}; }
+  FinalAwaiter final_suspend() noexcept { return {}; }
+
+  void unhandled_exception() { std::terminate(); }
+
+  std::coroutine_handle<> continuation;
+  bool detached = false;
+};
+
+template <typename T>
+class Promise : public PromiseBase {
+ public:
+  Task<T> get_return_object();
+
+  template <typename U>
+  void return_value(U&& value) {
+    result.emplace(std::forward<U>(value));
+  }
+
+  std::optional<T> result;
+};
+
+template <>
+class Promise<void> : public PromiseBase {
+ public:
+  Task<void> get_return_object();
+
+  void return_void() {}
+};
+
+}  // namespace internal
+
+// Lazily started coroutine that produces a value of type T. Awaiting a task
+// starts it and resumes the awaiting coroutine once it's done, on whichever
+// thread the task completed. Use SwitchToThreadPool and SwitchToTaskRunner to
+// hop between threads. e.g.
+//   Task<std::unique_ptr<Image>> LoadImage(std::string file_name) {
+//     auto main_thread = TaskRunner::GetThreadLocalTaskRunner();
+//     co_await SwitchToThreadPool(HERE);
+//     auto image = std::make_unique<Image>();
+//     image->Load(file_name);
+//     co_await SwitchToTaskRunner(HERE, main_thread);
+//     co_return image;
+//   }
+// A task that nobody awaits can be started with Detach().
+template <typename T = void>
+class [[nodiscard]] Task {
+ public:
+  using promise_type = internal::Promise<T>;
+
+  Task() = default;
+  Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+
+  ~Task() {
+    if (handle_)
+      handle_.destroy();
+  }
+
+  Task& operator=(Task&& other) noexcept {
+    if (this != &other) {
+      if (handle_)
+        handle_.destroy();
+      handle_ = std::exchange(other.handle_, {});
+    }
+    return *this;
+  }
+
+  // Starts the task without waiting for the result. The coroutine frame is
+  // destroyed once the task is done.
+  void Detach() && {
+    auto handle = std::exchange(handle_, {});
+    handle.promise().detached = true;
+    handle.resume();
+  }
+
+  bool IsValid() const { return !!handle_; }
+
+  // Awaitable interface.
+  bool await_ready() const noexcept { return false; }
+
+  std::coroutine_handle<> await_suspend(
+      std::coroutine_handle<> awaiting) noexcept {
+    handle_.promise().continuation = awaiting;
+    return handle_;
+  }
+
+  T await_resume() {
+    if constexpr (!std::is_void_v<T>)
+      return std::move(*handle_.promise().result);
+  }
+
+ private:
+  friend class internal::Promise<T>;
+
+  std::coroutine_handle<promise_type> handle_;
+
+  explicit Task(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+  Task(const Task&) = delete;
+  Task& operator=(const Task&) = delete;
+};
+
+namespace internal {
+
+template <typename T>
+Task<T> Promise<T>::get_return_object() {
+  return Task<T>(std::coroutine_handle<Promise<T>>::from_promise(*this));
+}
+
+inline Task<void> Promise<void>::get_return_object() {
+  return Task<void>(std::coroutine_handle<Promise<void>>::from_promise(*this));
+}
+
+class ThreadPoolAwaiter {
+ public:
+  explicit ThreadPoolAwaiter(Location from) : from_(from) {}
+
+  bool await_ready() const noexcept { return false; }
+
+  void await_suspend(std::coroutine_handle<> handle) {
+    ThreadPool::Get().PostTask(from_, [handle]() -> void { handle.resume(); });
+  }
+
+  void await_resume() noexcept {}
+
+ private:
+  Location from_;
+};
+
+class TaskRunnerAwaiter {
+ public:
+  TaskRunnerAwaiter(Location from, std::shared_ptr<TaskRunner> task_runner)
+      : from_(from), task_runner_(std::move(task_runner)) {}
+
+  bool await_ready() const noexcept { return false; }
+
+  void await_suspend(std::coroutine_handle<> handle) {
+    task_runner_->PostTask(from_, [handle]() -> void { handle.resume(); });
+  }
+
+  void await_resume() noexcept {}
+
+ private:
+  Location from_;
+  std::shared_ptr<TaskRunner> task_runner_;
+};
+
+// Shared between the helpers of a WhenAll call. The last one to complete
+// resumes the awaiting coroutine.
+struct WhenAllCounter {
+  std::atomic<size_t> count{0};
+  std::coroutine_handle<> awaiting;
+};
+
+// Coroutine that awaits a single task on behalf of WhenAll.
+class WhenAllHelper {
+ public:
+  class promise_type : public PooledPromise {
+   public:
+    struct FinalAwaiter {
+      bool await_ready() noexcept { return false; }
+
+      std::coroutine_handle<> await_suspend(
+          std::coroutine_handle<promise_type> handle) noexcept {
+        WhenAllCounter* counter = handle.promise().counter;
+        if (counter->count.fetch_sub(1, std::memory_order_acq_rel) == 1)
+          return counter->awaiting;
+        return std::noop_coroutine();
+      }
+
+      void await_resume() noexcept {}
+    };
+
+    WhenAllHelper get_return_object() {
+      return WhenAllHelper(
+          std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    FinalAwaiter final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+
+    WhenAllCounter* counter = nullptr;
+  };
+
+  WhenAllHelper(WhenAllHelper&& other) noexcept
+      : handle_(std::exchange(other.handle_, {})) {}
+
+  ~WhenAllHelper() {
+    if (handle_)
+      handle_.destroy();
+  }
+
+  void Start(WhenAllCounter* counter) {
+    handle_.promise().counter = counter;
+    handle_.resume();
+  }
+
+ private:
+  std::coroutine_handle<promise_type> handle_;
+
+  explicit WhenAllHelper(std::coroutine_handle<promise_type> handle)
+      : handle_(handle) {}
+
+  WhenAllHelper(const WhenAllHelper&) = delete;
+  WhenAllHelper& operator=(const WhenAllHelper&) = delete;
+};
+
+// Starts all helpers and suspends the awaiting coroutine until they are done.
+class WhenAllAwaiter {
+ public:
+  explicit WhenAllAwaiter(std::vector<WhenAllHelper>& helpers)
+      : helpers_(helpers) {}
+
+  bool await_ready() const noexcept { return helpers_.empty(); }
+
+  bool await_suspend(std::coroutine_handle<> awaiting) {
+    // The extra count keeps the helpers from resuming the awaiting coroutine
+    // before all of them are started.
+    counter_.awaiting = awaiting;
+    counter_.count.store(helpers_.size() + 1, std::memory_order_relaxed);
+    for (auto& helper : helpers_)
+      helper.Start(&counter_);
+    return counter_.count.fetch_sub(1, std::memory_order_acq_rel) != 1;
+  }
+
+  void await_resume() noexcept {}
+
+ private:
+  std::vector<WhenAllHelper>& helpers_;
+  WhenAllCounter counter_;
+};
+
+template <typename T>
+WhenAllHelper AwaitAndStore(Task<T>& task, std::optional<T>& result) {
+  result.emplace(co_await task);
+}
+
+inline WhenAllHelper Await(Task<void>& task) {
+  co_await task;
+}
+
+}  // namespace internal
+
+// Resumes the awaiting coroutine on a ThreadPool thread.
+inline internal::ThreadPoolAwaiter SwitchToThreadPool(Location from) {
+  return internal::ThreadPoolAwaiter(from);
+}
+
+// Resumes the awaiting coroutine on the thread that runs the given task runner.
+inline internal::TaskRunnerAwaiter SwitchToTaskRunner(
+    Location from,
+    std::shared_ptr<TaskRunner> task_runner) {
+  return internal::TaskRunnerAwaiter(from, std::move(task_runner));
+}
+
+// Runs the given tasks concurrently and returns their results in the same
+// order. The awaiting coroutine is resumed on the thread that completed the
+// last task.
+template <typename T>
+Task<std::vector<T>> WhenAll(std::vector<Task<T>> tasks) {
+  std::vector<std::optional<T>> results(tasks.size());
+  std::vector<internal::WhenAllHelper> helpers;
+  helpers.reserve(tasks.size());
+  for (size_t i = 0; i < tasks.size(); ++i)
+    helpers.push_back(internal::AwaitAndStore(tasks[i], results[i]));
+
+  co_await internal::WhenAllAwaiter(helpers);
+
+  std::vector<T> values;
+  values.reserve(results.size());
+  for (auto& result : results)
+    values.push_back(std::move(*result));
+  co_return values;
+}
+
+inline Task<void> WhenAll(std::vector<Task<void>> tasks) {
+  std::vector<internal::WhenAllHelper> helpers;
+  helpers.reserve(tasks.size());
+  for (auto& task : tasks)
+    helpers.push_back(internal::Await(task));
+
+  co_await internal::WhenAllAwaiter(helpers);
+}
+
+}  // namespace base
+
+#endif  // BASE_TASK_H
@@ -0,0 +1,80 @@
+#include "base/task_group.h"
+
+#include <algorithm>
+#include <thread>
+
+#include "base/log.h"
+#include "base/thread_pool.h"
+
+namespace base {
+
+void TaskGroup::Spawn(Location from, OnceClosure task) {
+  DCHECK(task) << LOCATION(from);
+
+  pending_tasks_.fetch_add(1, std::memory_order_relaxed);
+  ThreadPool::Get().PostTask(
+      from, [&, task = std::move(task)]() mutable -> void {
+        task();
+        pending_tasks_.fetch_sub(1, std::memory_order_release);
+      });
+}
+
+void TaskGroup::SpawnAndReply(Location from,
+                              OnceClosure task,
+                              OnceClosure reply) {
+  DCHECK(task) << LOCATION(from);
+  DCHECK(reply) << LOCATION(from);
+  DCHECK(TaskRunner::GetThreadLocalTaskRunner()) << LOCATION(from);
+
+  Spawn(from, internal::MakeReplyRelay(from, std::move(task), std::move(reply),
+                                       TaskRunner::GetThreadLocalTaskRunner(),
+                                       false));
+}
+
+void TaskGroup::Wait() {
+  Wait([]() -> void { std::this_thread::yield(); });
+}
+
+void TaskGroup::Wait(const std::function<void()>& idle) {
+  while (!IsDone()) {
+    // The remaining tasks may be running on other threads.
+    if (!ThreadPool::Get().RunPendingTask())
+      idle();
+  }
+}
+
+void ParallelFor(Location from,
+                 size_t begin,
+                 size_t end,
+                 size_t grain_size,
+                 const std::function<void(size_t, size_t)>& fn) {
+  if (begin >= end)
+    return;
+
+  grain_size = std::max(grain_size, size_t{1});
+  size_t num_chunks = (end - begin + grain_size - 1) / grain_size;
+
+  // Chunks are claimed dynamically so that threads that are done early take
+  // over more of the work.
+  std::atomic<size_t> next_chunk{0};
+  auto run_chunks = [&]() -> void {
+    for (;;) {
+      size_t chunk = next_chunk.fetch_add(1, std::memory_order_relaxed);
+      if (chunk >= num_chunks)
+        return;
+      size_t chunk_begin = begin + chunk * grain_size;
+      fn(chunk_begin, std::min(chunk_begin + grain_size, end));
+    }
+  };
+
+  TaskGroup task_group;
+  size_t num_helpers =
+      std::min(num_chunks - 1, ThreadPool::Get().GetConcurrency());
+  for (size_t i = 0; i < num_helpers; ++i)
+    task_group.Spawn(from, run_chunks);
+
+  run_chunks();
+  task_group.Wait();
+}
+
+}  // namespace base
@@ -0,0 +1,67 @@
+#ifndef BASE_TASK_GROUP_H
+#define BASE_TASK_GROUP_H
+
+#include <atomic>
+#include <functional>
+#include <memory>
+
+#include "base/closure.h"
+#include "base/task_runner.h"
+
+namespace base {
+
+// Runs a group of tasks on the ThreadPool and waits for them to complete. The
+// waiting thread runs pending pool tasks instead of blocking, so it's safe to
+// wait on a worker thread as well.
+// Spawn and Wait are expected to be called on the same thread. The group must
+// outlive the spawned tasks unless they are cancelled.
+class TaskGroup {
+ public:
+  TaskGroup() = default;
+  ~TaskGroup() = default;
+
+  void Spawn(Location from, OnceClosure task);
+
+  // The reply is posted to the TaskRunner of the calling thread once the task
+  // is done. Wait doesn't run replies.
+  void SpawnAndReply(Location from, OnceClosure task, OnceClosure reply);
+
+  template <typename ReturnType>
+  void SpawnAndReplyWithResult(Location from,
+                               OnceCallback<ReturnType()> task,
+                               OnceCallback<void(ReturnType)> reply) {
+    Spawn(from, internal::MakeReplyWithResultRelay(
+                    from, std::move(task), std::move(reply),
+                    TaskRunner::GetThreadLocalTaskRunner(), false));
+  }
+
+  // Blocks until all the spawned tasks have run. Helps the pool while waiting.
+  void Wait();
+
+  // Like Wait, but calls idle instead of yielding when there is no pool task to
+  // run, e.g. to keep processing platform events.
+  void Wait(const std::function<void()>& idle);
+
+  bool IsDone() const {
+    return pending_tasks_.load(std::memory_order_acquire) == 0;
+  }
+
+ private:
+  std::atomic<size_t> pending_tasks_{0};
+
+  TaskGroup(TaskGroup const&) = delete;
+  TaskGroup& operator=(TaskGroup const&) = delete;
+};
+
+// Splits [begin, end) into chunks of grain_size elements and calls
+// fn(chunk_begin, chunk_end) for each chunk on the ThreadPool. The calling
+// thread runs chunks as well. Returns when all chunks are done.
+void ParallelFor(Location from,
+                 size_t begin,
+                 size_t end,
+                 size_t grain_size,
+                 const std::function<void(size_t, size_t)>& fn);
+
+}  // namespace base
+
+#endif  // BASE_TASK_GROUP_H
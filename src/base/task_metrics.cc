@@ -0,0 +1,102 @@
+#include "base/task_metrics.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace base {
+
+void DurationHistogram::Add(internal::Clock::duration duration) {
+  auto us = std::chrono::duration_cast<std::chrono::microseconds>(duration);
+  uint64_t value = us.count() > 0 ? us.count() : 0;
+  int bucket = std::min<int>(std::bit_width(value), kNumBuckets - 1);
+  ++buckets_[bucket];
+
+  double seconds = std::chrono::duration<double>(duration).count();
+  ++count_;
+  sum_ += seconds;
+  max_ = std::max(max_, seconds);
+}
+
+double DurationHistogram::Percentile(double percentile) const {
+  if (!count_)
+    return 0;
+
+  uint64_t rank = uint64_t(count_ * percentile / 100.0 + 0.5);
+  uint64_t seen = 0;
+  for (int i = 0; i < kNumBuckets - 1; ++i) {
+    seen += buckets_[i];
+    if (seen >= rank)
+      return std::min(double(uint64_t{1} << i) / 1000000.0, max_);
+  }
+  return max_;
+}
+
+internal::Clock::time_point TaskMetrics::OnTaskPosted() {
+  if (!IsEnabled())
+    return {};
+
+  int64_t depth = queue_depth_.fetch_add(1, std::memory_order_relaxed) + 1;
+  int64_t max_depth = max_queue_depth_.load(std::memory_order_relaxed);
+  while (depth > max_depth &&
+         !max_queue_depth_.compare_exchange_weak(max_depth, depth,
+                                                 std::memory_order_relaxed))
+    ;
+  return internal::Clock::now();
+}
+
+void TaskMetrics::OnTaskRun(const Location& from,
+                            internal::Clock::time_point posted,
+                            internal::Clock::time_point started,
+                            internal::Clock::time_point finished) {
+  queue_depth_.fetch_sub(1, std::memory_order_relaxed);
+
+  std::lock_guard<std::mutex> scoped_lock(stats_lock_);
+  auto [it, inserted] =
+      stats_.try_emplace({from.file_name(), from.line()}, LocationStats{});
+  if (inserted)
+    it->second.location = from;
+  it->second.queue_time.Add(started - posted);
+  it->second.run_time.Add(finished - started);
+}
+
+void TaskMetrics::OnTaskDropped(internal::Clock::time_point posted) {
+  if (posted != internal::Clock::time_point())
+    queue_depth_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+std::vector<TaskMetrics::LocationStats> TaskMetrics::GetLocationStats() const {
+  std::vector<LocationStats> result;
+  {
+    std::lock_guard<std::mutex> scoped_lock(stats_lock_);
+    result.reserve(stats_.size());
+    for (auto& [key, stats] : stats_)
+      result.push_back(stats);
+  }
+  std::sort(result.begin(), result.end(),
+            [](const LocationStats& a, const LocationStats& b) {
+              return a.run_time.sum() > b.run_time.sum();
+            });
+  return result;
+}
+
+size_t TaskMetrics::GetQueueDepth() const {
+  return std::max<int64_t>(queue_depth_.load(std::memory_order_relaxed), 0);
+}
+
+size_t TaskMetrics::GetMaxQueueDepth() const {
+  return max_queue_depth_.load(std::memory_order_relaxed);
+}
+
+uint64_t TaskMetrics::GetContentionCount() const {
+  return contention_count_.load(std::memory_order_relaxed);
+}
+
+void TaskMetrics::Reset() {
+  std::lock_guard<std::mutex> scoped_lock(stats_lock_);
+  stats_.clear();
+  max_queue_depth_.store(queue_depth_.load(std::memory_order_relaxed),
+                         std::memory_order_relaxed);
+  contention_count_.store(0, std::memory_order_relaxed);
+}
+
+}  // namespace base
@@ -0,0 +1,124 @@
+#ifndef BASE_TASK_METRICS_H
+#define BASE_TASK_METRICS_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "base/closure.h"
+#include "base/delayed_task_queue.h"
+
+namespace base {
+
+// Histogram of durations with power-of-two buckets in microseconds. Bucket 0
+// counts durations below 1us, bucket i counts durations in [2^(i-1), 2^i) us.
+// The last bucket also counts anything longer.
+class DurationHistogram {
+ public:
+  static constexpr int kNumBuckets = 24;
+
+  void Add(internal::Clock::duration duration);
+
+  // Returns an estimate of the given percentile (0 to 100) in seconds, based on
+  // the upper bound of the bucket it falls into.
+  double Percentile(double percentile) const;
+
+  uint64_t count() const { return count_; }
+  // Sum, mean and max are in seconds.
+  double sum() const { return sum_; }
+  double mean() const { return count_ ? sum_ / count_ : 0; }
+  double max() const { return max_; }
+  const uint64_t* buckets() const { return buckets_; }
+
+ private:
+  uint64_t buckets_[kNumBuckets] = {};
+  uint64_t count_ = 0;
+  double sum_ = 0;
+  double max_ = 0;
+};
+
+// Opt-in scheduler instrumentation. Collects per-Location histograms of how
+// long tasks wait in the queue and how long they run, the number of queued
+// tasks and the number of times a queue lock was found locked.
+// Timestamps are only taken while enabled. Thread-safe.
+class TaskMetrics {
+ public:
+  struct LocationStats {
+    Location location;
+    DurationHistogram queue_time;
+    DurationHistogram run_time;
+  };
+
+  TaskMetrics() = default;
+  ~TaskMetrics() = default;
+
+  void SetEnabled(bool enabled) {
+    enabled_.store(enabled, std::memory_order_relaxed);
+  }
+  bool IsEnabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+  // Returns the time the task was posted, or a default constructed time_point
+  // if disabled. The value is to be passed to OnTaskRun or OnTaskDropped.
+  internal::Clock::time_point OnTaskPosted();
+
+  void OnTaskRun(const Location& from,
+                 internal::Clock::time_point posted,
+                 internal::Clock::time_point started,
+                 internal::Clock::time_point finished);
+
+  void OnTaskDropped(internal::Clock::time_point posted);
+
+  // Locks the given lock. Counts it as contention if the lock is not
+  // immediately available.
+  template <typename Lockable>
+  void Lock(Lockable& lock) {
+    if (!lock.try_lock()) {
+      contention_count_.fetch_add(1, std::memory_order_relaxed);
+      lock.lock();
+    }
+  }
+
+  // Returns the stats sorted by total run time, highest first.
+  std::vector<LocationStats> GetLocationStats() const;
+
+  // Number of tasks that are posted while enabled and not run yet.
+  size_t GetQueueDepth() const;
+  size_t GetMaxQueueDepth() const;
+  uint64_t GetContentionCount() const;
+
+  void Reset();
+
+ private:
+  struct LocationKey {
+    const char* file_name;
+    int line;
+
+    bool operator==(const LocationKey& other) const = default;
+  };
+
+  struct LocationKeyHash {
+    size_t operator()(const LocationKey& key) const {
+      return std::hash<const void*>()(key.file_name) ^
+             std::hash<int>()(key.line);
+    }
+  };
+
+  std::atomic<bool> enabled_{false};
+
+  std::unordered_map<LocationKey, LocationStats, LocationKeyHash> stats_;
+  mutable std::mutex stats_lock_;
+
+  std::atomic<int64_t> queue_depth_{0};
+  std::atomic<int64_t> max_queue_depth_{0};
+  std::atomic<uint64_t> contention_count_{0};
+
+  TaskMetrics(TaskMetrics const&) = delete;
+  TaskMetrics& operator=(TaskMetrics const&) = delete;
+};
+
+}  // namespace base
+
+#endif  // BASE_TASK_METRICS_H
@@ -3,24 +3,10 @@
 #include <thread>
 
 #include "base/log.h"
+#include "base/trace.h"
 
 namespace base {
 
-namespace {
-
-void PostTaskAndReplyRelay(Location from,
-                           Closure task_cb,
-                           Closure reply_cb,
-                           std::shared_ptr<TaskRunner> destination,
-                           bool front) {
-  task_cb();
-
-  if (reply_cb)
-    destination->PostTask(from, std::move(reply_cb), front);
-}
-
-}  // namespace
-
 // The task runner that belongs to the thread it's created in. Tasks to be run
 // on a specific thread can be posted to this task runner.
 // TaskRunner::GetThreadLocalTaskRunner()->RunTasks() is expected to be
@@ -37,34 +23,63 @@ std::shared_ptr<TaskRunner> TaskRunner::GetThreadLocalTaskRunner() {
   return thread_local_task_runner;
 }
 
-void TaskRunner::PostTask(Location from, Closure task, bool front) {
+void TaskRunner::PostTask(Location from, OnceClosure task, bool front) {
   DCHECK(task) << LOCATION(from);
 
+  auto posted = metrics_.OnTaskPosted();
   task_count_.fetch_add(1, std::memory_order_relaxed);
-  std::lock_guard<std::mutex> scoped_lock(lock_);
   if (front)
-    queue_.emplace_front(from, std::move(task));
+    front_queue_.Push({from, std::move(task), posted});
   else
-    queue_.emplace_back(from, std::move(task));
+    queue_.Push({from, std::move(task), posted});
 }
 
 void TaskRunner::PostTaskAndReply(Location from,
-                                  Closure task,
-                                  Closure reply,
+                                  OnceClosure task,
+                                  OnceClosure reply,
                                   bool front) {
   DCHECK(task) << LOCATION(from);
   DCHECK(reply) << LOCATION(from);
   DCHECK(thread_local_task_runner) << LOCATION(from);
 
-  auto relay = std::bind(PostTaskAndReplyRelay, from, std::move(task),
-                         std::move(reply), thread_local_task_runner, front);
-  PostTask(from, std::move(relay), front);
+  PostTask(from,
+           internal::MakeReplyRelay(from, std::move(task), std::move(reply),
+                                    thread_local_task_runner, front),
+           front);
+}
+
+void TaskRunner::PostDelayedTask(Location from,
+                                 OnceClosure task,
+                                 double delay) {
+  DCHECK(task) << LOCATION(from);
+
+  delayed_queue_.Push(
+      {internal::DeadlineFromNow(delay), from, std::move(task)});
+}
+
+void TaskRunner::PostRepeatingTask(Location from,
+                                   std::function<bool()> task,
+                                   double interval) {
+  DCHECK(task) << LOCATION(from);
+
+  PostDelayedTask(from,
+                  internal::RepeatingTaskRelay<TaskRunner>(
+                      from, std::move(task), interval, this),
+                  interval);
 }
 
 void TaskRunner::CancelTasks() {
-  std::lock_guard<std::mutex> scoped_lock(lock_);
-  task_count_.fetch_sub(queue_.size(), std::memory_order_release);
-  queue_.clear();
+  std::lock_guard<std::mutex> scoped_lock(consumer_lock_);
+  Task task;
+  while (PopTask(task)) {
+    metrics_.OnTaskDropped(std::get<2>(task));
+    task_count_.fetch_sub(1, std::memory_order_release);
+  }
+
+  internal::DelayedTask delayed_task;
+  while (delayed_queue_.Pop(delayed_task))
+    ;
+  delayed_tasks_.Clear();
 }
 
 void TaskRunner::WaitForCompletion() {
@@ -74,73 +89,116 @@ void TaskRunner::WaitForCompletion() {
 
 template <>
 void TaskRunner::RunTasks<Consumer::Multi>() {
+  TRACE_SCOPE("TaskRunner::RunTasks");
+
+  {
+    std::lock_guard<std::mutex> scoped_lock(consumer_lock_);
+    ScheduleDelayedTasks();
+  }
+
   for (;;) {
     Task task;
     {
-      std::lock_guard<std::mutex> scoped_lock(lock_);
-      if (queue_.empty())
+      metrics_.Lock(consumer_lock_);
+      std::lock_guard<std::mutex> scoped_lock(consumer_lock_, std::adopt_lock);
+      if (!PopTask(task))
         return;
-      task.swap(queue_.front());
-      queue_.pop_front();
     }
 
-    auto [from, task_cb] = task;
-
-#if 0
-    LOG(0) << __func__ << " from: " << LOCATION(from);
-#endif
-
-    task_cb();
-    task_count_.fetch_sub(1, std::memory_order_release);
+    RunTask(task);
   }
 }
 
 template <>
 void TaskRunner::RunTasks<Consumer::Single>() {
-  std::deque<Task> queue;
-  {
-    std::lock_guard<std::mutex> scoped_lock(lock_);
-    if (queue_.empty())
-      return;
-    queue.swap(queue_);
-  }
+  TRACE_SCOPE("TaskRunner::RunTasks");
 
-  while (!queue.empty()) {
-    auto [from, task_cb] = queue.front();
-    queue.pop_front();
+  ScheduleDelayedTasks();
 
-#if 0
-    LOG << __func__ << " from: " << LOCATION(from);
-#endif
+  // Run only the tasks that are already posted. Tasks posted in the meantime
+  // are run in the next call.
+  for (size_t count = task_count_.load(std::memory_order_acquire); count > 0;
+       --count) {
+    Task task;
+    if (!PopTask(task))
+      return;
 
-    task_cb();
-    task_count_.fetch_sub(1, std::memory_order_release);
+    RunTask(task);
   }
 }
 
 template <>
 void TaskRunner::RunTasks<Consumer::NoBlocking>() {
-  std::deque<Task> queue;
-  {
-    std::unique_lock<std::mutex> scoped_lock(lock_, std::try_to_lock);
-    if (scoped_lock) {
-      if (queue_.empty())
-        return;
-      queue.swap(queue_);
-    }
+  std::unique_lock<std::mutex> scoped_lock(consumer_lock_, std::try_to_lock);
+  if (!scoped_lock)
+    return;
+
+  TRACE_SCOPE("TaskRunner::RunTasks");
+  ScheduleDelayedTasks();
+
+  for (size_t count = task_count_.load(std::memory_order_acquire); count > 0;
+       --count) {
+    Task task;
+    if (!PopTask(task))
+      return;
+
+    RunTask(task);
   }
+}
+
+void TaskRunner::ScheduleDelayedTasks() {
+  internal::DelayedTask delayed_task;
+  while (delayed_queue_.Pop(delayed_task))
+    delayed_tasks_.Push(std::move(delayed_task));
 
-  while (!queue.empty()) {
-    auto [from, task_cb] = queue.front();
-    queue.pop_front();
+  if (delayed_tasks_.Empty())
+    return;
+
+  auto now = internal::Clock::now();
+  while (delayed_tasks_.PopDue(now, delayed_task))
+    PostTask(delayed_task.from, std::move(delayed_task.task));
+}
+
+bool TaskRunner::PopTask(Task& task) {
+  return front_queue_.Pop(task) || queue_.Pop(task);
+}
+
+void TaskRunner::RunTask(Task& task) {
+  auto& [from, task_cb, posted] = task;
+
+  // Tasks are named after the function they were posted from.
+  TRACE_SCOPE(from.function_name());
 
 #if 0
-    LOG << __func__ << " from: " << LOCATION(from);
+  LOG(0) << __func__ << " from: " << LOCATION(from);
 #endif
 
+  if (posted == internal::Clock::time_point()) {
     task_cb();
-    task_count_.fetch_sub(1, std::memory_order_release);
+  } else {
+    auto started = internal::Clock::now();
+    task_cb();
+    metrics_.OnTaskRun(from, posted, started, internal::Clock::now());
   }
+  task_count_.fetch_sub(1, std::memory_order_release);
 }
 
+namespace internal {
+
+OnceClosure MakeReplyRelay(Location from,
+                           OnceClosure task,
+                           OnceClosure reply,
+                           std::shared_ptr<TaskRunner> destination,
+                           bool front) {
+  return [from, task = std::move(task), reply = std::move(reply),
+          destination = std::move(destination), front]() mutable -> void {
+    task();
+
+    if (reply)
+      destination->PostTask(from, std::move(reply), front);
+  };
+}
+
+}  // namespace internal
+
 }  // namespace base
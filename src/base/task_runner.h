@@ -2,49 +2,36 @@
 #define BASE_TASK_RUNNER_H
 
 #include <atomic>
-#include <deque>
 #include <memory>
 #include <mutex>
 #include <tuple>
 
 #include "base/closure.h"
+#include "base/delayed_task_queue.h"
+#include "base/mpsc_queue.h"
+#include "base/task_metrics.h"
 
 namespace base {
 
-namespace internal {
-
-// Adapted from Chromium project.
-// Adapts a function that produces a result via a return value to
-// one that returns via an output parameter.
-template <typename ReturnType>
-void ReturnAsParamAdapter(std::function<ReturnType()> func,
-                          std::shared_ptr<ReturnType> result) {
-  *result = func();
-}
-
-// Adapts a ReturnType* result to a callback that expects a ReturnType.
-template <typename ReturnType>
-void ReplyAdapter(std::function<void(ReturnType)> callback,
-                  std::shared_ptr<ReturnType> result) {
-  callback(std::move(*result));
-}
-
-}  // namespace internal
-
 enum class Consumer {
   // Tasks are consumed by multiple threads.
   Multi,
-  // Tasks are consumed by a single thread.
+  // Tasks are consumed by a single thread. Doesn't lock.
   Single,
   // Consume tasks if ownership of the mutex can be acquire without blocking.
   NoBlocking
 };
 
-// Runs queued tasks (in the form of Closure objects). All methods are
-// thread-safe and can be called on any thread.
-// Tasks run in FIFO order when consumed by a single thread. When consumed
-// concurrently by multiple threads, it doesn't guarantee whether tasks overlap,
-// or whether they run on a particular thread.
+// Runs queued tasks (in the form of OnceClosure objects). Tasks can be posted
+// on any thread. Posting is lock-free, never blocks and doesn't allocate once
+// the queue nodes have been recycled, which makes it safe to post from realtime
+// threads.
+// Tasks run in FIFO order when consumed by a single thread. Tasks posted with
+// front=true run before the rest. When consumed concurrently by multiple
+// threads, it doesn't guarantee whether tasks overlap, or whether they run on a
+// particular thread. Consumer::Single must not be mixed with other consumers.
+// Delayed tasks are kept in a min-heap owned by the consumer and run by the
+// first RunTasks call after their deadline.
 class TaskRunner {
  public:
   TaskRunner() = default;
@@ -53,55 +40,118 @@ class TaskRunner {
   static void CreateThreadLocalTaskRunner();
   static std::shared_ptr<TaskRunner> GetThreadLocalTaskRunner();
 
-  void PostTask(Location from, Closure task, bool front = false);
+  void PostTask(Location from, OnceClosure task, bool front = false);
 
   void PostTaskAndReply(Location from,
-                        Closure task,
-                        Closure reply,
+                        OnceClosure task,
+                        OnceClosure reply,
                         bool front = false);
 
   template <typename ReturnType>
   void PostTaskAndReplyWithResult(Location from,
-                                  std::function<ReturnType()> task,
-                                  std::function<void(ReturnType)> reply,
-                                  bool front = false) {
-    auto result = std::make_shared<ReturnType>();
-    return PostTaskAndReply(
-        from,
-        std::bind(internal::ReturnAsParamAdapter<ReturnType>, std::move(task),
-                  result),
-        std::bind(internal::ReplyAdapter<ReturnType>, std::move(reply), result),
-        front);
-  }
+                                  OnceCallback<ReturnType()> task,
+                                  OnceCallback<void(ReturnType)> reply,
+                                  bool front = false);
+
+  // Posts a task to be run once the given number of seconds has elapsed.
+  void PostDelayedTask(Location from, OnceClosure task, double delay);
+
+  // Posts a task to be run every interval seconds for as long as it returns
+  // true. The interval is measured from the end of the previous run.
+  void PostRepeatingTask(Location from,
+                         std::function<bool()> task,
+                         double interval);
 
   // Posts a task that deletes the given object.
   template <class T>
   void Delete(Location from, std::unique_ptr<T> object) {
-    // std::function target must be copy-constructible
-    std::shared_ptr<T> owned = std::move(object);
-    PostTask(HERE, [owned]() {});
+    PostTask(from, [owned = std::move(object)]() -> void {});
   }
 
+  // Drops the pending and delayed tasks. Must be called on the consumer thread
+  // or while no thread is consuming tasks.
   void CancelTasks();
 
+  // Waits for the pending tasks to complete. Doesn't wait for delayed tasks.
   void WaitForCompletion();
 
   template <Consumer T>
   void RunTasks();
 
- private:
-  using Task = std::tuple<Location, Closure>;
+  // Instrumentation. Disabled by default.
+  TaskMetrics& GetMetrics() { return metrics_; }
 
-  std::deque<Task> queue_;
-  mutable std::mutex lock_;
+ private:
+  // Location, task and the time it was posted if metrics are enabled.
+  using Task = std::tuple<Location, OnceClosure, internal::Clock::time_point>;
+
+  MpscQueue<Task> queue_;
+  MpscQueue<Task> front_queue_;
+  // Delayed tasks are moved to delayed_tasks_ by the consumer.
+  MpscQueue<internal::DelayedTask> delayed_queue_;
+  internal::DelayedTaskQueue delayed_tasks_;
+  // Serializes multiple consumers.
+  std::mutex consumer_lock_;
   std::atomic<size_t> task_count_{0};
 
+  TaskMetrics metrics_;
+
   static thread_local std::shared_ptr<TaskRunner> thread_local_task_runner;
 
+  bool PopTask(Task& task);
+  void RunTask(Task& task);
+  // Moves the delayed tasks that are due to the pending tasks.
+  void ScheduleDelayedTasks();
+
   TaskRunner(TaskRunner const&) = delete;
   TaskRunner& operator=(TaskRunner const&) = delete;
 };
 
+namespace internal {
+
+// Returns a task that runs the given task and then posts the reply to
+// destination.
+OnceClosure MakeReplyRelay(Location from,
+                           OnceClosure task,
+                           OnceClosure reply,
+                           std::shared_ptr<TaskRunner> destination,
+                           bool front);
+
+// Returns a task that runs the given task and then posts the reply to
+// destination with the result. The result is moved along with the reply
+// instead of being shared between the two.
+template <typename ReturnType>
+OnceClosure MakeReplyWithResultRelay(Location from,
+                                     OnceCallback<ReturnType()> task,
+                                     OnceCallback<void(ReturnType)> reply,
+                                     std::shared_ptr<TaskRunner> destination,
+                                     bool front) {
+  return [from, task = std::move(task), reply = std::move(reply),
+          destination = std::move(destination), front]() mutable -> void {
+    destination->PostTask(
+        from,
+        [reply = std::move(reply), result = task()]() mutable -> void {
+          reply(std::move(result));
+        },
+        front);
+  };
+}
+
+}  // namespace internal
+
+template <typename ReturnType>
+void TaskRunner::PostTaskAndReplyWithResult(
+    Location from,
+    OnceCallback<ReturnType()> task,
+    OnceCallback<void(ReturnType)> reply,
+    bool front) {
+  PostTask(from,
+           internal::MakeReplyWithResultRelay(from, std::move(task),
+                                              std::move(reply),
+                                              thread_local_task_runner, front),
+           front);
+}
+
 }  // namespace base
 
 #endif  // BASE_TASK_RUNNER_H
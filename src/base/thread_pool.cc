@@ -1,11 +1,30 @@
 #include "base/thread_pool.h"
 
+#include <algorithm>
+#include <iterator>
+#include <random>
+
+#include "base/frame_arena.h"
 #include "base/log.h"
+#include "base/trace.h"
 
 namespace base {
 
+namespace {
+
+// Upper limit for the number of tasks a worker moves from the global queue to
+// its local queue at once.
+constexpr size_t kMaxGlobalBatchSize = 32;
+
+// Used for picking a random victim to steal from.
+thread_local std::minstd_rand random_engine;
+
+}  // namespace
+
 ThreadPool* ThreadPool::singleton = nullptr;
 
+thread_local ThreadPool::WorkerQueue* ThreadPool::thread_local_queue = nullptr;
+
 ThreadPool::ThreadPool() {
   DCHECK(!singleton);
   singleton = this;
@@ -24,8 +43,12 @@ void ThreadPool::Initialize(unsigned max_concurrency) {
       max_concurrency = 1;
   }
 
-  while (max_concurrency--)
-    threads_.emplace_back(&ThreadPool::WorkerMain, this);
+  // All queues need to exist before any worker starts stealing.
+  for (unsigned i = 0; i < max_concurrency; ++i)
+    worker_queues_.push_back(std::make_unique<WorkerQueue>());
+
+  for (unsigned i = 0; i < max_concurrency; ++i)
+    threads_.emplace_back(&ThreadPool::WorkerMain, this, i);
 }
 
 void ThreadPool::Shutdown() {
@@ -38,33 +61,260 @@ void ThreadPool::Shutdown() {
   for (auto& thread : threads_)
     thread.join();
   threads_.clear();
+  worker_queues_.clear();
 }
 
-void ThreadPool::PostTask(Location from, Closure task, bool front) {
-  task_runner_.PostTask(from, std::move(task), front);
+void ThreadPool::PostTask(Location from, OnceClosure task, bool front) {
+  DCHECK(task) << LOCATION(from);
+
+  auto posted = metrics_.OnTaskPosted();
+  if (thread_local_queue) {
+    metrics_.Lock(thread_local_queue->lock);
+    std::lock_guard<Spinlock> scoped_lock(thread_local_queue->lock,
+                                          std::adopt_lock);
+    if (front)
+      thread_local_queue->tasks.emplace_front(from, std::move(task), posted);
+    else
+      thread_local_queue->tasks.emplace_back(from, std::move(task), posted);
+  } else {
+    metrics_.Lock(global_lock_);
+    std::lock_guard<std::mutex> scoped_lock(global_lock_, std::adopt_lock);
+    if (front)
+      global_queue_.emplace_front(from, std::move(task), posted);
+    else
+      global_queue_.emplace_back(from, std::move(task), posted);
+  }
   semaphore_.release();
 }
 
 void ThreadPool::PostTaskAndReply(Location from,
-                                  Closure task,
-                                  Closure reply,
+                                  OnceClosure task,
+                                  OnceClosure reply,
                                   bool front) {
-  task_runner_.PostTaskAndReply(from, std::move(task), std::move(reply), front);
-  semaphore_.release();
+  DCHECK(task) << LOCATION(from);
+  DCHECK(reply) << LOCATION(from);
+  DCHECK(TaskRunner::GetThreadLocalTaskRunner()) << LOCATION(from);
+
+  PostTask(from,
+           internal::MakeReplyRelay(from, std::move(task), std::move(reply),
+                                    TaskRunner::GetThreadLocalTaskRunner(),
+                                    front),
+           front);
+}
+
+void ThreadPool::PostDelayedTask(Location from,
+                                 OnceClosure task,
+                                 double delay) {
+  DCHECK(task) << LOCATION(from);
+
+  auto deadline = internal::DeadlineFromNow(delay);
+  bool wake_up = false;
+  {
+    std::lock_guard<std::mutex> scoped_lock(delayed_lock_);
+    wake_up = deadline < delayed_tasks_.NextDeadline();
+    delayed_tasks_.Push({deadline, from, std::move(task)});
+    UpdateNextDeadline();
+  }
+
+  // Wake up a worker to wait for the new deadline.
+  if (wake_up)
+    semaphore_.release();
+}
+
+void ThreadPool::PostRepeatingTask(Location from,
+                                   std::function<bool()> task,
+                                   double interval) {
+  DCHECK(task) << LOCATION(from);
+
+  PostDelayedTask(from,
+                  internal::RepeatingTaskRelay<ThreadPool>(
+                      from, std::move(task), interval, this),
+                  interval);
 }
 
 void ThreadPool::CancelTasks() {
-  task_runner_.CancelTasks();
+  {
+    std::lock_guard<std::mutex> scoped_lock(delayed_lock_);
+    delayed_tasks_.Clear();
+    UpdateNextDeadline();
+  }
+  {
+    std::lock_guard<std::mutex> scoped_lock(global_lock_);
+    for (auto& task : global_queue_)
+      metrics_.OnTaskDropped(std::get<2>(task));
+    global_queue_.clear();
+  }
+  for (auto& queue : worker_queues_) {
+    std::lock_guard<Spinlock> scoped_lock(queue->lock);
+    for (auto& task : queue->tasks)
+      metrics_.OnTaskDropped(std::get<2>(task));
+    queue->tasks.clear();
+  }
+}
+
+bool ThreadPool::RunPendingTask() {
+  Task task;
+  if (!PopTask(task))
+    return false;
+
+  auto& [from, task_cb, posted] = task;
+
+  // Release the transient allocations the task made on this thread.
+  FrameArena::Scope arena_scope(FrameArena::ForCurrentThread());
+
+  // Tasks are named after the function they were posted from.
+  TRACE_SCOPE(from.function_name());
+
+#if 0
+  LOG(0) << __func__ << " from: " << LOCATION(from);
+#endif
+
+  if (posted == internal::Clock::time_point()) {
+    task_cb();
+  } else {
+    auto started = internal::Clock::now();
+    task_cb();
+    metrics_.OnTaskRun(from, posted, started, internal::Clock::now());
+  }
+  return true;
 }
 
-void ThreadPool::WorkerMain() {
+void ThreadPool::WorkerMain(unsigned index) {
+  thread_local_queue = worker_queues_[index].get();
+  random_engine.seed(index + 1);
+
   for (;;) {
-    semaphore_.acquire();
+    auto deadline = GetNextDeadline();
+    if (deadline == internal::Clock::time_point::max())
+      semaphore_.acquire();
+    else
+      (void)semaphore_.try_acquire_until(deadline);
     if (quit_.load(std::memory_order_relaxed))
       return;
 
-    task_runner_.RunTasks<Consumer::Multi>();
+    ScheduleDelayedTasks();
+
+    // Keep running tasks until there is nothing left to steal. Semaphore may
+    // have more counts than the number of pending tasks as a result.
+    while (RunPendingTask())
+      ;
+  }
+}
+
+void ThreadPool::ScheduleDelayedTasks() {
+  auto now = internal::Clock::now();
+  if (now < GetNextDeadline())
+    return;
+
+  // Another worker may be scheduling already.
+  std::unique_lock<std::mutex> scoped_lock(delayed_lock_, std::try_to_lock);
+  if (!scoped_lock)
+    return;
+
+  std::vector<internal::DelayedTask> due_tasks;
+  internal::DelayedTask delayed_task;
+  while (delayed_tasks_.PopDue(now, delayed_task))
+    due_tasks.push_back(std::move(delayed_task));
+  UpdateNextDeadline();
+  scoped_lock.unlock();
+
+  for (auto& task : due_tasks)
+    PostTask(task.from, std::move(task.task));
+}
+
+void ThreadPool::UpdateNextDeadline() {
+  next_deadline_.store(delayed_tasks_.NextDeadline().time_since_epoch().count(),
+                       std::memory_order_relaxed);
+}
+
+internal::Clock::time_point ThreadPool::GetNextDeadline() const {
+  auto deadline = next_deadline_.load(std::memory_order_relaxed);
+  return internal::Clock::time_point(internal::Clock::duration(deadline));
+}
+
+bool ThreadPool::PopTask(Task& task) {
+  if (thread_local_queue) {
+    metrics_.Lock(thread_local_queue->lock);
+    std::lock_guard<Spinlock> scoped_lock(thread_local_queue->lock,
+                                          std::adopt_lock);
+    if (!thread_local_queue->tasks.empty()) {
+      task.swap(thread_local_queue->tasks.front());
+      thread_local_queue->tasks.pop_front();
+      return true;
+    }
+  }
+
+  return PopGlobalTask(task) || StealTask(task);
+}
+
+bool ThreadPool::PopGlobalTask(Task& task) {
+  std::deque<Task> batch;
+  {
+    metrics_.Lock(global_lock_);
+    std::lock_guard<std::mutex> scoped_lock(global_lock_, std::adopt_lock);
+    if (global_queue_.empty())
+      return false;
+    task.swap(global_queue_.front());
+    global_queue_.pop_front();
+
+    // Take a fair share of the remaining tasks to reduce contention on the
+    // global lock.
+    if (thread_local_queue) {
+      size_t count = std::min(global_queue_.size() / worker_queues_.size(),
+                              kMaxGlobalBatchSize);
+      std::move(global_queue_.begin(), global_queue_.begin() + count,
+                std::back_inserter(batch));
+      global_queue_.erase(global_queue_.begin(),
+                          global_queue_.begin() + count);
+    }
+  }
+
+  if (!batch.empty()) {
+    std::lock_guard<Spinlock> scoped_lock(thread_local_queue->lock);
+    std::move(batch.begin(), batch.end(),
+              std::back_inserter(thread_local_queue->tasks));
+  }
+  return true;
+}
+
+bool ThreadPool::StealTask(Task& task) {
+  size_t num_queues = worker_queues_.size();
+  if (num_queues == 0)
+    return false;
+
+  size_t start = random_engine() % num_queues;
+  for (size_t i = 0; i < num_queues; ++i) {
+    WorkerQueue* victim_queue = worker_queues_[(start + i) % num_queues].get();
+    if (victim_queue == thread_local_queue)
+      continue;
+
+    std::deque<Task> stolen;
+    {
+      metrics_.Lock(victim_queue->lock);
+      std::lock_guard<Spinlock> scoped_lock(victim_queue->lock,
+                                            std::adopt_lock);
+      if (victim_queue->tasks.empty())
+        continue;
+
+      // Workers steal half of the tasks from the back of the victim's queue.
+      // Other threads help by stealing a single task.
+      size_t count =
+          thread_local_queue ? (victim_queue->tasks.size() + 1) / 2 : 1;
+      auto first = victim_queue->tasks.end() - count;
+      std::move(first, victim_queue->tasks.end(), std::back_inserter(stolen));
+      victim_queue->tasks.erase(first, victim_queue->tasks.end());
+    }
+
+    task.swap(stolen.front());
+    stolen.pop_front();
+    if (!stolen.empty()) {
+      std::lock_guard<Spinlock> scoped_lock(thread_local_queue->lock);
+      std::move(stolen.begin(), stolen.end(),
+                std::back_inserter(thread_local_queue->tasks));
+    }
+    return true;
   }
+  return false;
 }
 
 }  // namespace base
@@ -2,17 +2,29 @@
 #define BASE_THREAD_POOL_H
 
 #include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
 #include <semaphore>
 #include <thread>
+#include <tuple>
 #include <vector>
 
 #include "base/closure.h"
+#include "base/delayed_task_queue.h"
+#include "base/spinlock.h"
+#include "base/task_metrics.h"
 #include "base/task_runner.h"
 
 namespace base {
 
-// Feed the ThreadPool tasks (in the form of Closure objects) and they will be
-// called on any thread from the pool.
+// Feed the ThreadPool tasks (in the form of OnceClosure objects) and they will
+// be called on any thread from the pool.
+// Each worker thread owns a local queue. Tasks posted from a worker thread go
+// to its local queue, tasks posted from any other thread go to a global
+// injection queue. Idle workers steal tasks from the local queues of other
+// workers, picking a random victim to start with.
+// Idle workers sleep until the deadline of the next delayed task.
 class ThreadPool {
  public:
   ThreadPool();
@@ -24,36 +36,94 @@ class ThreadPool {
 
   void Shutdown();
 
-  void PostTask(Location from, Closure task, bool front = false);
+  // If front is true the task is run before the other tasks pending in the
+  // queue it was posted to.
+  void PostTask(Location from, OnceClosure task, bool front = false);
 
   void PostTaskAndReply(Location from,
-                        Closure task,
-                        Closure reply,
+                        OnceClosure task,
+                        OnceClosure reply,
                         bool front = false);
 
   template <typename ReturnType>
   void PostTaskAndReplyWithResult(Location from,
-                                  std::function<ReturnType()> task,
-                                  std::function<void(ReturnType)> reply,
+                                  OnceCallback<ReturnType()> task,
+                                  OnceCallback<void(ReturnType)> reply,
                                   bool front = false) {
-    task_runner_.PostTaskAndReplyWithResult(from, std::move(task),
-                                            std::move(reply), front);
-    semaphore_.release();
+    PostTask(from,
+             internal::MakeReplyWithResultRelay(
+                 from, std::move(task), std::move(reply),
+                 TaskRunner::GetThreadLocalTaskRunner(), front),
+             front);
   }
 
+  // Posts a task to be run once the given number of seconds has elapsed.
+  void PostDelayedTask(Location from, OnceClosure task, double delay);
+
+  // Posts a task to be run every interval seconds for as long as it returns
+  // true. The interval is measured from the end of the previous run.
+  void PostRepeatingTask(Location from,
+                         std::function<bool()> task,
+                         double interval);
+
+  // Drops the pending and delayed tasks.
   void CancelTasks();
 
+  // Runs a single pending task on the calling thread. Returns false if there
+  // was no task to run. Can be called on any thread to help the pool while
+  // waiting for work to complete.
+  bool RunPendingTask();
+
+  size_t GetConcurrency() const { return threads_.size(); }
+
+  // Instrumentation. Disabled by default.
+  TaskMetrics& GetMetrics() { return metrics_; }
+
  private:
+  // Location, task and the time it was posted if metrics are enabled.
+  using Task = std::tuple<Location, OnceClosure, internal::Clock::time_point>;
+
+  // The owner pops tasks from the front. Thieves steal from the back.
+  struct WorkerQueue {
+    std::deque<Task> tasks;
+    Spinlock lock;
+  };
+
   std::vector<std::thread> threads_;
+  std::vector<std::unique_ptr<WorkerQueue>> worker_queues_;
+
+  // Tasks posted from threads that don't belong to the pool.
+  std::deque<Task> global_queue_;
+  std::mutex global_lock_;
+
+  internal::DelayedTaskQueue delayed_tasks_;
+  std::mutex delayed_lock_;
+  // Deadline of the first delayed task. Can be read without locking.
+  std::atomic<internal::Clock::rep> next_deadline_{
+      internal::Clock::time_point::max().time_since_epoch().count()};
 
   std::counting_semaphore<> semaphore_{0};
   std::atomic<bool> quit_{false};
 
-  base::TaskRunner task_runner_;
+  TaskMetrics metrics_;
 
   static ThreadPool* singleton;
 
-  void WorkerMain();
+  // The local queue of the worker thread. nullptr on other threads.
+  static thread_local WorkerQueue* thread_local_queue;
+
+  void WorkerMain(unsigned index);
+
+  // Posts the delayed tasks that are due.
+  void ScheduleDelayedTasks();
+  void UpdateNextDeadline();
+  internal::Clock::time_point GetNextDeadline() const;
+
+  // Pops a task from the local queue of the calling thread (if it's a worker
+  // thread), the global queue or the queue of another worker in this order.
+  bool PopTask(Task& task);
+  bool PopGlobalTask(Task& task);
+  bool StealTask(Task& task);
 
   ThreadPool(ThreadPool const&) = delete;
   ThreadPool& operator=(ThreadPool const&) = delete;
@@ -0,0 +1,181 @@
+#include "base/trace.h"
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "base/file.h"
+#include "base/log.h"
+
+namespace base {
+
+namespace internal {
+
+std::atomic<bool> g_tracing{false};
+
+}  // namespace internal
+
+namespace {
+
+struct TraceRecord {
+  const char* name;
+  int64_t timestamp;
+  int64_t duration;
+  internal::TracePhase phase;
+};
+
+// Single producer buffer of trace records. Written by the owner thread, read
+// after tracing is stopped. Records that don't fit are dropped.
+struct TraceBuffer {
+  static constexpr size_t kCapacity = 32 * 1024;
+
+  int thread_id = 0;
+  // The tracing session the records belong to. The owner thread clears the
+  // buffer when a new session starts.
+  std::atomic<uint32_t> session{0};
+  std::atomic<size_t> count{0};
+  std::atomic<size_t> dropped{0};
+  std::atomic<bool> thread_exited{false};
+  TraceRecord records[kCapacity];
+};
+
+std::atomic<uint32_t> g_session{0};
+
+struct BufferRegistry {
+  std::vector<std::shared_ptr<TraceBuffer>> buffers;
+  int next_thread_id = 1;
+  std::mutex lock;
+};
+
+BufferRegistry& GetRegistry() {
+  // Intentionally never destroyed. Threads may exit after static destructors
+  // have run.
+  static BufferRegistry* registry = new BufferRegistry;
+  return *registry;
+}
+
+TraceBuffer* GetThreadLocalBuffer() {
+  // Kept around after the thread exits until the next session starts.
+  struct BufferOwner {
+    std::shared_ptr<TraceBuffer> buffer;
+    ~BufferOwner() {
+      if (buffer)
+        buffer->thread_exited.store(true, std::memory_order_release);
+    }
+  };
+  static thread_local BufferOwner owner;
+  if (!owner.buffer) {
+    auto buffer = std::make_shared<TraceBuffer>();
+    BufferRegistry& registry = GetRegistry();
+    std::lock_guard<std::mutex> scoped_lock(registry.lock);
+    buffer->thread_id = registry.next_thread_id++;
+    registry.buffers.push_back(buffer);
+    owner.buffer = std::move(buffer);
+  }
+  return owner.buffer.get();
+}
+
+std::string EscapeJson(const char* str) {
+  std::string escaped;
+  for (; *str; ++str) {
+    if (*str == '"' || *str == '\\')
+      escaped.push_back('\\');
+    escaped.push_back(*str);
+  }
+  return escaped;
+}
+
+}  // namespace
+
+void StartTracing() {
+  BufferRegistry& registry = GetRegistry();
+  std::lock_guard<std::mutex> scoped_lock(registry.lock);
+  std::erase_if(registry.buffers,
+                [](const std::shared_ptr<TraceBuffer>& buffer) {
+                  return buffer->thread_exited.load(std::memory_order_acquire);
+                });
+  g_session.fetch_add(1, std::memory_order_release);
+  internal::g_tracing.store(true, std::memory_order_relaxed);
+}
+
+bool StopTracing(const std::string& file_path) {
+  internal::g_tracing.store(false, std::memory_order_relaxed);
+
+  ScopedFILE file;
+  file.reset(fopen(file_path.c_str(), "w"));
+  if (!file) {
+    LOG(0) << "Failed to create file " << file_path;
+    return false;
+  }
+
+  BufferRegistry& registry = GetRegistry();
+  std::lock_guard<std::mutex> scoped_lock(registry.lock);
+  uint32_t session = g_session.load(std::memory_order_relaxed);
+  size_t dropped = 0;
+  fprintf(file.get(), "{\"traceEvents\":[\n");
+  fprintf(file.get(),
+          "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,"
+          "\"args\":{\"name\":\"kaliber\"}}");
+  for (auto& buffer : registry.buffers) {
+    if (buffer->session.load(std::memory_order_acquire) != session)
+      continue;
+    size_t count = buffer->count.load(std::memory_order_acquire);
+    for (size_t i = 0; i < count; ++i) {
+      const TraceRecord& record = buffer->records[i];
+      if (record.phase == internal::TracePhase::kComplete) {
+        fprintf(file.get(),
+                ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+                "\"ts\":%lld,\"dur\":%lld}",
+                EscapeJson(record.name).c_str(), buffer->thread_id,
+                (long long)record.timestamp, (long long)record.duration);
+      } else {
+        fprintf(file.get(),
+                ",\n{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,"
+                "\"tid\":%d,\"ts\":%lld}",
+                EscapeJson(record.name).c_str(), buffer->thread_id,
+                (long long)record.timestamp);
+      }
+    }
+    dropped += buffer->dropped.load(std::memory_order_relaxed);
+  }
+  fprintf(file.get(), "\n]}\n");
+
+  if (dropped)
+    LOG(0) << dropped << " trace events dropped";
+  return true;
+}
+
+namespace internal {
+
+int64_t TraceTimestamp() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+void AddTraceEvent(TracePhase phase,
+                   const char* name,
+                   int64_t timestamp,
+                   int64_t duration) {
+  TraceBuffer* buffer = GetThreadLocalBuffer();
+
+  uint32_t session = g_session.load(std::memory_order_acquire);
+  if (buffer->session.load(std::memory_order_relaxed) != session) {
+    buffer->count.store(0, std::memory_order_relaxed);
+    buffer->dropped.store(0, std::memory_order_relaxed);
+    buffer->session.store(session, std::memory_order_release);
+  }
+
+  size_t index = buffer->count.load(std::memory_order_relaxed);
+  if (index == TraceBuffer::kCapacity) {
+    buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  buffer->records[index] = {name, timestamp, duration, phase};
+  buffer->count.store(index + 1, std::memory_order_release);
+}
+
+}  // namespace internal
+
+}  // namespace base
@@ -0,0 +1,96 @@
+#ifndef BASE_TRACE_H
+#define BASE_TRACE_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Macros for recording trace events that can be viewed in about:tracing or
+// Perfetto. TRACE_SCOPE records how long the enclosing scope took.
+// TRACE_EVENT records an instant event. Names must be string literals or
+// otherwise outlive the trace, as only the pointer is recorded. e.g.
+//   void Engine::Update(float delta_time) {
+//     TRACE_SCOPE("Engine::Update");
+//     ...
+//   }
+// Events are recorded into lock-free per-thread buffers while tracing is
+// started. Compiled out to nothing unless ENABLE_TRACING is defined.
+#if defined(ENABLE_TRACING)
+
+#define TRACE_SCOPE(name) \
+  ::base::TraceScope TRACE_CONCAT(trace_scope_, __LINE__)(name)
+#define TRACE_EVENT(name) ::base::TraceInstant(name)
+
+#define TRACE_CONCAT_INTERNAL(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INTERNAL(a, b)
+
+#else
+
+#define TRACE_SCOPE(name) \
+  do {                    \
+  } while (false)
+#define TRACE_EVENT(name) \
+  do {                    \
+  } while (false)
+
+#endif
+
+namespace base {
+
+// Clears the previous trace and starts recording.
+void StartTracing();
+
+// Stops recording and writes the trace in Chrome JSON trace format. Returns
+// false if the file couldn't be written.
+bool StopTracing(const std::string& file_path);
+
+namespace internal {
+
+enum class TracePhase : uint8_t { kComplete, kInstant };
+
+extern std::atomic<bool> g_tracing;
+
+// Microseconds since an arbitrary epoch.
+int64_t TraceTimestamp();
+
+void AddTraceEvent(TracePhase phase,
+                   const char* name,
+                   int64_t timestamp,
+                   int64_t duration);
+
+}  // namespace internal
+
+inline bool IsTracing() {
+  return internal::g_tracing.load(std::memory_order_relaxed);
+}
+
+inline void TraceInstant(const char* name) {
+  if (IsTracing()) {
+    internal::AddTraceEvent(internal::TracePhase::kInstant, name,
+                            internal::TraceTimestamp(), 0);
+  }
+}
+
+class TraceScope {
+ public:
+  explicit TraceScope(const char* name)
+      : name_(name), begin_(IsTracing() ? internal::TraceTimestamp() : -1) {}
+
+  ~TraceScope() {
+    if (begin_ >= 0) {
+      internal::AddTraceEvent(internal::TracePhase::kComplete, name_, begin_,
+                              internal::TraceTimestamp() - begin_);
+    }
+  }
+
+ private:
+  const char* name_;
+  int64_t begin_;
+
+  TraceScope(const TraceScope&) = delete;
+  TraceScope& operator=(const TraceScope&) = delete;
+};
+
+}  // namespace base
+
+#endif  // BASE_TRACE_H
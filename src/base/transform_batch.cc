@@ -0,0 +1,178 @@
+#include "base/transform_batch.h"
+
+#include "base/vecmath_simd.h"
+
+namespace base {
+
+#if defined(VECMATH_SIMD)
+
+namespace {
+
+using namespace internal;
+
+static_assert(sizeof(TransformBatch::Vertex) == sizeof(float) * 4);
+
+struct QuadArrays {
+  const float* position_x;
+  const float* position_y;
+  const float* size_x;
+  const float* size_y;
+  const float* sin;
+  const float* cos;
+  const float* uv_offset_x;
+  const float* uv_offset_y;
+  const float* uv_scale_x;
+  const float* uv_scale_y;
+};
+
+// Transposes the given corner of 4 sprites into vertices and stores them.
+void StoreCorner(F32x4 x, F32x4 y, F32x4 u, F32x4 v, float* dst) {
+  constexpr size_t kStride = TransformBatch::kVerticesPerQuad * 4;
+  Transpose(x, y, u, v);
+  StoreF32x4(dst, x);
+  StoreF32x4(dst + kStride, y);
+  StoreF32x4(dst + kStride * 2, u);
+  StoreF32x4(dst + kStride * 3, v);
+}
+
+// Transforms 4 sprites at a time. Returns the number of sprites transformed.
+size_t TransformQuads(const QuadArrays& src,
+                      size_t count,
+                      TransformBatch::Vertex* vertices) {
+  F32x4 half = SplatF32x4(0.5f);
+  F32x4 one = SplatF32x4(1);
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    F32x4 half_size_x = Mul(LoadF32x4(src.size_x + i), half);
+    F32x4 half_size_y = Mul(LoadF32x4(src.size_y + i), half);
+    F32x4 sin = LoadF32x4(src.sin + i);
+    F32x4 cos = LoadF32x4(src.cos + i);
+
+    // Corners are (+-a +-b, +-c +-d) relative to the position.
+    F32x4 a = Mul(half_size_x, cos);
+    F32x4 b = Mul(half_size_y, sin);
+    F32x4 c = Mul(half_size_y, cos);
+    F32x4 d = Mul(half_size_x, sin);
+    F32x4 position_x = LoadF32x4(src.position_x + i);
+    F32x4 position_y = LoadF32x4(src.position_y + i);
+    F32x4 left = Sub(position_x, a);
+    F32x4 right = Add(position_x, a);
+    F32x4 bottom = Sub(position_y, c);
+    F32x4 top = Add(position_y, c);
+
+    F32x4 uv_offset_x = LoadF32x4(src.uv_offset_x + i);
+    F32x4 uv_offset_y = LoadF32x4(src.uv_offset_y + i);
+    F32x4 uv_scale_x = LoadF32x4(src.uv_scale_x + i);
+    F32x4 uv_scale_y = LoadF32x4(src.uv_scale_y + i);
+    F32x4 u0 = Mul(uv_offset_x, uv_scale_x);
+    F32x4 u1 = Mul(Add(uv_offset_x, one), uv_scale_x);
+    F32x4 v0 = Mul(uv_offset_y, uv_scale_y);
+    F32x4 v1 = Mul(Add(uv_offset_y, one), uv_scale_y);
+
+    float* dst = &vertices[i * TransformBatch::kVerticesPerQuad].x;
+    StoreCorner(Sub(left, b), Add(bottom, d), u0, v1, dst);
+    StoreCorner(Sub(right, b), Sub(bottom, d), u1, v1, dst + 4);
+    StoreCorner(Add(left, b), Add(top, d), u0, v0, dst + 8);
+    StoreCorner(Add(right, b), Sub(top, d), u1, v0, dst + 12);
+  }
+  return i;
+}
+
+}  // namespace
+
+#endif  // defined(VECMATH_SIMD)
+
+TransformBatch::TransformBatch() = default;
+
+TransformBatch::~TransformBatch() = default;
+
+void TransformBatch::Reserve(size_t count) {
+  position_x_.reserve(count);
+  position_y_.reserve(count);
+  size_x_.reserve(count);
+  size_y_.reserve(count);
+  sin_.reserve(count);
+  cos_.reserve(count);
+  uv_offset_x_.reserve(count);
+  uv_offset_y_.reserve(count);
+  uv_scale_x_.reserve(count);
+  uv_scale_y_.reserve(count);
+}
+
+void TransformBatch::Clear() {
+  position_x_.clear();
+  position_y_.clear();
+  size_x_.clear();
+  size_y_.clear();
+  sin_.clear();
+  cos_.clear();
+  uv_offset_x_.clear();
+  uv_offset_y_.clear();
+  uv_scale_x_.clear();
+  uv_scale_y_.clear();
+}
+
+void TransformBatch::Add(const Vector2f& position,
+                         const Vector2f& size,
+                         const Vector2f& rotation,
+                         const Vector2f& uv_offset,
+                         const Vector2f& uv_scale) {
+  position_x_.push_back(position.x);
+  position_y_.push_back(position.y);
+  size_x_.push_back(size.x);
+  size_y_.push_back(size.y);
+  sin_.push_back(rotation.x);
+  cos_.push_back(rotation.y);
+  uv_offset_x_.push_back(uv_offset.x);
+  uv_offset_y_.push_back(uv_offset.y);
+  uv_scale_x_.push_back(uv_scale.x);
+  uv_scale_y_.push_back(uv_scale.y);
+}
+
+void TransformBatch::Transform(Vertex* vertices) const {
+  size_t i = 0;
+#if defined(VECMATH_SIMD)
+  QuadArrays src = {position_x_.data(),  position_y_.data(),
+                    size_x_.data(),      size_y_.data(),
+                    sin_.data(),         cos_.data(),
+                    uv_offset_x_.data(), uv_offset_y_.data(),
+                    uv_scale_x_.data(),  uv_scale_y_.data()};
+  i = TransformQuads(src, size(), vertices);
+#endif
+  TransformScalar(i, size(), vertices);
+}
+
+void TransformBatch::TransformScalar(Vertex* vertices) const {
+  TransformScalar(0, size(), vertices);
+}
+
+void TransformBatch::TransformScalar(size_t begin,
+                                     size_t end,
+                                     Vertex* vertices) const {
+  for (size_t i = begin; i < end; ++i) {
+    float half_size_x = size_x_[i] * 0.5f;
+    float half_size_y = size_y_[i] * 0.5f;
+
+    float a = half_size_x * cos_[i];
+    float b = half_size_y * sin_[i];
+    float c = half_size_y * cos_[i];
+    float d = half_size_x * sin_[i];
+    float left = position_x_[i] - a;
+    float right = position_x_[i] + a;
+    float bottom = position_y_[i] - c;
+    float top = position_y_[i] + c;
+
+    float u0 = uv_offset_x_[i] * uv_scale_x_[i];
+    float u1 = (uv_offset_x_[i] + 1) * uv_scale_x_[i];
+    float v0 = uv_offset_y_[i] * uv_scale_y_[i];
+    float v1 = (uv_offset_y_[i] + 1) * uv_scale_y_[i];
+
+    Vertex* dst = &vertices[i * kVerticesPerQuad];
+    dst[0] = {left - b, bottom + d, u0, v1};
+    dst[1] = {right - b, bottom - d, u1, v1};
+    dst[2] = {left + b, top + d, u0, v0};
+    dst[3] = {right + b, top - d, u1, v0};
+  }
+}
+
+}  // namespace base
@@ -0,0 +1,76 @@
+#ifndef BASE_TRANSFORM_BATCH_H
+#define BASE_TRANSFORM_BATCH_H
+
+#include <cstddef>
+#include <vector>
+
+#include "base/vecmath.h"
+
+namespace base {
+
+// Transforms a batch of 2D sprites on the CPU. Sprites are stored in
+// structure-of-arrays form and transformed 4 at a time with SSE2 or NEON.
+// Computes the same transform as the pass-through shader, i.e. a unit quad
+// centered at the origin is scaled by size, rotated and translated by position.
+// UVs are computed as (uv + uv_offset) * uv_scale. e.g.
+//   TransformBatch batch;
+//   for (auto* quad : quads)
+//     batch.Add(quad->GetPosition(), quad->GetSize(), quad->GetRotation());
+//   std::vector<TransformBatch::Vertex> vertices(batch.GetNumVertices());
+//   batch.Transform(vertices.data());
+class TransformBatch {
+ public:
+  // Matches the "p2f;t2f" vertex description.
+  struct Vertex {
+    float x, y;
+    float u, v;
+  };
+
+  // Vertices are emitted in triangle strip order, bottom-left, bottom-right,
+  // top-left, top-right.
+  static constexpr size_t kVerticesPerQuad = 4;
+
+  TransformBatch();
+  ~TransformBatch();
+
+  void Reserve(size_t count);
+  void Clear();
+
+  // rotation is (sin, cos) of the angle, as returned by
+  // Animatable::GetRotation().
+  void Add(const Vector2f& position,
+           const Vector2f& size,
+           const Vector2f& rotation,
+           const Vector2f& uv_offset = {0, 0},
+           const Vector2f& uv_scale = {1, 1});
+
+  size_t size() const { return position_x_.size(); }
+  size_t GetNumVertices() const { return size() * kVerticesPerQuad; }
+
+  // Writes GetNumVertices() vertices.
+  void Transform(Vertex* vertices) const;
+
+  // Same as Transform() without SIMD. For reference and benchmarking.
+  void TransformScalar(Vertex* vertices) const;
+
+ private:
+  std::vector<float> position_x_;
+  std::vector<float> position_y_;
+  std::vector<float> size_x_;
+  std::vector<float> size_y_;
+  std::vector<float> sin_;
+  std::vector<float> cos_;
+  std::vector<float> uv_offset_x_;
+  std::vector<float> uv_offset_y_;
+  std::vector<float> uv_scale_x_;
+  std::vector<float> uv_scale_y_;
+
+  void TransformScalar(size_t begin, size_t end, Vertex* vertices) const;
+
+  TransformBatch(const TransformBatch&) = delete;
+  TransformBatch& operator=(const TransformBatch&) = delete;
+};
+
+}  // namespace base
+
+#endif  // BASE_TRANSFORM_BATCH_H
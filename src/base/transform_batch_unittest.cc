@@ -0,0 +1,86 @@
+#include "base/transform_batch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "base/random.h"
+#include "base/unittest.h"
+
+using namespace base;
+
+namespace {
+
+bool Near(float a, float b) {
+  return std::abs(a - b) <= 1e-5f * std::max({1.0f, std::abs(a), std::abs(b)});
+}
+
+bool Near(const TransformBatch::Vertex& a, const TransformBatch::Vertex& b) {
+  return Near(a.x, b.x) && Near(a.y, b.y) && Near(a.u, b.u) && Near(a.v, b.v);
+}
+
+void AddRandomSprite(Random& random, TransformBatch& batch) {
+  Vector2f position(Lerp(-500.0f, 500.0f, random.Rand()),
+                    Lerp(-500.0f, 500.0f, random.Rand()));
+  Vector2f size(Lerp(0.0f, 64.0f, random.Rand()),
+                Lerp(0.0f, 64.0f, random.Rand()));
+  float angle = Lerp(0.0f, 6.3f, random.Rand());
+  Vector2f uv_offset(float(random.Roll(8) - 1), float(random.Roll(8) - 1));
+  Vector2f uv_scale(random.Rand(), random.Rand());
+  batch.Add(position, size, {std::sin(angle), std::cos(angle)}, uv_offset,
+            uv_scale);
+}
+
+}  // namespace
+
+// Batch sizes that leave every possible remainder for the scalar path.
+TEST(TransformBatch, SimdMatchesScalar) {
+  Random random(1);
+  for (size_t count = 0; count <= 260; ++count) {
+    TransformBatch batch;
+    for (size_t i = 0; i < count; ++i)
+      AddRandomSprite(random, batch);
+
+    std::vector<TransformBatch::Vertex> simd(batch.GetNumVertices());
+    std::vector<TransformBatch::Vertex> scalar(batch.GetNumVertices());
+    batch.Transform(simd.data());
+    batch.TransformScalar(scalar.data());
+    for (size_t i = 0; i < simd.size(); ++i) {
+      EXPECT(Near(simd[i], scalar[i]))
+          << "count: " << count << " vertex: " << i;
+    }
+  }
+}
+
+// Same transform as the pass-through shader applied to the unit quad.
+TEST(TransformBatch, MatchesShader) {
+  const Vector2f position(10, 20), size(8, 4), uv_offset(1, 0),
+      uv_scale(0.25f, 1);
+  const float angle = 0.3f;
+  const Vector2f rotation(std::sin(angle), std::cos(angle));
+
+  // Triangle strip order, with the texture coordinates of the engine quad.
+  const float quad[4][4] = {{-0.5f, -0.5f, 0, 1},
+                            {0.5f, -0.5f, 1, 1},
+                            {-0.5f, 0.5f, 0, 0},
+                            {0.5f, 0.5f, 1, 0}};
+
+  // Enough sprites for the SIMD path.
+  TransformBatch batch;
+  for (int i = 0; i < 4; ++i)
+    batch.Add(position, size, rotation, uv_offset, uv_scale);
+  std::vector<TransformBatch::Vertex> vertices(batch.GetNumVertices());
+  batch.Transform(vertices.data());
+
+  for (size_t i = 0; i < vertices.size(); ++i) {
+    const float* in = quad[i % TransformBatch::kVerticesPerQuad];
+    Vector2f p(in[0] * size.x, in[1] * size.y);
+    p = Vector2f(p.x * rotation.y + p.y * rotation.x,
+                 p.y * rotation.y - p.x * rotation.x);
+    p += position;
+    TransformBatch::Vertex expected = {p.x, p.y,
+                                       (in[2] + uv_offset.x) * uv_scale.x,
+                                       (in[3] + uv_offset.y) * uv_scale.y};
+    EXPECT(Near(vertices[i], expected)) << "vertex: " << i;
+  }
+}
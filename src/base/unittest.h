@@ -0,0 +1,55 @@
+#ifndef BASE_UNITTEST_H
+#define BASE_UNITTEST_H
+
+#include <sstream>
+
+// Minimal test harness for //src/base:tests. Failed expectations are reported
+// and the test continues. e.g.
+//   TEST(ConcurrentStack, PushPop) {
+//     ConcurrentStack<int> stack;
+//     stack.Push(1);
+//     int value;
+//     EXPECT(stack.Pop(value));
+//     EXPECT(value == 1) << "value: " << value;
+//   }
+#define TEST(suite, name)                                            \
+  static void suite##_##name();                                      \
+  static ::base::internal::TestRegistrar suite##_##name##_registrar( \
+      #suite "." #name, suite##_##name);                             \
+  static void suite##_##name()
+
+#define EXPECT(expr) \
+  if (expr)          \
+    ;                \
+  else               \
+    ::base::internal::TestFailure(__FILE__, __LINE__, #expr).stream()
+
+namespace base {
+
+namespace internal {
+
+using TestFn = void (*)();
+
+void RegisterTest(const char* name, TestFn test);
+
+struct TestRegistrar {
+  TestRegistrar(const char* name, TestFn test) { RegisterTest(name, test); }
+};
+
+// Reports the failure when destroyed.
+class TestFailure {
+ public:
+  TestFailure(const char* file, int line, const char* expr);
+  ~TestFailure();
+
+  std::ostream& stream() { return stream_; }
+
+ private:
+  std::ostringstream stream_;
+};
+
+}  // namespace internal
+
+}  // namespace base
+
+#endif  // BASE_UNITTEST_H
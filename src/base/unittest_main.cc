@@ -0,0 +1,70 @@
+#include <cstdio>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "base/timer.h"
+#include "base/unittest.h"
+
+using namespace base;
+
+namespace {
+
+std::vector<std::pair<const char*, internal::TestFn>>& GetRegistry() {
+  static std::vector<std::pair<const char*, internal::TestFn>> registry;
+  return registry;
+}
+
+size_t failure_count = 0;
+
+}  // namespace
+
+namespace base {
+
+namespace internal {
+
+void RegisterTest(const char* name, TestFn test) {
+  GetRegistry().emplace_back(name, test);
+}
+
+TestFailure::TestFailure(const char* file, int line, const char* expr) {
+  stream_ << file << ":" << line << ": Failed: " << expr << " ";
+}
+
+TestFailure::~TestFailure() {
+  ++failure_count;
+  fprintf(stderr, "%s\n", stream_.str().c_str());
+}
+
+}  // namespace internal
+
+}  // namespace base
+
+// Runs the tests with names containing the first argument, or all of them.
+// Returns non-zero if any test failed.
+int main(int argc, char** argv) {
+  const char* filter = argc > 1 ? argv[1] : "";
+  size_t failed_tests = 0;
+
+  for (auto& [name, test] : GetRegistry()) {
+    if (!strstr(name, filter))
+      continue;
+
+    printf("[ RUN  ] %s\n", name);
+    size_t failures = failure_count;
+    ElapsedTimer timer;
+    test();
+    bool ok = failure_count == failures;
+    if (!ok)
+      ++failed_tests;
+    printf("[ %s ] %s (%.0f ms)\n", ok ? " OK " : "FAIL", name,
+           timer.Elapsed() * 1000);
+  }
+
+  if (failed_tests) {
+    printf("%zu tests failed.\n", failed_tests);
+    return 1;
+  }
+  printf("All tests passed.\n");
+  return 0;
+}
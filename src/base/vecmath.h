@@ -7,6 +7,7 @@
 
 #include "base/interpolation.h"
 #include "base/log.h"
+#include "base/vecmath_simd.h"
 
 //
 // Miscellaneous helper macros.
@@ -195,6 +196,117 @@ void CreateAngleZYXFromMatrix(Vector3<T>& v,
   }
 }
 
+//
+// Scalar implementations of the operations that have a SIMD version in
+// vecmath_simd.h. The SIMD versions are non-template overloads for float, so
+// they take precedence where available.
+//
+
+namespace internal {
+
+template <typename T>
+void Vector4Add(const T a[4], const T b[4], T dst[4]) {
+  for (int i = 0; i < 4; i++)
+    dst[i] = a[i] + b[i];
+}
+
+template <typename T>
+void Vector4Sub(const T a[4], const T b[4], T dst[4]) {
+  for (int i = 0; i < 4; i++)
+    dst[i] = a[i] - b[i];
+}
+
+template <typename T>
+void Vector4Mul(const T a[4], const T b[4], T dst[4]) {
+  for (int i = 0; i < 4; i++)
+    dst[i] = a[i] * b[i];
+}
+
+template <typename T>
+void Vector4Div(const T a[4], const T b[4], T dst[4]) {
+  for (int i = 0; i < 4; i++)
+    dst[i] = a[i] / b[i];
+}
+
+template <typename T>
+void Vector4Scale(const T a[4], T s, T dst[4]) {
+  for (int i = 0; i < 4; i++)
+    dst[i] = a[i] * s;
+}
+
+template <typename T>
+T Vector4Dot(const T a[4], const T b[4]) {
+  return a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
+}
+
+// v * m, where v is a row vector. dst must not alias v.
+template <typename T>
+void Vector4Transform(const T v[4], const T m[4][4], T dst[4]) {
+  for (int i = 0; i < 4; i++)
+    dst[i] = m[0][i] * v[0] + m[1][i] * v[1] + m[2][i] * v[2] + m[3][i] * v[3];
+}
+
+// p * m, where p is a row vector with w = 1. dst must not alias p.
+template <typename T>
+void Vector3TransformPoint(const T p[3], const T m[4][4], T dst[3]) {
+  for (int i = 0; i < 3; i++)
+    dst[i] = m[0][i] * p[0] + m[1][i] * p[1] + m[2][i] * p[2] + m[3][i];
+}
+
+// dst must not alias a or b.
+template <typename T>
+void Matrix4Multiply(const T a[4][4], const T b[4][4], T dst[4][4]) {
+  for (int row = 0; row < 4; row++)
+    for (int col = 0; col < 4; col++)
+      dst[row][col] = (a[row][0] * b[0][col]) + (a[row][1] * b[1][col]) +
+                      (a[row][2] * b[2][col]) + (a[row][3] * b[3][col]);
+}
+
+// dst must not alias m.
+template <typename T>
+void Matrix4Transpose(const T m[4][4], T dst[4][4]) {
+  for (int row = 0; row < 4; row++)
+    for (int col = 0; col < 4; col++)
+      dst[row][col] = m[col][row];
+}
+
+// Leaves dst untouched and returns false if the matrix isn't invertible.
+template <typename T>
+bool Matrix4Inverse(const T m[4][4], T dst[4][4]) {
+  T d = Determinant4x4(m[0][0], m[0][1], m[0][2], m[0][3], m[1][0], m[1][1],
+                       m[1][2], m[1][3], m[2][0], m[2][1], m[2][2], m[2][3],
+                       m[3][0], m[3][1], m[3][2], m[3][3]);
+  if (d == T(0.0))
+    return false;
+
+  // Computed into a temporary so that dst may alias m.
+  T d_inv = T(1.0) / d;
+  T r[4][4] = {
+      {d_inv * _M_DET3x3(m, 1, 2, 3, 1, 2, 3),
+       -d_inv * _M_DET3x3(m, 0, 2, 3, 1, 2, 3),
+       d_inv * _M_DET3x3(m, 0, 1, 3, 1, 2, 3),
+       -d_inv * _M_DET3x3(m, 0, 1, 2, 1, 2, 3)},
+      {-d_inv * _M_DET3x3(m, 1, 2, 3, 0, 2, 3),
+       d_inv * _M_DET3x3(m, 0, 2, 3, 0, 2, 3),
+       -d_inv * _M_DET3x3(m, 0, 1, 3, 0, 2, 3),
+       d_inv * _M_DET3x3(m, 0, 1, 2, 0, 2, 3)},
+      {d_inv * _M_DET3x3(m, 1, 2, 3, 0, 1, 3),
+       -d_inv * _M_DET3x3(m, 0, 2, 3, 0, 1, 3),
+       d_inv * _M_DET3x3(m, 0, 1, 3, 0, 1, 3),
+       -d_inv * _M_DET3x3(m, 0, 1, 2, 0, 1, 3)},
+      {-d_inv * _M_DET3x3(m, 1, 2, 3, 0, 1, 2),
+       d_inv * _M_DET3x3(m, 0, 2, 3, 0, 1, 2),
+       -d_inv * _M_DET3x3(m, 0, 1, 3, 0, 1, 2),
+       d_inv * _M_DET3x3(m, 0, 1, 2, 0, 1, 2)},
+  };
+  for (int row = 0; row < 4; row++)
+    for (int col = 0; col < 4; col++)
+      dst[row][col] = r[row][col];
+  return true;
+}
+
+}  // namespace internal
+
 //
 // Vector2
 //
@@ -444,11 +556,10 @@ class Vector3 {
     return Vector3(k[0] * scalar, k[1] * scalar, k[2] * scalar);
   }
 
+  // Transforms as a point, i.e. w = 1.
   Vector3 operator*(const Matrix4<T>& mat) {
     Vector3 r;
-    for (int i = 0; i < 3; i++)
-      r.k[i] = mat.k[0][i] * k[0] + mat.k[1][i] * k[1] + mat.k[2][i] * k[2] +
-               mat.k[3][i];
+    internal::Vector3TransformPoint(k, mat.k, r.k);
     return r;
   }
 
@@ -486,9 +597,7 @@ class Vector3 {
 
   void operator*=(const Matrix4<T>& mat) {
     Vector3 r;
-    for (int i = 0; i < 3; i++)
-      r.k[i] = mat.k[0][i] * k[0] + mat.k[1][i] * k[1] + mat.k[2][i] * k[2] +
-               mat.k[3][i];
+    internal::Vector3TransformPoint(k, mat.k, r.k);
     k[0] = r.k[0];
     k[1] = r.k[1];
     k[2] = r.k[2];
@@ -660,37 +769,41 @@ class Vector4 {
   }
 
   Vector4 operator+(const Vector4& other) const {
-    return Vector4(k[0] + other.k[0], k[1] + other.k[1], k[2] + other.k[2],
-                   k[3] + other.k[3]);
+    Vector4 r;
+    internal::Vector4Add(k, other.k, r.k);
+    return r;
   }
 
   Vector4 operator-(const Vector4& other) const {
-    return Vector4(k[0] - other.k[0], k[1] - other.k[1], k[2] - other.k[2],
-                   k[3] - other.k[3]);
+    Vector4 r;
+    internal::Vector4Sub(k, other.k, r.k);
+    return r;
   }
 
   Vector4 operator-() const { return Vector4(-k[0], -k[1], -k[2], -k[3]); }
 
   Vector4 operator*(const Vector4& other) const {
-    return Vector4(k[0] * other.k[0], k[1] * other.k[1], k[2] * other.k[2],
-                   k[3] * other.k[3]);
+    Vector4 r;
+    internal::Vector4Mul(k, other.k, r.k);
+    return r;
   }
 
   Vector4 operator*(T scalar) const {
-    return Vector4(k[0] * scalar, k[1] * scalar, k[2] * scalar, k[3] * scalar);
+    Vector4 r;
+    internal::Vector4Scale(k, scalar, r.k);
+    return r;
   }
 
   Vector4 operator*(const Matrix4<T>& mat) {
     Vector4 r;
-    for (int i = 0; i < 3; i++)
-      r.k[i] = mat.k[0][i] * k[0] + mat.k[1][i] * k[1] + mat.k[2][i] * k[2] +
-               mat.k[3][i] * k[3];
+    internal::Vector4Transform(k, mat.k, r.k);
     return r;
   }
 
   Vector4 operator/(const Vector4& other) const {
-    return Vector4(k[0] / other.k[0], k[1] / other.k[1], k[2] / other.k[2],
-                   k[3] / other.k[3]);
+    Vector4 r;
+    internal::Vector4Div(k, other.k, r.k);
+    return r;
   }
 
   Vector4 operator/(T scalar) const {
@@ -698,38 +811,22 @@ class Vector4 {
   }
 
   void operator+=(const Vector4& other) {
-    k[0] += other.k[0];
-    k[1] += other.k[1];
-    k[2] += other.k[2];
-    k[3] += other.k[3];
+    internal::Vector4Add(k, other.k, k);
   }
 
   void operator-=(const Vector4& other) {
-    k[0] -= other.k[0];
-    k[1] -= other.k[1];
-    k[2] -= other.k[2];
-    k[3] -= other.k[3];
+    internal::Vector4Sub(k, other.k, k);
   }
 
   void operator*=(const Vector4& other) {
-    k[0] *= other.k[0];
-    k[1] *= other.k[1];
-    k[2] *= other.k[2];
-    k[3] *= other.k[3];
+    internal::Vector4Mul(k, other.k, k);
   }
 
-  void operator*=(T v) {
-    k[0] *= v;
-    k[1] *= v;
-    k[2] *= v;
-    k[3] *= v;
-  }
+  void operator*=(T v) { internal::Vector4Scale(k, v, k); }
 
   void operator*=(const Matrix4<T>& mat) {
     Vector4 r;
-    for (int i = 0; i < 3; i++)
-      r.k[i] = mat.k[0][i] * k[0] + mat.k[1][i] * k[1] + mat.k[2][i] * k[2] +
-               mat.k[3][i] * k[3];
+    internal::Vector4Transform(k, mat.k, r.k);
     k[0] = r.k[0];
     k[1] = r.k[1];
     k[2] = r.k[2];
@@ -737,10 +834,7 @@ class Vector4 {
   }
 
   void operator/=(const Vector4& other) {
-    k[0] /= other.k[0];
-    k[1] /= other.k[1];
-    k[2] /= other.k[2];
-    k[3] /= other.k[3];
+    internal::Vector4Div(k, other.k, k);
   }
 
   void operator/=(T v) {
@@ -751,8 +845,7 @@ class Vector4 {
   }
 
   T DotProduct(const Vector4& other) const {
-    return k[0] * other.k[0] + k[1] * other.k[1] + k[2] * other.k[2] +
-           k[3] * other.k[3];
+    return internal::Vector4Dot(k, other.k);
   }
 
   T Length() const {
@@ -908,12 +1001,7 @@ class Matrix4 {
     std::swap(k[2][3], k[3][2]);
   }
 
-  void Transpose(Matrix4& dst) const {
-    _M_SET_ROW_D(dst, 0, (k[0][0]), (k[1][0]), (k[2][0]), (k[3][0]));
-    _M_SET_ROW_D(dst, 1, (k[0][1]), (k[1][1]), (k[2][1]), (k[3][1]));
-    _M_SET_ROW_D(dst, 2, (k[0][2]), (k[1][2]), (k[2][2]), (k[3][2]));
-    _M_SET_ROW_D(dst, 3, (k[0][3]), (k[1][3]), (k[2][3]), (k[3][3]));
-  }
+  void Transpose(Matrix4& dst) const { internal::Matrix4Transpose(k, dst.k); }
 
   void Transpose3x3() {
     std::swap(k[0][1], k[1][0]);
@@ -934,67 +1022,18 @@ class Matrix4 {
   }
 
   bool Inverse() {
-    T d = Determinant4x4((k[0][0]), (k[0][1]), (k[0][2]), (k[0][3]), (k[1][0]),
-                         (k[1][1]), (k[1][2]), (k[1][3]), (k[2][0]), (k[2][1]),
-                         (k[2][2]), (k[2][3]), (k[3][0]), (k[3][1]), (k[3][2]),
-                         (k[3][3]));
-    if (d == T(0.0)) {
+    if (!internal::Matrix4Inverse(k, k)) {
       Unit();
       return false;
     }
-
-    T d_inv = T(1.0) / d;
-    T k00 = d_inv * _M_DET3x3(k, 1, 2, 3, 1, 2, 3);
-    T k01 = -d_inv * _M_DET3x3(k, 0, 2, 3, 1, 2, 3);
-    T k02 = d_inv * _M_DET3x3(k, 0, 1, 3, 1, 2, 3);
-    T k03 = -d_inv * _M_DET3x3(k, 0, 1, 2, 1, 2, 3);
-    T k10 = -d_inv * _M_DET3x3(k, 1, 2, 3, 0, 2, 3);
-    T k11 = d_inv * _M_DET3x3(k, 0, 2, 3, 0, 2, 3);
-    T k12 = -d_inv * _M_DET3x3(k, 0, 1, 3, 0, 2, 3);
-    T k13 = d_inv * _M_DET3x3(k, 0, 1, 2, 0, 2, 3);
-    T k20 = d_inv * _M_DET3x3(k, 1, 2, 3, 0, 1, 3);
-    T k21 = -d_inv * _M_DET3x3(k, 0, 2, 3, 0, 1, 3);
-    T k22 = d_inv * _M_DET3x3(k, 0, 1, 3, 0, 1, 3);
-    T k23 = -d_inv * _M_DET3x3(k, 0, 1, 2, 0, 1, 3);
-    T k30 = -d_inv * _M_DET3x3(k, 1, 2, 3, 0, 1, 2);
-    T k31 = d_inv * _M_DET3x3(k, 0, 2, 3, 0, 1, 2);
-    T k32 = -d_inv * _M_DET3x3(k, 0, 1, 3, 0, 1, 2);
-    T k33 = d_inv * _M_DET3x3(k, 0, 1, 2, 0, 1, 2);
-
-    _M_SET_ROW(0, k00, k01, k02, k03);
-    _M_SET_ROW(1, k10, k11, k12, k13);
-    _M_SET_ROW(2, k20, k21, k22, k23);
-    _M_SET_ROW(3, k30, k31, k32, k33);
     return true;
   }
 
   bool Inverse(Matrix4& dst) const {
-    T d = Determinant4x4((k[0][0]), (k[0][1]), (k[0][2]), (k[0][3]), (k[1][0]),
-                         (k[1][1]), (k[1][2]), (k[1][3]), (k[2][0]), (k[2][1]),
-                         (k[2][2]), (k[2][3]), (k[3][0]), (k[3][1]), (k[3][2]),
-                         (k[3][3]));
-    if (d == T(0.0)) {
+    if (!internal::Matrix4Inverse(k, dst.k)) {
       dst.Unit();
       return false;
     }
-
-    T d_inv = T(1.0) / d;
-    dst.k[0][0] = d_inv * _M_DET3x3(k, 1, 2, 3, 1, 2, 3);
-    dst.k[0][1] = -d_inv * _M_DET3x3(k, 0, 2, 3, 1, 2, 3);
-    dst.k[0][2] = d_inv * _M_DET3x3(k, 0, 1, 3, 1, 2, 3);
-    dst.k[0][3] = -d_inv * _M_DET3x3(k, 0, 1, 2, 1, 2, 3);
-    dst.k[1][0] = -d_inv * _M_DET3x3(k, 1, 2, 3, 0, 2, 3);
-    dst.k[1][1] = d_inv * _M_DET3x3(k, 0, 2, 3, 0, 2, 3);
-    dst.k[1][2] = -d_inv * _M_DET3x3(k, 0, 1, 3, 0, 2, 3);
-    dst.k[1][3] = d_inv * _M_DET3x3(k, 0, 1, 2, 0, 2, 3);
-    dst.k[2][0] = d_inv * _M_DET3x3(k, 1, 2, 3, 0, 1, 3);
-    dst.k[2][1] = -d_inv * _M_DET3x3(k, 0, 2, 3, 0, 1, 3);
-    dst.k[2][2] = d_inv * _M_DET3x3(k, 0, 1, 3, 0, 1, 3);
-    dst.k[2][3] = -d_inv * _M_DET3x3(k, 0, 1, 2, 0, 1, 3);
-    dst.k[3][0] = -d_inv * _M_DET3x3(k, 1, 2, 3, 0, 1, 2);
-    dst.k[3][1] = d_inv * _M_DET3x3(k, 0, 2, 3, 0, 1, 2);
-    dst.k[3][2] = -d_inv * _M_DET3x3(k, 0, 1, 3, 0, 1, 2);
-    dst.k[3][3] = d_inv * _M_DET3x3(k, 0, 1, 2, 0, 1, 2);
     return true;
   }
 
@@ -1130,11 +1169,7 @@ class Matrix4 {
 
   // Multiply 4x4
   void Multiply(const Matrix4& m, Matrix4& dst) const {
-    for (int row = 0; row < 4; row++)
-      for (int col = 0; col < 4; col++)
-        dst.k[row][col] = (k[row][0] * m.k[0][col]) +
-                          (k[row][1] * m.k[1][col]) +
-                          (k[row][2] * m.k[2][col]) + (k[row][3] * m.k[3][col]);
+    internal::Matrix4Multiply(k, m.k, dst.k);
   }
 
   // Multiply 3x3
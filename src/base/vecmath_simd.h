@@ -0,0 +1,409 @@
+#ifndef BASE_VECMATH_SIMD_H
+#define BASE_VECMATH_SIMD_H
+
+// SIMD implementations of the hot Vector3<float>, Vector4<float> and
+// Matrix4<float> operations in vecmath.h. The backend is selected at compile
+// time: SSE2 (AVX for matrix multiplication if enabled) on x86 and NEON on
+// ARM64. Other targets, or builds with VECMATH_NO_SIMD defined, use the scalar
+// templates in vecmath.h.
+// The functions here are overloads of the scalar templates, so the scalar
+// version can be called explicitly for comparison, e.g.
+//   internal::Matrix4Multiply<float>(a.k, b.k, dst.k);
+// Unlike the scalar versions, all the inputs are read before the output is
+// written, so the output may alias any input.
+
+#if !defined(VECMATH_NO_SIMD)
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VECMATH_SSE2
+#include <emmintrin.h>
+#if defined(__AVX__)
+#define VECMATH_AVX
+#include <immintrin.h>
+#endif
+#elif defined(__aarch64__)
+#define VECMATH_NEON
+#include <arm_neon.h>
+#endif
+#endif
+
+#if defined(VECMATH_SSE2) || defined(VECMATH_NEON)
+#define VECMATH_SIMD
+#endif
+
+#if defined(VECMATH_SIMD)
+
+namespace base {
+
+namespace internal {
+
+//
+// Four-wide float vector primitives.
+//
+
+#if defined(VECMATH_SSE2)
+
+using F32x4 = __m128;
+
+inline F32x4 LoadF32x4(const float* src) {
+  return _mm_loadu_ps(src);
+}
+
+inline void StoreF32x4(float* dst, F32x4 v) {
+  _mm_storeu_ps(dst, v);
+}
+
+inline F32x4 SetF32x4(float x, float y, float z, float w) {
+  return _mm_setr_ps(x, y, z, w);
+}
+
+inline F32x4 SplatF32x4(float s) {
+  return _mm_set1_ps(s);
+}
+
+inline F32x4 Add(F32x4 a, F32x4 b) {
+  return _mm_add_ps(a, b);
+}
+
+inline F32x4 Sub(F32x4 a, F32x4 b) {
+  return _mm_sub_ps(a, b);
+}
+
+inline F32x4 Mul(F32x4 a, F32x4 b) {
+  return _mm_mul_ps(a, b);
+}
+
+inline F32x4 Div(F32x4 a, F32x4 b) {
+  return _mm_div_ps(a, b);
+}
+
+// Same as std::min(a, b) and std::max(a, b) in each lane.
+inline F32x4 Min(F32x4 a, F32x4 b) {
+  return _mm_min_ps(b, a);
+}
+
+inline F32x4 Max(F32x4 a, F32x4 b) {
+  return _mm_max_ps(b, a);
+}
+
+inline F32x4 Abs(F32x4 v) {
+  return _mm_andnot_ps(_mm_set1_ps(-0.0f), v);
+}
+
+// Comparisons return all bits set in the lanes where true.
+inline F32x4 CmpLt(F32x4 a, F32x4 b) {
+  return _mm_cmplt_ps(a, b);
+}
+
+inline F32x4 CmpLe(F32x4 a, F32x4 b) {
+  return _mm_cmple_ps(a, b);
+}
+
+inline F32x4 And(F32x4 a, F32x4 b) {
+  return _mm_and_ps(a, b);
+}
+
+// Returns the sign bits of the lanes, lane i in bit i.
+inline int MoveMask(F32x4 v) {
+  return _mm_movemask_ps(v);
+}
+
+// Returns (a[x], a[y], b[z], b[w]).
+template <int x, int y, int z, int w>
+inline F32x4 Shuffle(F32x4 a, F32x4 b) {
+  return _mm_shuffle_ps(a, b, _MM_SHUFFLE(w, z, y, x));
+}
+
+inline float GetX(F32x4 v) {
+  return _mm_cvtss_f32(v);
+}
+
+inline void Transpose(F32x4& r0, F32x4& r1, F32x4& r2, F32x4& r3) {
+  _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+}
+
+#elif defined(VECMATH_NEON)
+
+using F32x4 = float32x4_t;
+
+inline F32x4 LoadF32x4(const float* src) {
+  return vld1q_f32(src);
+}
+
+inline void StoreF32x4(float* dst, F32x4 v) {
+  vst1q_f32(dst, v);
+}
+
+inline F32x4 SetF32x4(float x, float y, float z, float w) {
+  return F32x4{x, y, z, w};
+}
+
+inline F32x4 SplatF32x4(float s) {
+  return vdupq_n_f32(s);
+}
+
+inline F32x4 Add(F32x4 a, F32x4 b) {
+  return vaddq_f32(a, b);
+}
+
+inline F32x4 Sub(F32x4 a, F32x4 b) {
+  return vsubq_f32(a, b);
+}
+
+inline F32x4 Mul(F32x4 a, F32x4 b) {
+  return vmulq_f32(a, b);
+}
+
+inline F32x4 Div(F32x4 a, F32x4 b) {
+  return vdivq_f32(a, b);
+}
+
+// Same as std::min(a, b) and std::max(a, b) in each lane.
+inline F32x4 Min(F32x4 a, F32x4 b) {
+  return vbslq_f32(vcltq_f32(b, a), b, a);
+}
+
+inline F32x4 Max(F32x4 a, F32x4 b) {
+  return vbslq_f32(vcltq_f32(a, b), b, a);
+}
+
+inline F32x4 Abs(F32x4 v) {
+  return vabsq_f32(v);
+}
+
+// Comparisons return all bits set in the lanes where true.
+inline F32x4 CmpLt(F32x4 a, F32x4 b) {
+  return vreinterpretq_f32_u32(vcltq_f32(a, b));
+}
+
+inline F32x4 CmpLe(F32x4 a, F32x4 b) {
+  return vreinterpretq_f32_u32(vcleq_f32(a, b));
+}
+
+inline F32x4 And(F32x4 a, F32x4 b) {
+  return vreinterpretq_f32_u32(
+      vandq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b)));
+}
+
+// Returns the sign bits of the lanes, lane i in bit i.
+inline int MoveMask(F32x4 v) {
+  uint32x4_t sign = vshrq_n_u32(vreinterpretq_u32_f32(v), 31);
+  return vaddvq_u32(vshlq_u32(sign, int32x4_t{0, 1, 2, 3}));
+}
+
+// Returns (a[x], a[y], b[z], b[w]).
+template <int x, int y, int z, int w>
+inline F32x4 Shuffle(F32x4 a, F32x4 b) {
+  return __builtin_shufflevector(a, b, x, y, z + 4, w + 4);
+}
+
+inline float GetX(F32x4 v) {
+  return vgetq_lane_f32(v, 0);
+}
+
+inline void Transpose(F32x4& r0, F32x4& r1, F32x4& r2, F32x4& r3) {
+  float32x4x2_t t01 = vtrnq_f32(r0, r1);
+  float32x4x2_t t23 = vtrnq_f32(r2, r3);
+  r0 = vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0]));
+  r1 = vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1]));
+  r2 = vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0]));
+  r3 = vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1]));
+}
+
+#endif
+
+// Returns v[i] in all lanes.
+template <int i>
+inline F32x4 Broadcast(F32x4 v) {
+  return Shuffle<i, i, i, i>(v, v);
+}
+
+// Returns the sum of all lanes in all lanes.
+inline F32x4 HorizontalSum(F32x4 v) {
+  v = Add(v, Shuffle<2, 3, 0, 1>(v, v));
+  return Add(v, Shuffle<1, 0, 3, 2>(v, v));
+}
+
+// v * m, where v is a row vector.
+inline F32x4 MultiplyRow(F32x4 v, F32x4 m0, F32x4 m1, F32x4 m2, F32x4 m3) {
+  F32x4 r = Mul(Broadcast<0>(v), m0);
+  r = Add(r, Mul(Broadcast<1>(v), m1));
+  r = Add(r, Mul(Broadcast<2>(v), m2));
+  return Add(r, Mul(Broadcast<3>(v), m3));
+}
+
+// 2x2 row-major matrix helpers for Matrix4Inverse.
+// a * b
+inline F32x4 Mat2Mul(F32x4 a, F32x4 b) {
+  return Add(Mul(a, Shuffle<0, 3, 0, 3>(b, b)),
+             Mul(Shuffle<1, 0, 3, 2>(a, a), Shuffle<2, 1, 2, 1>(b, b)));
+}
+
+// adjugate(a) * b
+inline F32x4 Mat2AdjMul(F32x4 a, F32x4 b) {
+  return Sub(Mul(Shuffle<3, 3, 0, 0>(a, a), b),
+             Mul(Shuffle<1, 1, 2, 2>(a, a), Shuffle<2, 3, 0, 1>(b, b)));
+}
+
+// a * adjugate(b)
+inline F32x4 Mat2MulAdj(F32x4 a, F32x4 b) {
+  return Sub(Mul(a, Shuffle<3, 0, 3, 0>(b, b)),
+             Mul(Shuffle<1, 0, 3, 2>(a, a), Shuffle<2, 1, 2, 1>(b, b)));
+}
+
+//
+// Vector4
+//
+
+inline void Vector4Add(const float a[4], const float b[4], float dst[4]) {
+  StoreF32x4(dst, Add(LoadF32x4(a), LoadF32x4(b)));
+}
+
+inline void Vector4Sub(const float a[4], const float b[4], float dst[4]) {
+  StoreF32x4(dst, Sub(LoadF32x4(a), LoadF32x4(b)));
+}
+
+inline void Vector4Mul(const float a[4], const float b[4], float dst[4]) {
+  StoreF32x4(dst, Mul(LoadF32x4(a), LoadF32x4(b)));
+}
+
+inline void Vector4Div(const float a[4], const float b[4], float dst[4]) {
+  StoreF32x4(dst, Div(LoadF32x4(a), LoadF32x4(b)));
+}
+
+inline void Vector4Scale(const float a[4], float s, float dst[4]) {
+  StoreF32x4(dst, Mul(LoadF32x4(a), SplatF32x4(s)));
+}
+
+inline float Vector4Dot(const float a[4], const float b[4]) {
+  return GetX(HorizontalSum(Mul(LoadF32x4(a), LoadF32x4(b))));
+}
+
+inline void Vector4Transform(const float v[4],
+                             const float m[4][4],
+                             float dst[4]) {
+  StoreF32x4(dst, MultiplyRow(LoadF32x4(v), LoadF32x4(m[0]), LoadF32x4(m[1]),
+                              LoadF32x4(m[2]), LoadF32x4(m[3])));
+}
+
+//
+// Vector3
+//
+
+inline void Vector3TransformPoint(const float p[3],
+                                  const float m[4][4],
+                                  float dst[3]) {
+  F32x4 r = Add(LoadF32x4(m[3]), Mul(SplatF32x4(p[0]), LoadF32x4(m[0])));
+  r = Add(r, Mul(SplatF32x4(p[1]), LoadF32x4(m[1])));
+  r = Add(r, Mul(SplatF32x4(p[2]), LoadF32x4(m[2])));
+  float result[4];
+  StoreF32x4(result, r);
+  dst[0] = result[0];
+  dst[1] = result[1];
+  dst[2] = result[2];
+}
+
+//
+// Matrix4
+//
+
+inline void Matrix4Multiply(const float a[4][4],
+                            const float b[4][4],
+                            float dst[4][4]) {
+#if defined(VECMATH_AVX)
+  // Two rows at a time.
+  __m256 b0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(b[0]));
+  __m256 b1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(b[1]));
+  __m256 b2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(b[2]));
+  __m256 b3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(b[3]));
+  for (int row = 0; row < 4; row += 2) {
+    __m256 a01 = _mm256_loadu_ps(a[row]);
+    __m256 r = _mm256_mul_ps(_mm256_shuffle_ps(a01, a01, 0x00), b0);
+    r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_shuffle_ps(a01, a01, 0x55), b1));
+    r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_shuffle_ps(a01, a01, 0xaa), b2));
+    r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_shuffle_ps(a01, a01, 0xff), b3));
+    _mm256_storeu_ps(dst[row], r);
+  }
+#else
+  F32x4 b0 = LoadF32x4(b[0]);
+  F32x4 b1 = LoadF32x4(b[1]);
+  F32x4 b2 = LoadF32x4(b[2]);
+  F32x4 b3 = LoadF32x4(b[3]);
+  for (int row = 0; row < 4; ++row)
+    StoreF32x4(dst[row], MultiplyRow(LoadF32x4(a[row]), b0, b1, b2, b3));
+#endif
+}
+
+inline void Matrix4Transpose(const float m[4][4], float dst[4][4]) {
+  F32x4 r0 = LoadF32x4(m[0]);
+  F32x4 r1 = LoadF32x4(m[1]);
+  F32x4 r2 = LoadF32x4(m[2]);
+  F32x4 r3 = LoadF32x4(m[3]);
+  Transpose(r0, r1, r2, r3);
+  StoreF32x4(dst[0], r0);
+  StoreF32x4(dst[1], r1);
+  StoreF32x4(dst[2], r2);
+  StoreF32x4(dst[3], r3);
+}
+
+// Blockwise inversion using 2x2 sub-matrices, see
+// https://lxjk.github.io/2017/09/03/Fast-4x4-Matrix-Inverse-with-SSE-SIMD-Explained.html
+// Leaves dst untouched and returns false if the matrix isn't invertible.
+inline bool Matrix4Inverse(const float m[4][4], float dst[4][4]) {
+  F32x4 r0 = LoadF32x4(m[0]);
+  F32x4 r1 = LoadF32x4(m[1]);
+  F32x4 r2 = LoadF32x4(m[2]);
+  F32x4 r3 = LoadF32x4(m[3]);
+
+  // Sub-matrices.
+  F32x4 a = Shuffle<0, 1, 0, 1>(r0, r1);
+  F32x4 b = Shuffle<2, 3, 2, 3>(r0, r1);
+  F32x4 c = Shuffle<0, 1, 0, 1>(r2, r3);
+  F32x4 d = Shuffle<2, 3, 2, 3>(r2, r3);
+
+  // Determinants of the sub-matrices as (|a|, |b|, |c|, |d|).
+  F32x4 det_sub =
+      Sub(Mul(Shuffle<0, 2, 0, 2>(r0, r2), Shuffle<1, 3, 1, 3>(r1, r3)),
+          Mul(Shuffle<1, 3, 1, 3>(r0, r2), Shuffle<0, 2, 0, 2>(r1, r3)));
+  F32x4 det_a = Broadcast<0>(det_sub);
+  F32x4 det_b = Broadcast<1>(det_sub);
+  F32x4 det_c = Broadcast<2>(det_sub);
+  F32x4 det_d = Broadcast<3>(det_sub);
+
+  // The inverse is 1 / |m| * | x y |
+  //                          | z w |
+  F32x4 d_c = Mat2AdjMul(d, c);
+  F32x4 a_b = Mat2AdjMul(a, b);
+  // Adjugates of x, y, z and w.
+  F32x4 x = Sub(Mul(det_d, a), Mat2Mul(b, d_c));
+  F32x4 w = Sub(Mul(det_a, d), Mat2Mul(c, a_b));
+  F32x4 y = Sub(Mul(det_b, c), Mat2MulAdj(d, a_b));
+  F32x4 z = Sub(Mul(det_c, b), Mat2MulAdj(a, d_c));
+
+  // |m| = |a| * |d| + |b| * |c| - trace(a_b * d_c)
+  F32x4 trace = HorizontalSum(Mul(a_b, Shuffle<0, 2, 1, 3>(d_c, d_c)));
+  F32x4 det_m = Sub(Add(Mul(det_a, det_d), Mul(det_b, det_c)), trace);
+  if (GetX(det_m) == 0.0f)
+    return false;
+
+  F32x4 det_m_inv = Div(SetF32x4(1, -1, -1, 1), det_m);
+  x = Mul(x, det_m_inv);
+  y = Mul(y, det_m_inv);
+  z = Mul(z, det_m_inv);
+  w = Mul(w, det_m_inv);
+
+  // Transform the adjugates back and store.
+  StoreF32x4(dst[0], Shuffle<3, 1, 3, 1>(x, y));
+  StoreF32x4(dst[1], Shuffle<2, 0, 2, 0>(x, y));
+  StoreF32x4(dst[2], Shuffle<3, 1, 3, 1>(z, w));
+  StoreF32x4(dst[3], Shuffle<2, 0, 2, 0>(z, w));
+  return true;
+}
+
+}  // namespace internal
+
+}  // namespace base
+
+#endif  // defined(VECMATH_SIMD)
+
+#endif  // BASE_VECMATH_SIMD_H
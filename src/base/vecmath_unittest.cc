@@ -0,0 +1,162 @@
+#include "base/vecmath.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "base/random.h"
+#include "base/unittest.h"
+
+using namespace base;
+
+// Compares the SIMD overloads in vecmath_simd.h with the scalar templates in
+// vecmath.h. Without SIMD both sides are the scalar code.
+
+namespace {
+
+constexpr int kIterations = 10000;
+
+// The SIMD versions may sum in a different order or use fused multiply-add.
+bool Near(float a, float b, float tolerance = 1e-5f) {
+  return std::abs(a - b) <=
+         tolerance * std::max({1.0f, std::abs(a), std::abs(b)});
+}
+
+template <size_t N>
+bool Near(const float (&a)[N], const float (&b)[N], float tolerance = 1e-5f) {
+  for (size_t i = 0; i < N; ++i) {
+    if (!Near(a[i], b[i], tolerance))
+      return false;
+  }
+  return true;
+}
+
+bool Near(const float (&a)[4][4], const float (&b)[4][4], float tolerance) {
+  for (int i = 0; i < 4; ++i) {
+    if (!Near(a[i], b[i], tolerance))
+      return false;
+  }
+  return true;
+}
+
+template <size_t N>
+void RandomFill(Random& random, float (&v)[N]) {
+  for (auto& x : v)
+    x = Lerp(-10.0f, 10.0f, random.Rand());
+}
+
+void RandomFill(Random& random, float (&m)[4][4]) {
+  for (auto& row : m)
+    RandomFill(random, row);
+}
+
+}  // namespace
+
+TEST(Vecmath, Vector4) {
+  Random random(1);
+  for (int i = 0; i < kIterations; ++i) {
+    float a[4], b[4], s[1], simd[4], scalar[4];
+    RandomFill(random, a);
+    RandomFill(random, b);
+    RandomFill(random, s);
+
+    internal::Vector4Add(a, b, simd);
+    internal::Vector4Add<float>(a, b, scalar);
+    EXPECT(Near(simd, scalar)) << "Add";
+
+    internal::Vector4Sub(a, b, simd);
+    internal::Vector4Sub<float>(a, b, scalar);
+    EXPECT(Near(simd, scalar)) << "Sub";
+
+    internal::Vector4Mul(a, b, simd);
+    internal::Vector4Mul<float>(a, b, scalar);
+    EXPECT(Near(simd, scalar)) << "Mul";
+
+    internal::Vector4Div(a, b, simd);
+    internal::Vector4Div<float>(a, b, scalar);
+    EXPECT(Near(simd, scalar)) << "Div";
+
+    internal::Vector4Scale(a, s[0], simd);
+    internal::Vector4Scale<float>(a, s[0], scalar);
+    EXPECT(Near(simd, scalar)) << "Scale";
+
+    EXPECT(Near(internal::Vector4Dot(a, b), internal::Vector4Dot<float>(a, b)))
+        << "Dot";
+  }
+}
+
+TEST(Vecmath, Transform) {
+  Random random(2);
+  for (int i = 0; i < kIterations; ++i) {
+    float m[4][4], v[4], p[3];
+    RandomFill(random, m);
+    RandomFill(random, v);
+    RandomFill(random, p);
+
+    float simd[4], scalar[4];
+    internal::Vector4Transform(v, m, simd);
+    internal::Vector4Transform<float>(v, m, scalar);
+    EXPECT(Near(simd, scalar)) << "Vector4Transform";
+
+    float simd3[3], scalar3[3];
+    internal::Vector3TransformPoint(p, m, simd3);
+    internal::Vector3TransformPoint<float>(p, m, scalar3);
+    EXPECT(Near(simd3, scalar3)) << "Vector3TransformPoint";
+
+    // A point is a Vector4 with w = 1.
+    float p4[4] = {p[0], p[1], p[2], 1};
+    internal::Vector4Transform<float>(p4, m, scalar);
+    EXPECT(Near(simd3[0], scalar[0]) && Near(simd3[1], scalar[1]) &&
+           Near(simd3[2], scalar[2]))
+        << "Vector3TransformPoint vs Vector4Transform";
+  }
+}
+
+TEST(Vecmath, Matrix4) {
+  Random random(3);
+  for (int i = 0; i < kIterations; ++i) {
+    float a[4][4], b[4][4], simd[4][4], scalar[4][4];
+    RandomFill(random, a);
+    RandomFill(random, b);
+
+    internal::Matrix4Multiply(a, b, simd);
+    internal::Matrix4Multiply<float>(a, b, scalar);
+    EXPECT(Near(simd, scalar, 1e-5f)) << "Multiply";
+
+    internal::Matrix4Transpose(a, simd);
+    internal::Matrix4Transpose<float>(a, scalar);
+    EXPECT(memcmp(simd, scalar, sizeof(simd)) == 0) << "Transpose";
+  }
+}
+
+TEST(Vecmath, Matrix4Inverse) {
+  Random random(4);
+  const float identity[4][4] = {
+      {1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0}, {0, 0, 0, 1}};
+  for (int i = 0; i < kIterations; ++i) {
+    // Diagonally dominant, so well conditioned.
+    float m[4][4];
+    RandomFill(random, m);
+    for (int j = 0; j < 4; ++j)
+      m[j][j] += m[j][j] < 0 ? -40 : 40;
+
+    float simd[4][4], scalar[4][4];
+    EXPECT(internal::Matrix4Inverse(m, simd));
+    EXPECT(internal::Matrix4Inverse<float>(m, scalar));
+    EXPECT(Near(simd, scalar, 1e-4f)) << "Inverse";
+
+    float product[4][4];
+    internal::Matrix4Multiply<float>(m, simd, product);
+    EXPECT(Near(product, identity, 1e-4f)) << "m * inverse(m)";
+  }
+
+  // Singular matrices leave dst untouched.
+  float singular[4][4] = {
+      {1, 2, 3, 4}, {2, 4, 6, 8}, {0, 1, 0, 1}, {1, 0, 1, 0}};
+  float dst[4][4], untouched[4][4];
+  RandomFill(random, dst);
+  memcpy(untouched, dst, sizeof(dst));
+  EXPECT(!internal::Matrix4Inverse(singular, dst));
+  EXPECT(!internal::Matrix4Inverse<float>(singular, dst));
+  EXPECT(memcmp(dst, untouched, sizeof(dst)) == 0);
+}
@@ -0,0 +1,125 @@
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/log.h"
+#include "benchmarks/benchmark.h"
+#include "engine/asset/font.h"
+#include "engine/asset/image.h"
+#include "engine/asset/mesh.h"
+#include "third_party/texture_compressor/texture_compressor.h"
+
+using namespace base;
+using namespace eng;
+
+namespace benchmarks {
+
+namespace {
+
+// 672x504 RGBA.
+const char kImageFile[] = "demo/nuke_pack_OK.png";
+const char kMeshFile[] = "teapot/teapot.mesh";
+const char kFontFile[] = "engine/RobotoMono-Regular.ttf";
+const char kText[] = "The quick brown fox jumps over the lazy dog";
+
+std::shared_ptr<Image> LoadImage(const Options& options) {
+  auto image = std::make_shared<Image>();
+  if (!image->Load(kImageFile, options.root_path))
+    return nullptr;
+  return image;
+}
+
+BenchmarkFn ImageLoad(const Options& options) {
+  if (!LoadImage(options))
+    return nullptr;
+  std::string root_path = options.root_path;
+  return [root_path](size_t iterations) -> void {
+    for (size_t i = 0; i < iterations; ++i) {
+      Image image;
+      image.Load(kImageFile, root_path);
+      DoNotOptimize(image.GetBuffer());
+    }
+  };
+}
+BENCHMARK("Image/Load", ImageLoad);
+
+// Includes the cost of copying the uncompressed image.
+BenchmarkFn ImageCompress(const Options& options) {
+  auto image = LoadImage(options);
+  if (!image)
+    return nullptr;
+  std::shared_ptr<TextureCompressor> tc =
+      TextureCompressor::Create(TextureCompressor::kFormatDXT5);
+  return [image, tc](size_t iterations) -> void {
+    for (size_t i = 0; i < iterations; ++i) {
+      Image compressed(*image);
+      compressed.Compress(tc.get());
+      DoNotOptimize(compressed.GetBuffer());
+    }
+  };
+}
+BENCHMARK("Image/Compress/DXT5", ImageCompress);
+
+template <TextureCompressor::Format kFormat>
+BenchmarkFn TextureCompressorCompress(const Options& options) {
+  auto image = LoadImage(options);
+  if (!image)
+    return nullptr;
+  std::shared_ptr<TextureCompressor> tc = TextureCompressor::Create(kFormat);
+  // Large enough for any format.
+  auto output = std::make_shared<std::vector<uint8_t>>(image->GetWidth() *
+                                                       image->GetHeight());
+  return [image, tc, output](size_t iterations) -> void {
+    for (size_t i = 0; i < iterations; ++i) {
+      tc->Compress(image->GetBuffer(), output->data(), image->GetWidth(),
+                   image->GetHeight(), TextureCompressor::kQualityHigh);
+      DoNotOptimize(output->front());
+    }
+  };
+}
+BENCHMARK("TextureCompressor/ATC",
+          TextureCompressorCompress<TextureCompressor::kFormatATC>);
+BENCHMARK("TextureCompressor/ATCIA",
+          TextureCompressorCompress<TextureCompressor::kFormatATCIA>);
+BENCHMARK("TextureCompressor/DXT1",
+          TextureCompressorCompress<TextureCompressor::kFormatDXT1>);
+BENCHMARK("TextureCompressor/DXT5",
+          TextureCompressorCompress<TextureCompressor::kFormatDXT5>);
+BENCHMARK("TextureCompressor/ETC1",
+          TextureCompressorCompress<TextureCompressor::kFormatETC1>);
+
+BenchmarkFn MeshLoad(const Options& options) {
+  if (!Mesh().Load(kMeshFile, options.root_path))
+    return nullptr;
+  std::string root_path = options.root_path;
+  return [root_path](size_t iterations) -> void {
+    for (size_t i = 0; i < iterations; ++i) {
+      Mesh mesh;
+      mesh.Load(kMeshFile, root_path);
+      DoNotOptimize(mesh.GetVertices());
+    }
+  };
+}
+BENCHMARK("Mesh/Load", MeshLoad);
+
+BenchmarkFn FontPrint(const Options& options) {
+  auto font = std::make_shared<Font>();
+  if (!font->Load(kFontFile, options.root_path))
+    return nullptr;
+  std::string text = kText;
+  int width, height;
+  font->CalculateBoundingBox(text, width, height);
+  auto image = std::make_shared<Image>();
+  image->Create(width, height);
+  return [font, image, text](size_t iterations) -> void {
+    for (size_t i = 0; i < iterations; ++i) {
+      font->Print(0, 0, text, image->GetBuffer(), image->GetWidth());
+      DoNotOptimize(image->GetBuffer());
+    }
+  };
+}
+BENCHMARK("Font/Print", FontPrint);
+
+}  // namespace
+
+}  // namespace benchmarks
@@ -0,0 +1,111 @@
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "base/vecmath.h"
+#include "benchmarks/benchmark.h"
+#include "engine/audio/audio_bus.h"
+#include "engine/audio/audio_device_null.h"
+#include "engine/audio/audio_mixer.h"
+#include "engine/audio/mixer_input.h"
+#include "engine/audio/sinc_resampler.h"
+
+using namespace base;
+using namespace eng;
+
+namespace benchmarks {
+
+namespace {
+
+constexpr size_t kSampleRate = 48000;
+// Frames rendered per RenderAudio call. Typical for ALSA.
+constexpr size_t kFramesPerBuffer = 512;
+
+void FillSine(float* buffer, size_t num_samples, float frequency) {
+  for (size_t i = 0; i < num_samples; ++i)
+    buffer[i] = std::sin(PI2d * frequency * i / kSampleRate);
+}
+
+// A second of a mono sine wave. Non-streaming.
+class ToneAudioBus final : public AudioBus {
+ public:
+  explicit ToneAudioBus(float frequency) {
+    auto samples = std::make_unique<float[]>(kSampleRate);
+    FillSine(samples.get(), kSampleRate, frequency);
+    SetAudioConfig(1, kSampleRate);
+    FromInterleaved(std::move(samples), kSampleRate, kSampleRate);
+  }
+  ~ToneAudioBus() final = default;
+
+  // AudioBus interface
+  void Stream(bool loop) final {}
+  void SwapBuffers() final {}
+  void ResetStream() final {}
+  bool EndOfStream() const final { return true; }
+};
+
+// Converts 44.1 kHz to 48 kHz, a chunk per iteration.
+BenchmarkFn SincResamplerResample(const Options& options) {
+  auto resampler = std::make_shared<SincResampler>(
+      44100.0 / 48000.0, SincResampler::kDefaultRequestSize);
+  // Keeps the chunk size from growing after the first calls.
+  resampler->PrimeWithSilence();
+  auto output = std::shared_ptr<float[]>(new float[resampler->ChunkSize()]);
+  auto input = std::shared_ptr<float[]>(
+      new float[SincResampler::kDefaultRequestSize]);
+  FillSine(input.get(), SincResampler::kDefaultRequestSize, 440);
+  return [resampler, output, input](size_t iterations) -> void {
+    for (size_t i = 0; i < iterations; ++i) {
+      resampler->Resample(resampler->ChunkSize(), output.get(),
+                          [&](int frames, float* destination) -> void {
+                            memcpy(destination, input.get(),
+                                   frames * sizeof(float));
+                          });
+      DoNotOptimize(output[0]);
+    }
+  };
+}
+BENCHMARK("SincResampler/Resample", SincResamplerResample);
+
+// Renders a buffer with the given number of looping voices.
+template <int kNumVoices>
+BenchmarkFn AudioMixerRenderAudio(const Options& options) {
+  struct State {
+    AudioDeviceNull* device = nullptr;
+    std::unique_ptr<AudioMixer> mixer;
+    std::vector<std::shared_ptr<MixerInput>> voices;
+    std::vector<float> buffer;
+  };
+  auto state = std::make_shared<State>();
+  state->mixer = std::make_unique<AudioMixer>(
+      [state = state.get()](AudioDevice::Delegate* delegate)
+          -> std::unique_ptr<AudioDevice> {
+        auto device = std::make_unique<AudioDeviceNull>(delegate, kSampleRate);
+        state->device = device.get();
+        return device;
+      });
+  for (int i = 0; i < kNumVoices; ++i) {
+    auto voice = MixerInput::Create();
+    voice->SetAudioBus(std::make_shared<ToneAudioBus>(220.0f + i * 20));
+    voice->SetLoop(true);
+    voice->SetSimulateStereo(i % 2 == 1);
+    voice->SetAmplitude(1.0f / kNumVoices);
+    voice->Play(state->mixer.get(), true);
+    state->voices.push_back(std::move(voice));
+  }
+  state->buffer.resize(kFramesPerBuffer * 2);
+  return [state](size_t iterations) -> void {
+    for (size_t i = 0; i < iterations; ++i) {
+      state->device->RenderAudio(state->buffer.data(), kFramesPerBuffer);
+      DoNotOptimize(state->buffer[0]);
+    }
+  };
+}
+BENCHMARK("AudioMixer/RenderAudio/1", AudioMixerRenderAudio<1>);
+BENCHMARK("AudioMixer/RenderAudio/8", AudioMixerRenderAudio<8>);
+BENCHMARK("AudioMixer/RenderAudio/32", AudioMixerRenderAudio<32>);
+
+}  // namespace
+
+}  // namespace benchmarks
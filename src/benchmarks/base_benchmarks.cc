@@ -0,0 +1,513 @@
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "base/asset_id.h"
+#include "base/collusion_test.h"
+#include "base/concurrent_stack.h"
+#include "base/flat_hash_map.h"
+#include "base/hash.h"
+#include "base/random.h"
+#include "base/spatial_grid.h"
+#include "base/task_group.h"
+#include "base/task_runner.h"
+#include "base/thread_pool.h"
+#include "base/transform_batch.h"
+#include "base/vecmath.h"
+#include "benchmarks/benchmark.h"
+
+using namespace base;
+
+namespace benchmarks {
+
+namespace {
+
+// Posts and runs tasks on a single consumer.
+BenchmarkFn TaskRunnerPostAndRun(const Options& options) {
+  auto task_runner = std::make_shared<TaskRunner>();
+  return [task_runner](size_t iterations) -> void {
+    size_t count = 0;
+    for (size_t i = 0; i < iterations; ++i)
+      task_runner->PostTask(HERE, [&count]() -> void { ++count; });
+    task_runner->RunTasks<Consumer::Single>();
+    DoNotOptimize(count);
+  };
+}
+BENCHMARK("TaskRunner/PostAndRun", TaskRunnerPostAndRun);
+
+// Posts and runs tasks that capture 32 bytes. The /StdFunction variant wraps
+// the same lambda in a std::function first, as tasks were posted before
+// OnceClosure, for comparison. The capture is too big for the inline storage of
+// std::function, but not for OnceClosure.
+template <bool kStdFunction>
+BenchmarkFn TaskRunnerPostTask(const Options& options) {
+  auto task_runner = std::make_shared<TaskRunner>();
+  return [task_runner](size_t iterations) -> void {
+    size_t count = 0;
+    for (size_t i = 0; i < iterations; ++i) {
+      auto task = [&count, a = i, b = i + 1, c = i + 2]() -> void {
+        count += a + b + c;
+      };
+      if constexpr (kStdFunction)
+        task_runner->PostTask(HERE, Closure(std::move(task)));
+      else
+        task_runner->PostTask(HERE, std::move(task));
+    }
+    task_runner->RunTasks<Consumer::Single>();
+    DoNotOptimize(count);
+  };
+}
+BENCHMARK("TaskRunner/PostTask/OnceClosure", TaskRunnerPostTask<false>);
+BENCHMARK("TaskRunner/PostTask/StdFunction", TaskRunnerPostTask<true>);
+
+// Posts tasks from a non-worker thread and waits for the pool to run them.
+BenchmarkFn ThreadPoolPostAndRun(const Options& options) {
+  auto thread_pool = std::make_shared<ThreadPool>();
+  thread_pool->Initialize();
+  return [thread_pool](size_t iterations) -> void {
+    std::atomic<size_t> remaining{iterations};
+    for (size_t i = 0; i < iterations; ++i) {
+      thread_pool->PostTask(HERE, [&remaining]() -> void {
+        if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+          remaining.notify_one();
+      });
+    }
+    for (size_t n; (n = remaining.load(std::memory_order_acquire)) != 0;)
+      remaining.wait(n);
+  };
+}
+BENCHMARK("ThreadPool/PostAndRun", ThreadPoolPostAndRun);
+
+// Splits 64K elements into 1K element chunks.
+BenchmarkFn ThreadPoolParallelFor(const Options& options) {
+  auto thread_pool = std::make_shared<ThreadPool>();
+  thread_pool->Initialize();
+  auto data = std::make_shared<std::vector<float>>(64 * 1024, 1.0f);
+  return [thread_pool, data](size_t iterations) -> void {
+    for (size_t i = 0; i < iterations; ++i) {
+      ParallelFor(HERE, 0, data->size(), 1024,
+                  [&](size_t begin, size_t end) -> void {
+                    for (size_t j = begin; j < end; ++j)
+                      (*data)[j] = (*data)[j] * 0.5f + 0.5f;
+                  });
+    }
+    DoNotOptimize(data->front());
+  };
+}
+BENCHMARK("ThreadPool/ParallelFor/64K", ThreadPoolParallelFor);
+
+// Each thread pushes and pops an item per iteration on a shared stack.
+template <int kNumThreads>
+BenchmarkFn ConcurrentStackPushPop(const Options& options) {
+  auto stack = std::make_shared<ConcurrentStack<int>>();
+  return [stack](size_t iterations) -> void {
+    auto push_pop = [&]() -> void {
+      int item = 0;
+      for (size_t i = 0; i < iterations; ++i) {
+        stack->Push(int(i));
+        stack->Pop(item);
+      }
+      DoNotOptimize(item);
+    };
+    std::vector<std::thread> threads;
+    for (int i = 1; i < kNumThreads; ++i)
+      threads.emplace_back(push_pop);
+    push_pop();
+    for (auto& thread : threads)
+      thread.join();
+  };
+}
+BENCHMARK("ConcurrentStack/PushPop/1", ConcurrentStackPushPop<1>);
+BENCHMARK("ConcurrentStack/PushPop/4", ConcurrentStackPushPop<4>);
+BENCHMARK("ConcurrentStack/PushPop/8", ConcurrentStackPushPop<8>);
+
+// The vecmath benchmarks come in pairs. The /Scalar variant calls the scalar
+// implementation directly for comparison with the SIMD one, if any.
+template <bool kScalar>
+BenchmarkFn Matrix4Multiply(const Options& options) {
+  return [](size_t iterations) -> void {
+    Matrix4f a, b, result;
+    a.CreateAxisRotation(Vector3f(0, 1, 0), 0.5f);
+    b.CreatePerspectiveProjection(1.0f, 1.0f, 800, 600, 0.1f, 100.0f);
+    for (size_t i = 0; i < iterations; ++i) {
+      // Keeps the multiplication from being hoisted out of the loop.
+      DoNotOptimize(a);
+      if constexpr (kScalar)
+        base::internal::Matrix4Multiply<float>(a.k, b.k, result.k);
+      else
+        a.Multiply(b, result);
+      DoNotOptimize(result);
+    }
+  };
+}
+BENCHMARK("Matrix4/Multiply", Matrix4Multiply<false>);
+BENCHMARK("Matrix4/Multiply/Scalar", Matrix4Multiply<true>);
+
+template <bool kScalar>
+BenchmarkFn Matrix4Inverse(const Options& options) {
+  return [](size_t iterations) -> void {
+    Matrix4f m, result;
+    m.CreateAxisRotation(Vector3f(1, 1, 0).Normalize(), 0.5f);
+    m.k[3][0] = 1;
+    m.k[3][1] = 2;
+    m.k[3][2] = 3;
+    for (size_t i = 0; i < iterations; ++i) {
+      DoNotOptimize(m);
+      if constexpr (kScalar)
+        base::internal::Matrix4Inverse<float>(m.k, result.k);
+      else
+        m.Inverse(result);
+      DoNotOptimize(result);
+    }
+  };
+}
+BENCHMARK("Matrix4/Inverse", Matrix4Inverse<false>);
+BENCHMARK("Matrix4/Inverse/Scalar", Matrix4Inverse<true>);
+
+template <bool kScalar>
+BenchmarkFn Matrix4Transpose(const Options& options) {
+  return [](size_t iterations) -> void {
+    Matrix4f m, result;
+    m.CreatePerspectiveProjection(1.0f, 1.0f, 800, 600, 0.1f, 100.0f);
+    for (size_t i = 0; i < iterations; ++i) {
+      DoNotOptimize(m);
+      if constexpr (kScalar)
+        base::internal::Matrix4Transpose<float>(m.k, result.k);
+      else
+        m.Transpose(result);
+      DoNotOptimize(result);
+    }
+  };
+}
+BENCHMARK("Matrix4/Transpose", Matrix4Transpose<false>);
+BENCHMARK("Matrix4/Transpose/Scalar", Matrix4Transpose<true>);
+
+// Transforms 1K homogeneous points.
+template <bool kScalar>
+BenchmarkFn Vector4Transform(const Options& options) {
+  auto points = std::make_shared<std::vector<Vector4f>>(1024);
+  for (size_t i = 0; i < points->size(); ++i)
+    (*points)[i] = Vector4f(float(i), float(i) * 0.5f, 1, 1);
+  return [points](size_t iterations) -> void {
+    Matrix4f m;
+    m.CreateAxisRotation(Vector3f(0, 0, 1), 0.1f);
+    for (size_t i = 0; i < iterations; ++i) {
+      for (auto& point : *points) {
+        Vector4f r;
+        if constexpr (kScalar)
+          base::internal::Vector4Transform<float>(point.k, m.k, r.k);
+        else
+          r = point * m;
+        point = r;
+      }
+      DoNotOptimize(points->front());
+    }
+  };
+}
+BENCHMARK("Vector4/Transform/1K", Vector4Transform<false>);
+BENCHMARK("Vector4/Transform/1K/Scalar", Vector4Transform<true>);
+
+// Computes a * b + c and a dot product for 1K vectors.
+template <bool kScalar>
+BenchmarkFn Vector4Arithmetic(const Options& options) {
+  auto vectors = std::make_shared<std::vector<Vector4f>>(1024);
+  for (size_t i = 0; i < vectors->size(); ++i)
+    (*vectors)[i] = Vector4f(float(i), 1, float(i) * 0.5f, 1);
+  return [vectors](size_t iterations) -> void {
+    Vector4f a(0.5f, 0.25f, 0.75f, 1), c(1, 2, 3, 4);
+    float sum = 0;
+    for (size_t i = 0; i < iterations; ++i) {
+      for (auto& v : *vectors) {
+        if constexpr (kScalar) {
+          base::internal::Vector4Mul<float>(a.k, v.k, v.k);
+          base::internal::Vector4Add<float>(v.k, c.k, v.k);
+          sum += base::internal::Vector4Dot<float>(v.k, a.k);
+        } else {
+          v = a * v + c;
+          sum += v.DotProduct(a);
+        }
+      }
+      DoNotOptimize(sum);
+    }
+  };
+}
+BENCHMARK("Vector4/Arithmetic/1K", Vector4Arithmetic<false>);
+BENCHMARK("Vector4/Arithmetic/1K/Scalar", Vector4Arithmetic<true>);
+
+// Transforms 1K points.
+template <bool kScalar>
+BenchmarkFn Vector3Transform(const Options& options) {
+  auto points = std::make_shared<std::vector<Vector3f>>(1024);
+  for (size_t i = 0; i < points->size(); ++i)
+    (*points)[i] = Vector3f(float(i), float(i) * 0.5f, 1);
+  return [points](size_t iterations) -> void {
+    Matrix4f m;
+    m.CreateAxisRotation(Vector3f(0, 0, 1), 0.1f);
+    for (size_t i = 0; i < iterations; ++i) {
+      for (auto& point : *points) {
+        Vector3f r;
+        if constexpr (kScalar)
+          base::internal::Vector3TransformPoint<float>(point.k, m.k, r.k);
+        else
+          r = point * m;
+        point = r;
+      }
+      DoNotOptimize(points->front());
+    }
+  };
+}
+BENCHMARK("Vector3/Transform/1K", Vector3Transform<false>);
+BENCHMARK("Vector3/Transform/1K/Scalar", Vector3Transform<true>);
+
+// Normalizes 1K vectors.
+BenchmarkFn Vector3Normalize(const Options& options) {
+  auto vectors = std::make_shared<std::vector<Vector3f>>(1024);
+  return [vectors](size_t iterations) -> void {
+    for (size_t i = 0; i < iterations; ++i) {
+      for (size_t j = 0; j < vectors->size(); ++j) {
+        (*vectors)[j] = Vector3f(float(j + 1), float(i), 1);
+        (*vectors)[j].Normalize();
+      }
+      DoNotOptimize(vectors->front());
+    }
+  };
+}
+BENCHMARK("Vector3/Normalize/1K", Vector3Normalize);
+
+// Transforms 1K sprites into quad vertices.
+template <bool kScalar>
+BenchmarkFn TransformBatchTransform(const Options& options) {
+  auto batch = std::make_shared<TransformBatch>();
+  for (size_t i = 0; i < 1024; ++i) {
+    float theta = float(i) * 0.01f;
+    batch->Add({float(i), float(i) * 0.5f}, {32, 16},
+               {std::sin(theta), std::cos(theta)}, {float(i % 4), 0},
+               {0.25f, 1});
+  }
+  auto vertices = std::make_shared<std::vector<TransformBatch::Vertex>>(
+      batch->GetNumVertices());
+  return [batch, vertices](size_t iterations) -> void {
+    for (size_t i = 0; i < iterations; ++i) {
+      if constexpr (kScalar)
+        batch->TransformScalar(vertices->data());
+      else
+        batch->Transform(vertices->data());
+      DoNotOptimize(vertices->front());
+    }
+  };
+}
+BENCHMARK("TransformBatch/1K", TransformBatchTransform<false>);
+BENCHMARK("TransformBatch/1K/Scalar", TransformBatchTransform<true>);
+
+// Looks up 1K keys in a map of 256 assets. Keys are either asset names or
+// interned asset ids.
+template <typename Map>
+BenchmarkFn MapFind(const Options& options) {
+  using Key = typename Map::key_type;
+  auto map = std::make_shared<Map>();
+  auto keys = std::make_shared<std::vector<Key>>();
+  for (int i = 0; i < 256; ++i) {
+    std::string name = "engine/asset_" + std::to_string(i) + ".png";
+    (*map)[Key(name)] = i;
+  }
+  for (int i = 0; i < 1024; ++i)
+    keys->push_back(
+        Key("engine/asset_" + std::to_string(i * 7 % 256) + ".png"));
+  return [map, keys](size_t iterations) -> void {
+    int sum = 0;
+    for (size_t i = 0; i < iterations; ++i) {
+      for (auto& key : *keys)
+        sum += map->find(key)->second;
+      DoNotOptimize(sum);
+    }
+  };
+}
+using StringUnorderedMap = std::unordered_map<std::string, int>;
+using StringFlatHashMap = FlatHashMap<std::string, int>;
+using AssetIdFlatHashMap = FlatHashMap<AssetId, int>;
+BENCHMARK("HashMap/Find/1K/String/Unordered", MapFind<StringUnorderedMap>);
+BENCHMARK("HashMap/Find/1K/String/Flat", MapFind<StringFlatHashMap>);
+BENCHMARK("HashMap/Find/1K/AssetId/Flat", MapFind<AssetIdFlatHashMap>);
+
+// Tests a ray or a point against 1K boxes.
+template <bool kScalar>
+BenchmarkFn IntersectBoxes(bool ray) {
+  struct Boxes {
+    std::vector<float> center_x, center_y, size_x, size_y;
+    std::vector<uint32_t> hit_mask;
+    std::vector<float> entry_distance;
+  };
+  auto boxes = std::make_shared<Boxes>();
+  Random random(1);
+  for (size_t i = 0; i < 1024; ++i) {
+    boxes->center_x.push_back(Lerp(-100.0f, 100.0f, random.Rand()));
+    boxes->center_y.push_back(Lerp(0.0f, 200.0f, random.Rand()));
+    boxes->size_x.push_back(Lerp(4.0f, 16.0f, random.Rand()));
+    boxes->size_y.push_back(Lerp(4.0f, 16.0f, random.Rand()));
+  }
+  boxes->hit_mask.resize(HitMaskSize(1024));
+  boxes->entry_distance.resize(1024);
+  return [boxes, ray](size_t iterations) -> void {
+    BoxArrays arrays = {boxes->center_x.data(), boxes->center_y.data(),
+                        boxes->size_x.data(), boxes->size_y.data(), 1024};
+    Vector2f origin(0, -10);
+    Vector2f dir = Vector2f(0.3f, 1).Normalize();
+    Vector2f point(10, 100);
+    for (size_t i = 0; i < iterations; ++i) {
+      size_t num_hits = 0;
+      if constexpr (kScalar) {
+        for (size_t j = 0; j < 1024; ++j) {
+          Vector2f center(arrays.center_x[j], arrays.center_y[j]);
+          Vector2f size(arrays.size_x[j], arrays.size_y[j]);
+          bool hit = ray ? Intersection(center, size, origin, dir,
+                                         &boxes->entry_distance[j])
+                          : Intersection(center, size, point);
+          num_hits += hit;
+        }
+      } else if (ray) {
+        num_hits = Intersection(arrays, origin, dir, boxes->hit_mask.data(),
+                                boxes->entry_distance.data());
+      } else {
+        num_hits = Intersection(arrays, point, boxes->hit_mask.data());
+      }
+      DoNotOptimize(num_hits);
+    }
+  };
+}
+BENCHMARK("Intersection/Ray/1K",
+          [](const Options&) { return IntersectBoxes<false>(true); });
+BENCHMARK("Intersection/Ray/1K/Scalar",
+          [](const Options&) { return IntersectBoxes<true>(true); });
+BENCHMARK("Intersection/Point/1K",
+          [](const Options&) { return IntersectBoxes<false>(false); });
+BENCHMARK("Intersection/Point/1K/Scalar",
+          [](const Options&) { return IntersectBoxes<true>(false); });
+
+// Finds the boxes that are obstructed by another box when seen from a common
+// origin, as done for enemy targeting. Either brute force, which is O(n^2), or
+// with a spatial grid that is rebuilt every iteration.
+template <bool kBruteForce>
+BenchmarkFn FindObstructed(size_t count) {
+  struct Box {
+    Vector2f center;
+    Vector2f size;
+  };
+  auto boxes = std::make_shared<std::vector<Box>>();
+  Random random(1);
+  for (size_t i = 0; i < count; ++i) {
+    boxes->push_back({{Lerp(-200.0f, 200.0f, random.Rand()),
+                       Lerp(0.0f, 400.0f, random.Rand())},
+                      {Lerp(2.0f, 4.0f, random.Rand()),
+                       Lerp(2.0f, 4.0f, random.Rand())}});
+  }
+  auto grid = std::make_shared<SpatialGrid<const Box*>>(8.0f);
+  return [boxes, grid](size_t iterations) -> void {
+    Vector2f origin(0, -10);
+    for (size_t i = 0; i < iterations; ++i) {
+      if constexpr (!kBruteForce) {
+        grid->Clear();
+        for (auto& box : *boxes)
+          grid->Insert(&box, box.center, box.size);
+      }
+      int num_obstructed = 0;
+      for (auto& box : *boxes) {
+        Vector2f dir = box.center - origin;
+        float dist = dir.Length();
+        dir.Normalize();
+        auto is_obstacle = [&](const Box& other) -> bool {
+          return &other != &box &&
+                 (other.center - origin).Length() <= dist &&
+                 Intersection(other.center, other.size, origin, dir);
+        };
+        if constexpr (kBruteForce) {
+          for (auto& other : *boxes) {
+            if (is_obstacle(other)) {
+              ++num_obstructed;
+              break;
+            }
+          }
+        } else {
+          float max_distance = dist + grid->max_item_size().Length() / 2;
+          grid->QueryRay(origin, dir, max_distance, [&](const Box* other) {
+            if (!is_obstacle(*other))
+              return true;
+            ++num_obstructed;
+            return false;
+          });
+        }
+      }
+      DoNotOptimize(num_obstructed);
+    }
+  };
+}
+BENCHMARK("SpatialGrid/Obstruction/256",
+          [](const Options&) { return FindObstructed<false>(256); });
+BENCHMARK("SpatialGrid/Obstruction/256/BruteForce",
+          [](const Options&) { return FindObstructed<true>(256); });
+BENCHMARK("SpatialGrid/Obstruction/1K",
+          [](const Options&) { return FindObstructed<false>(1024); });
+BENCHMARK("SpatialGrid/Obstruction/1K/BruteForce",
+          [](const Options&) { return FindObstructed<true>(1024); });
+
+// Generates 1K randoms between 0 and 1, one at a time, in a batch, and with
+// std::mt19937 for reference.
+BenchmarkFn RandomRand(const Options& options) {
+  auto values = std::make_shared<std::vector<float>>(1024);
+  return [values](size_t iterations) -> void {
+    Random random(1);
+    for (size_t i = 0; i < iterations; ++i) {
+      for (auto& value : *values)
+        value = random.Rand();
+      DoNotOptimize(values->front());
+    }
+  };
+}
+BENCHMARK("Random/Rand/1K", RandomRand);
+
+BenchmarkFn RandomFill(const Options& options) {
+  auto values = std::make_shared<std::vector<float>>(1024);
+  return [values](size_t iterations) -> void {
+    Random random(1);
+    for (size_t i = 0; i < iterations; ++i) {
+      random.Fill(*values);
+      DoNotOptimize(values->front());
+    }
+  };
+}
+BENCHMARK("Random/Fill/1K", RandomFill);
+
+BenchmarkFn RandomMt19937(const Options& options) {
+  auto values = std::make_shared<std::vector<float>>(1024);
+  return [values](size_t iterations) -> void {
+    std::mt19937 generator(1);
+    std::uniform_real_distribution<float> distribution(0, 1);
+    for (size_t i = 0; i < iterations; ++i) {
+      for (auto& value : *values)
+        value = distribution(generator);
+      DoNotOptimize(values->front());
+    }
+  };
+}
+BENCHMARK("Random/Rand/1K/MT19937", RandomMt19937);
+
+template <size_t kLength>
+BenchmarkFn HashString(const Options& options) {
+  return [](size_t iterations) -> void {
+    std::string str(kLength, 'x');
+    for (size_t i = 0; i < iterations; ++i) {
+      str[i % kLength] = char('a' + i % 26);
+      DoNotOptimize(KR2Hash(str));
+    }
+  };
+}
+BENCHMARK("KR2Hash/16", HashString<16>);
+BENCHMARK("KR2Hash/256", HashString<256>);
+
+}  // namespace
+
+}  // namespace benchmarks
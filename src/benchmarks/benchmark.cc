@@ -0,0 +1,153 @@
+#include "benchmarks/benchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <sstream>
+#include <utility>
+
+#include "base/file.h"
+#include "base/log.h"
+#include "base/timer.h"
+#include "third_party/jsoncpp/json.h"
+
+using namespace base;
+
+namespace benchmarks {
+
+namespace {
+
+constexpr size_t kMaxIterations = size_t{1} << 30;
+
+std::vector<std::pair<const char*, BenchmarkFactory>>& GetRegistry() {
+  static std::vector<std::pair<const char*, BenchmarkFactory>> registry;
+  return registry;
+}
+
+// Returns seconds per iteration.
+double Measure(BenchmarkFn& fn, size_t iterations) {
+  ElapsedTimer timer;
+  fn(iterations);
+  return timer.Elapsed() / iterations;
+}
+
+// Finds the number of iterations that takes at least min_time seconds.
+size_t Calibrate(BenchmarkFn& fn, double min_time) {
+  size_t iterations = 1;
+  for (;;) {
+    ElapsedTimer timer;
+    fn(iterations);
+    double elapsed = timer.Elapsed();
+    if (elapsed >= min_time || iterations >= kMaxIterations)
+      return iterations;
+    // Aim 20% over the target, but grow at most 10x at a time so that a
+    // too-short first measurement doesn't overshoot.
+    double scale = elapsed > 0 ? min_time * 1.2 / elapsed : 10;
+    iterations = std::min(
+        kMaxIterations, std::max(iterations + 1,
+                                 size_t(iterations * std::min(scale, 10.0))));
+  }
+}
+
+// Nearest-rank percentile of sorted samples.
+double Percentile(const std::vector<double>& sorted, double p) {
+  size_t rank = size_t(std::ceil(p / 100 * sorted.size()));
+  return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+
+}  // namespace
+
+void RegisterBenchmark(const char* name, BenchmarkFactory factory) {
+  GetRegistry().emplace_back(name, factory);
+}
+
+std::vector<std::string> GetBenchmarkNames() {
+  std::vector<std::string> names;
+  for (auto& [name, factory] : GetRegistry())
+    names.push_back(name);
+  return names;
+}
+
+std::vector<Result> RunBenchmarks(const Options& options) {
+  DCHECK(options.repetitions > 0);
+
+  std::vector<Result> results;
+  for (auto& [name, factory] : GetRegistry()) {
+    if (std::string(name).find(options.filter) == std::string::npos)
+      continue;
+
+    BenchmarkFn fn = factory(options);
+    if (!fn) {
+      printf("%-48s skipped\n", name);
+      continue;
+    }
+
+    size_t iterations = Calibrate(fn, options.min_repetition_time);
+    for (int i = 0; i < options.warmup_repetitions; ++i)
+      Measure(fn, iterations);
+
+    std::vector<double> samples;
+    for (int i = 0; i < options.repetitions; ++i)
+      samples.push_back(Measure(fn, iterations) * 1e9);
+    std::sort(samples.begin(), samples.end());
+    // Tear down before running the next benchmark.
+    fn = nullptr;
+
+    Result result;
+    result.name = name;
+    result.iterations = iterations;
+    result.repetitions = options.repetitions;
+    result.min = samples.front();
+    result.median = Percentile(samples, 50);
+    result.p99 = Percentile(samples, 99);
+    printf("%-48s %12.1f %12.1f %12.1f ns %10zu\n", name, result.min,
+           result.median, result.p99, iterations);
+    fflush(stdout);
+    results.push_back(std::move(result));
+  }
+  return results;
+}
+
+bool WriteJson(const std::vector<Result>& results,
+               const std::string& file_path) {
+  Json::Value root;
+  Json::Value& benchmarks = root["benchmarks"];
+  benchmarks = Json::Value(Json::arrayValue);
+  for (auto& result : results) {
+    Json::Value entry;
+    entry["name"] = result.name;
+    entry["iterations"] = Json::UInt64(result.iterations);
+    entry["repetitions"] = result.repetitions;
+    entry["min_ns"] = result.min;
+    entry["median_ns"] = result.median;
+    entry["p99_ns"] = result.p99;
+    benchmarks.append(entry);
+  }
+
+  Json::StreamWriterBuilder builder;
+  std::unique_ptr<Json::StreamWriter> writer(builder.newStreamWriter());
+  std::ostringstream stream;
+  writer->write(root, &stream);
+
+  ScopedFILE file;
+  file.reset(fopen(file_path.c_str(), "w"));
+  if (!file) {
+    LOG(0) << "Failed to create file " << file_path;
+    return false;
+  }
+
+  std::string data = stream.str();
+  if (fwrite(data.c_str(), data.size(), 1, file.get()) != 1) {
+    LOG(0) << "Failed to write to file " << file_path;
+    return false;
+  }
+  return true;
+}
+
+namespace internal {
+
+void Escape(const volatile void* ptr) {}
+
+}  // namespace internal
+
+}  // namespace benchmarks
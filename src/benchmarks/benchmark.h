@@ -0,0 +1,89 @@
+#ifndef BENCHMARKS_BENCHMARK_H
+#define BENCHMARKS_BENCHMARK_H
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Minimal microbenchmark harness. A benchmark is registered with a factory
+// that does the setup and returns the function to measure, e.g.
+//   benchmarks::BenchmarkFn HashString(const benchmarks::Options& options) {
+//     std::string str(64, 'x');
+//     return [str](size_t iterations) -> void {
+//       for (size_t i = 0; i < iterations; ++i)
+//         benchmarks::DoNotOptimize(base::KR2Hash(str));
+//     };
+//   }
+//   BENCHMARK("KR2Hash/64", HashString);
+// The number of iterations per repetition is calibrated to take at least
+// Options::min_repetition_time seconds. Results are reported per iteration.
+#define BENCHMARK(name, factory)                             \
+  static ::benchmarks::internal::Registrar BENCHMARK_CONCAT( \
+      registrar_, __LINE__)(name, factory)
+
+#define BENCHMARK_CONCAT_INTERNAL(a, b) a##b
+#define BENCHMARK_CONCAT(a, b) BENCHMARK_CONCAT_INTERNAL(a, b)
+
+namespace benchmarks {
+
+struct Options {
+  // Only benchmarks with names containing the filter are run.
+  std::string filter;
+  int warmup_repetitions = 2;
+  int repetitions = 20;
+  double min_repetition_time = 0.01;
+  // Assets are loaded from the "assets" directory under the root path.
+  std::string root_path = "./";
+};
+
+struct Result {
+  std::string name;
+  // Iterations per repetition.
+  size_t iterations = 0;
+  int repetitions = 0;
+  // Nanoseconds per iteration.
+  double min = 0;
+  double median = 0;
+  double p99 = 0;
+};
+
+// Runs the operation under test the given number of times.
+using BenchmarkFn = std::function<void(size_t iterations)>;
+
+// Does the setup, which isn't measured, and returns the function to measure.
+// Returns nullptr if the benchmark can't run, e.g. an asset is missing.
+using BenchmarkFactory = BenchmarkFn (*)(const Options& options);
+
+void RegisterBenchmark(const char* name, BenchmarkFactory factory);
+
+std::vector<std::string> GetBenchmarkNames();
+
+// Runs the registered benchmarks matching the filter in registration order.
+std::vector<Result> RunBenchmarks(const Options& options);
+
+bool WriteJson(const std::vector<Result>& results,
+               const std::string& file_path);
+
+namespace internal {
+
+// Defined out-of-line so the compiler can't see that the pointer is unused.
+void Escape(const volatile void* ptr);
+
+struct Registrar {
+  Registrar(const char* name, BenchmarkFactory factory) {
+    RegisterBenchmark(name, factory);
+  }
+};
+
+}  // namespace internal
+
+// Prevents the compiler from optimizing away the computation of value.
+template <typename T>
+inline void DoNotOptimize(const T& value) {
+  internal::Escape(&value);
+}
+
+}  // namespace benchmarks
+
+#endif  // BENCHMARKS_BENCHMARK_H
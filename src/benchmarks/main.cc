@@ -0,0 +1,79 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "base/task_runner.h"
+#include "benchmarks/benchmark.h"
+
+using namespace base;
+
+namespace {
+
+const char kUsage[] =
+    "Usage: benchmarks [options]\n"
+    "  --filter=<substring>   Run only benchmarks with matching names.\n"
+    "  --repetitions=<n>      Measured repetitions per benchmark.\n"
+    "  --warmup=<n>           Repetitions to run before measuring.\n"
+    "  --min-time=<seconds>   Minimum duration of a repetition.\n"
+    "  --root=<path>          Directory that contains the assets directory.\n"
+    "  --json=<file>          Write the results to a JSON file.\n"
+    "  --list                 List the benchmarks and exit.\n";
+
+// Returns the value if arg is in the form of --name=value.
+const char* GetSwitchValue(const char* arg, const char* name) {
+  size_t length = strlen(name);
+  if (strncmp(arg, name, length) == 0 && arg[length] == '=')
+    return arg + length + 1;
+  return nullptr;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  benchmarks::Options options;
+  std::string json_file;
+  bool list = false;
+
+  for (int i = 1; i < argc; ++i) {
+    const char* arg = argv[i];
+    if (const char* value = GetSwitchValue(arg, "--filter")) {
+      options.filter = value;
+    } else if (const char* value = GetSwitchValue(arg, "--repetitions")) {
+      options.repetitions = std::max(1, atoi(value));
+    } else if (const char* value = GetSwitchValue(arg, "--warmup")) {
+      options.warmup_repetitions = std::max(0, atoi(value));
+    } else if (const char* value = GetSwitchValue(arg, "--min-time")) {
+      options.min_repetition_time = atof(value);
+    } else if (const char* value = GetSwitchValue(arg, "--root")) {
+      options.root_path = value;
+      if (!options.root_path.empty() && options.root_path.back() != '/')
+        options.root_path += '/';
+    } else if (const char* value = GetSwitchValue(arg, "--json")) {
+      json_file = value;
+    } else if (strcmp(arg, "--list") == 0) {
+      list = true;
+    } else {
+      fprintf(stderr, "%s", kUsage);
+      return 1;
+    }
+  }
+
+  if (list) {
+    for (auto& name : benchmarks::GetBenchmarkNames())
+      printf("%s\n", name.c_str());
+    return 0;
+  }
+
+  // Some of the benchmarked code posts replies to the current thread.
+  TaskRunner::CreateThreadLocalTaskRunner();
+
+  printf("%-48s %12s %12s %12s %13s\n", "Benchmark", "Min", "Median", "P99",
+         "Iterations");
+  auto results = benchmarks::RunBenchmarks(options);
+
+  if (!json_file.empty() && !benchmarks::WriteJson(results, json_file))
+    return 1;
+  return 0;
+}
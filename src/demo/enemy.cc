@@ -3,10 +3,13 @@
 #include <algorithm>
 #include <functional>
 #include <limits>
+#include <memory_resource>
 #include <tuple>
 #include <vector>
 
+#include "base/asset_id.h"
 #include "base/collusion_test.h"
+#include "base/frame_arena.h"
 #include "base/interpolation.h"
 #include "base/log.h"
 #include "engine/asset/font.h"
@@ -85,12 +88,14 @@ bool Enemy::PreInitialize() {
   Engine::Get().SetImageSource("boss_tex1", "demo/Boss_ok.png", true);
   Engine::Get().SetImageSource("boss_tex2", "demo/Boss_ok_lvl2.png", true);
   Engine::Get().SetImageSource("boss_tex3", "demo/Boss_ok_lvl3.png", true);
-  Engine::Get().SetImageSource("target_tex", "demo/enemy_target_single_ok.png",
-                               true);
-  Engine::Get().SetImageSource("blast_tex", "demo/enemy_anims_blast_ok.png",
-                               true);
-  Engine::Get().SetImageSource("shield_tex", "demo/woom_enemy_shield.png",
-                               true);
+  // Drawn over the enemies with the default shader. Sprites that may get a
+  // custom shader stay in their own textures.
+  Engine::Get().SetAtlasImageSource("target_tex",
+                                    "demo/enemy_target_single_ok.png", true);
+  Engine::Get().SetAtlasImageSource("blast_tex",
+                                    "demo/enemy_anims_blast_ok.png", true);
+  Engine::Get().SetAtlasImageSource("shield_tex",
+                                    "demo/woom_enemy_shield.png", true);
   Engine::Get().SetImageSource("crate_tex", "demo/nuke_pack_OK.png", true);
 
   for (int i = 0; i < kEnemyType_Max; ++i) {
@@ -124,6 +129,8 @@ bool Enemy::Initialize() {
   boss_intro_.SetVariate(false);
   boss_intro_.SetSimulateStereo(false);
 
+  grid_.SetCellSize(Engine::Get().GetViewportSize().x / 8);
+
   return true;
 }
 
@@ -138,18 +145,19 @@ void Enemy::Update(float delta_time) {
   Randomf& rnd = Engine::Get().GetRandomGenerator();
 
   chromatic_aberration_offset_ += 0.8f * delta_time;
+  AssetId aberration_offset("aberration_offset");
 
   // Update enemy units.
   for (auto it = enemies_.begin(); it != enemies_.end();) {
     if (it->marked_for_removal) {
       it = enemies_.erase(it);
+      grid_dirty_ = true;
       continue;
     }
 
     if (it->chromatic_aberration_active_) {
       it->sprite.SetCustomUniform(
-          "aberration_offset",
-          Lerp(0.0f, 0.015f, chromatic_aberration_offset_));
+          aberration_offset, Lerp(0.0f, 0.015f, chromatic_aberration_offset_));
     }
 #if defined(LOAD_TEST)
     else if (it->kill_timer <= 0 &&
@@ -190,6 +198,9 @@ void Enemy::Update(float delta_time) {
   if (boss_fight_ && IsBossAlive() && boss_spawn_time_ > 40)
     KillBoss();
 #endif
+
+  // Units will have moved by the time the grid is queried again.
+  grid_dirty_ = true;
 }
 
 void Enemy::Pause(bool pause) {
@@ -229,9 +240,12 @@ void Enemy::SelectTarget(DamageType damage_type,
   if (progress_paused_)
     return;
 
-  std::vector<std::tuple<EnemyUnit*, float, float, Vector2f>> candidates;
+  // Transient, allocated from the frame arena.
+  std::pmr::vector<std::tuple<EnemyUnit*, float, float, Vector2f>> candidates(
+      &base::FrameArena::ForCurrentThread());
 
   for (auto& e : enemies_) {
+    e.candidate_index = -1;
     if (e.hit_points <= 0 || e.marked_for_removal || e.stealth_active)
       continue;
 
@@ -246,6 +260,7 @@ void Enemy::SelectTarget(DamageType damage_type,
     weapon_enemy_dir.Normalize();
     float cos_theta = weapon_enemy_dir.DotProduct(dir);
 
+    e.candidate_index = candidates.size();
     candidates.push_back(
         std::make_tuple(&e, cos_theta, weapon_enemy_dist, weapon_enemy_dir));
   }
@@ -253,29 +268,36 @@ void Enemy::SelectTarget(DamageType damage_type,
   if (candidates.empty())
     return;
 
-  auto all_candidates = candidates;
-
-  for (auto it = candidates.begin(); it != candidates.end();) {
-    auto [cand_enemy, cand_cos_theta, cand_dist, cand_dir] = *it;
-
-    auto oit = candidates.begin();
-    for (; oit != candidates.end(); ++oit) {
-      auto [other_enemy, other_cos_theta, other_dist, orther_dir] = *oit;
-
-      if (cand_enemy == other_enemy || cand_dist < other_dist)
-        continue;
-
-      // Remove obstructed units.
-      if (base::Intersection(other_enemy->sprite.GetPosition(),
-                             other_enemy->sprite.GetSize(), origin, cand_dir)) {
-        break;
-      }
-    }
-    if (oit != candidates.end())
-      it = candidates.erase(it);
-    else
-      ++it;
+  decltype(candidates) all_candidates(candidates, candidates.get_allocator());
+
+  // Remove obstructed units, i.e. the ones with a closer candidate in the way.
+  // Removed units don't obstruct the candidates after them.
+  UpdateGrid();
+  float max_half_diagonal = grid_.max_item_size().Length() / 2;
+  std::pmr::vector<bool> obstructed(candidates.size(), false,
+                                    candidates.get_allocator());
+  for (size_t i = 0; i < candidates.size(); ++i) {
+    auto [cand_enemy, cand_cos_theta, cand_dist, cand_dir] = candidates[i];
+
+    // Obstacles are closer than the candidate, so the ray enters them within
+    // cand_dist + max_half_diagonal.
+    float max_distance = cand_dist + max_half_diagonal;
+    grid_.QueryRay(
+        origin, cand_dir, max_distance, [&](EnemyUnit* other_enemy) -> bool {
+          int j = other_enemy->candidate_index;
+          if (j < 0 || other_enemy == cand_enemy || obstructed[j] ||
+              cand_dist < std::get<2>(candidates[j]))
+            return true;
+          obstructed[i] = true;
+          return false;
+        });
   }
+  size_t num_unobstructed = 0;
+  for (size_t i = 0; i < candidates.size(); ++i) {
+    if (!obstructed[i])
+      candidates[num_unobstructed++] = candidates[i];
+  }
+  candidates.resize(num_unobstructed);
 
   if (candidates.empty())
     return;
@@ -521,50 +543,74 @@ void Enemy::OnWaveStarted(int wave, bool boss_fight) {
   }
 }
 
+void Enemy::UpdateGrid() {
+  if (!grid_dirty_)
+    return;
+
+  grid_.Clear();
+  for (auto& e : enemies_)
+    grid_.Insert(&e, e.sprite.GetPosition(), e.sprite.GetSize());
+  grid_dirty_ = false;
+}
+
 bool Enemy::CheckSpawnPos(Vector2f pos, SpeedType speed_type) {
-  for (auto& e : enemies_) {
-    if (e.hit_points <= 0 || e.marked_for_removal || e.stealth_active ||
-        e.enemy_type > kEnemyType_Unit_Last || e.speed_type != speed_type)
-      continue;
+  UpdateGrid();
+
+  // A unit collides if it's closer than 0.8 of its height to a unit spawned
+  // a height above pos. So it's within 1.8 of the largest height from pos.
+  float radius = grid_.max_item_size().y * 1.8f;
+  bool collision = false;
+  grid_.QueryRadius(pos, radius, [&](EnemyUnit* e) -> bool {
+    if (e->hit_points <= 0 || e->marked_for_removal || e->stealth_active ||
+        e->enemy_type > kEnemyType_Unit_Last || e->speed_type != speed_type)
+      return true;
 
     // Check for collision.
-    float sy = e.sprite.GetSize().y;
+    float sy = e->sprite.GetSize().y;
     Vector2f spawn_pos = pos + Vector2f(0, sy);
 
-    bool gc = (spawn_pos - e.sprite.GetPosition()).Length() < sy * 0.8f;
-    bool tc = e.movement_animator.GetTime(Animator::kMovement) <= 0.06f;
+    bool gc = (spawn_pos - e->sprite.GetPosition()).Length() < sy * 0.8f;
+    bool tc = e->movement_animator.GetTime(Animator::kMovement) <= 0.06f;
 
-    if (gc && tc)
-      return false;
-  }
+    collision = gc && tc;
+    return !collision;
+  });
 
-  return true;
+  return !collision;
 }
 
 bool Enemy::CheckTeleportPos(EnemyUnit* enemy) {
   Vector2f pos = enemy->sprite.GetPosition();
   float t = enemy->movement_animator.GetTime(Animator::kMovement);
 
-  for (auto& e : enemies_) {
-    if (&e == enemy || e.hit_points <= 0 || e.marked_for_removal ||
-        e.stealth_active || e.enemy_type > kEnemyType_Unit_Last ||
-        e.speed_type != enemy->speed_type)
-      continue;
+  UpdateGrid();
 
-    if (e.enemy_type == kEnemyType_Bug &&
-        !e.movement_animator.IsPlaying(Animator::kMovement))
-      continue;
+  float radius = grid_.max_item_size().y * 0.8f;
+  bool collision = false;
+  grid_.QueryRadius(pos, radius, [&](EnemyUnit* e) -> bool {
+    if (e == enemy || e->hit_points <= 0 || e->marked_for_removal ||
+        e->stealth_active || e->enemy_type > kEnemyType_Unit_Last ||
+        e->speed_type != enemy->speed_type)
+      return true;
+
+    if (e->enemy_type == kEnemyType_Bug &&
+        !e->movement_animator.IsPlaying(Animator::kMovement))
+      return true;
 
     bool gc =
-        (pos - e.sprite.GetPosition()).Length() < e.sprite.GetSize().y * 0.8f;
+        (pos - e->sprite.GetPosition()).Length() < e->sprite.GetSize().y * 0.8f;
     bool tc =
-        fabs(t - e.movement_animator.GetTime(Animator::kMovement)) <= 0.04f;
+        fabs(t - e->movement_animator.GetTime(Animator::kMovement)) <= 0.04f;
 
-    if (gc && tc)
-      return false;
-  }
+    collision = gc && tc;
+    return !collision;
+  });
 
-  return true;
+  // Called from animator callbacks while the other units are still being
+  // moved, so the grid can't be reused for this tick.
+  grid_dirty_ = true;
+
+  return !collision;
 }
 
 void Enemy::SpawnUnit(EnemyType enemy_type,
@@ -581,6 +627,7 @@ void Enemy::SpawnUnit(EnemyType enemy_type,
   Demo* game = static_cast<Demo*>(engine.GetGame());
 
   auto& e = enemies_.emplace_back();
+  grid_dirty_ = true;
   e.enemy_type = enemy_type;
   e.damage_type = damage_type;
   e.speed_type = speed_type;
@@ -783,6 +830,7 @@ void Enemy::SpawnBoss() {
 
     // Spwawn a stationary enemy unit for the boss.
     auto& e = enemies_.emplace_front();
+    grid_dirty_ = true;
     e.enemy_type = kEnemyType_Boss;
     e.damage_type = kDamageType_Any;
     e.total_health = e.hit_points = 41.1283f * log((float)game->wave()) - 20.0f;
@@ -1187,6 +1235,7 @@ std::unique_ptr<Image> Enemy::GetScoreImage(EnemyType enemy_type) {
 }
 
 void Enemy::TranslateEnemyUnit(EnemyUnit& e, const Vector2f& delta) {
+  grid_dirty_ = true;
   e.sprite.Translate(delta);
   e.target.Translate(delta);
   e.blast.Translate(delta);
@@ -5,6 +5,8 @@
 #include <list>
 #include <memory>
 
+#include "base/object_pool.h"
+#include "base/spatial_grid.h"
 #include "base/vecmath.h"
 #include "engine/animator.h"
 #include "engine/image_quad.h"
@@ -80,6 +82,9 @@ class Enemy {
 
     bool chromatic_aberration_active_ = false;
 
+    // Index into the candidates in SelectTarget, or -1.
+    int candidate_index = -1;
+
     eng::ImageQuad sprite;
     eng::ImageQuad target;
     eng::ImageQuad blast;
@@ -109,7 +114,13 @@ class Enemy {
   eng::Animator boss_animator_;
   eng::SoundPlayer boss_intro_;
 
-  std::list<EnemyUnit> enemies_;
+  // Units are recycled through a slab pool as waves spawn and die.
+  std::list<EnemyUnit, base::PoolAllocator<EnemyUnit>> enemies_;
+
+  // Broadphase for targeting and spawn checks. Rebuilt on the first query after
+  // units have moved, spawned or been removed.
+  base::SpatialGrid<EnemyUnit*> grid_;
+  bool grid_dirty_ = true;
 
   int num_enemies_killed_in_current_wave_ = 0;
 
@@ -133,6 +144,8 @@ class Enemy {
   int wave_ = 0;
   bool boss_fight_ = false;
 
+  void UpdateGrid();
+
   bool CheckSpawnPos(base::Vector2f pos, SpeedType speed_type);
   bool CheckTeleportPos(EnemyUnit* enemy);
 
@@ -30,11 +30,13 @@ Player::Player() = default;
 Player::~Player() = default;
 
 bool Player::PreInitialize() {
-  Engine::Get().SetImageSource("weapon_tex", "demo/enemy_anims_flare_ok.png",
-                               true);
-  Engine::Get().SetImageSource("beam_tex", "demo/enemy_ray_ok.png", true);
-  Engine::Get().SetImageSource("nuke_symbol_tex", "demo/nuke_frames.png", true);
-  Engine::Get().SetImageSource("health_bead", "demo/bead.png", true);
+  Engine::Get().SetAtlasImageSource("weapon_tex",
+                                    "demo/enemy_anims_flare_ok.png", true);
+  Engine::Get().SetAtlasImageSource("beam_tex", "demo/enemy_ray_ok.png",
+                                    true);
+  Engine::Get().SetAtlasImageSource("nuke_symbol_tex", "demo/nuke_frames.png",
+                                    true);
+  Engine::Get().SetAtlasImageSource("health_bead", "demo/bead.png", true);
 
   Engine::Get().SetAudioSource("laser", "demo/laser.mp3");
   Engine::Get().SetAudioSource("nuke", "demo/nuke.mp3");
@@ -19,7 +19,6 @@ SkyQuad::SkyQuad()
 SkyQuad::~SkyQuad() = default;
 
 bool SkyQuad::Create() {
-  scale_ = Engine::Get().GetViewportSize();
   shader_ = Engine::Get().GetShader("sky");
 
   color_animator_.Attach(this);
@@ -38,8 +37,6 @@ void SkyQuad::Draw(float frame_frac) {
   Vector2f sky_offset = Lerp(last_sky_offset_, sky_offset_, frame_frac);
 
   shader_->Activate();
-  shader_->SetUniform("scale", scale_);
-  shader_->SetUniform("projection", Engine::Get().GetProjectionMatrix());
   shader_->SetUniform("sky_offset", sky_offset);
   shader_->SetUniform("nebula_color",
                       {nebula_color_.x, nebula_color_.y, nebula_color_.z});
@@ -45,7 +45,6 @@ class SkyQuad : public eng::Animatable {
   base::Vector2f sky_offset_ = {0, 0};
   base::Vector2f last_sky_offset_ = {0, 0};
   base::Vector4f nebula_color_ = {0, 0, 0, 1};
-  base::Vector2f scale_ = {1, 1};
 
   eng::Animator color_animator_;
 
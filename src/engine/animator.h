@@ -4,13 +4,14 @@
 #include <vector>
 
 #include "base/closure.h"
+#include "base/linked_list.h"
 #include "base/vecmath.h"
 
 namespace eng {
 
 class Animatable;
 
-class Animator {
+class Animator : public base::LinkNode<Animator> {
  public:
   // Animation type flags.
   enum Flags {
@@ -14,10 +14,14 @@
 namespace eng {
 
 bool Font::Load(const std::string& file_name) {
+  return Load(file_name, Engine::Get().GetRootPath());
+}
+
+bool Font::Load(const std::string& file_name, const std::string& root_path) {
   // Read the font file.
   size_t buffer_size = 0;
-  auto buffer = AssetFile::ReadWholeFile(
-      file_name.c_str(), Engine::Get().GetRootPath().c_str(), &buffer_size);
+  auto buffer = AssetFile::ReadWholeFile(file_name.c_str(), root_path.c_str(),
+                                         &buffer_size);
   if (!buffer) {
     LOG(0) << "Failed to read font file.";
     return false;
@@ -15,6 +15,7 @@ class Font {
   ~Font() = default;
 
   bool Load(const std::string& file_name);
+  bool Load(const std::string& file_name, const std::string& root_path);
 
   void CalculateBoundingBox(const std::string& text,
                             int& width,
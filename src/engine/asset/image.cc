@@ -136,9 +136,13 @@ bool Image::CreateMip(const Image& other) {
 }
 
 bool Image::Load(const std::string& file_name) {
+  return Load(file_name, Engine::Get().GetRootPath());
+}
+
+bool Image::Load(const std::string& file_name, const std::string& root_path) {
   size_t buffer_size = 0;
-  auto file_buffer = AssetFile::ReadWholeFile(
-      file_name.c_str(), Engine::Get().GetRootPath().c_str(), &buffer_size);
+  auto file_buffer = AssetFile::ReadWholeFile(file_name.c_str(),
+                                              root_path.c_str(), &buffer_size);
   if (!file_buffer) {
     LOG(0) << "Failed to read file: " << file_name;
     return false;
@@ -258,10 +262,13 @@ void Image::ConvertToPow2() {
 }
 
 bool Image::Compress() {
+  return Compress(Engine::Get().GetTextureCompressor(true));
+}
+
+bool Image::Compress(TextureCompressor* tc) {
   if (IsCompressed())
     return true;
 
-  TextureCompressor* tc = Engine::Get().GetTextureCompressor(true);
   if (!tc)
     return false;
 
@@ -8,6 +8,8 @@
 #include "base/vecmath.h"
 #include "engine/renderer/renderer_types.h"
 
+class TextureCompressor;
+
 namespace eng {
 
 class Image {
@@ -22,8 +24,10 @@ class Image {
   void Copy(const Image& other);
   bool CreateMip(const Image& other);
   bool Load(const std::string& file_name);
+  bool Load(const std::string& file_name, const std::string& root_path);
 
   bool Compress();
+  bool Compress(TextureCompressor* tc);
 
   void ConvertToPow2();
 
@@ -45,10 +45,13 @@ bool Mesh::Create(Primitive primitive,
 }
 
 bool Mesh::Load(const std::string& file_name) {
+  return Load(file_name, Engine::Get().GetRootPath());
+}
+
+bool Mesh::Load(const std::string& file_name, const std::string& root_path) {
   size_t buffer_size = 0;
-  auto json_mesh = AssetFile::ReadWholeFile(file_name.c_str(),
-                                            Engine::Get().GetRootPath().c_str(),
-                                            &buffer_size, true);
+  auto json_mesh = AssetFile::ReadWholeFile(
+      file_name.c_str(), root_path.c_str(), &buffer_size, true);
   if (!json_mesh) {
     LOG(0) << "Failed to read file: " << file_name;
     return false;
@@ -136,7 +139,7 @@ bool Mesh::Load(const std::string& file_name) {
   }
 
   if (primitive_ != kPrimitive_Triangles) {
-    LOG(0) << "Loaded " << file_name << ", vertex count: " << vertices.size();
+    DLOG(0) << "Loaded " << file_name << ", vertex count: " << vertices.size();
     return true;
   }
 
@@ -178,8 +181,8 @@ bool Mesh::Load(const std::string& file_name) {
     }
   }
 
-  LOG(0) << "Loaded " << file_name << ", vertices: " << num_vertices_
-         << ", indices: " << num_indices_;
+  DLOG(0) << "Loaded " << file_name << ", vertices: " << num_vertices_
+          << ", indices: " << num_indices_;
   return true;
 }
 
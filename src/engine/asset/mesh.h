@@ -22,6 +22,7 @@ class Mesh {
               const void* indices = nullptr);
 
   bool Load(const std::string& file_name);
+  bool Load(const std::string& file_name, const std::string& root_path);
 
   const void* GetVertices() const { return (void*)vertices_.get(); }
   const void* GetIndices() const { return (void*)indices_.get(); }
@@ -11,11 +11,21 @@ namespace {
 // Helper macros for our glsl shaders. Makes it possible to write generic code
 // that compiles both for OpenGL and Vulkan.
 
+// Frame uniforms are set once per frame for all shaders (see FrameUniforms).
+// Declared with FRAME_UNIFORMS and read with FRAME_PROJECTION etc. Only
+// available in vertex shaders. Uniforms shared between stages would need
+// matching precision in GLES, pass them to the fragment shader if needed. The
+// GLSL versions used with OpenGL have no uniform blocks, so they are plain
+// uniforms there. No line continuations in GLSL ES 1.00, hence the long lines.
 const char kVertexShaderMacros[] = R"(#if defined(VULKAN)
 #define UNIFORM_BEGIN layout(push_constant) uniform Params {
 #define UNIFORM_V(X) X;
 #define UNIFORM_F(X) X;
 #define UNIFORM_END } params;
+#define FRAME_UNIFORMS layout(set = 3, binding = 0) uniform Frame { mat4 projection; vec2 viewport_size; float time; } frame;
+#define FRAME_PROJECTION frame.projection
+#define FRAME_VIEWPORT_SIZE frame.viewport_size
+#define FRAME_TIME frame.time
 #define IN(X) layout(location = X) in
 #define OUT(X) layout(location = X) out
 #define PARAM(X) params.X
@@ -24,6 +34,10 @@ const char kVertexShaderMacros[] = R"(#if defined(VULKAN)
 #define UNIFORM_V(X) uniform X;
 #define UNIFORM_F(X)
 #define UNIFORM_END
+#define FRAME_UNIFORMS uniform mat4 frame_projection; uniform vec2 frame_viewport_size; uniform float frame_time;
+#define FRAME_PROJECTION frame_projection
+#define FRAME_VIEWPORT_SIZE frame_viewport_size
+#define FRAME_TIME frame_time
 #define IN(X) attribute
 #define OUT(X) varying
 #define PARAM(X) X
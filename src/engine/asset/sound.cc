@@ -91,7 +91,8 @@ void Sound::Stream(bool loop) {
 }
 
 void Sound::SwapBuffers() {
-  FromInterleaved(std::move(interleaved_data_), samples_per_channel_);
+  FromInterleaved(std::move(interleaved_data_), samples_per_channel_,
+                  Engine::Get().GetAudioHardwareSampleRate());
   samples_per_channel_ = 0;
 }
 
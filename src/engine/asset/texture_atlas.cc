@@ -0,0 +1,331 @@
+#include "engine/asset/texture_atlas.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "base/log.h"
+#include "base/skyline_packer.h"
+#include "engine/asset/image.h"
+#include "engine/engine.h"
+#include "engine/persistent_data.h"
+#include "engine/platform/asset_file.h"
+#include "third_party/stb/stb_image.h"
+
+using namespace base;
+
+namespace eng {
+
+namespace {
+
+// Bump when the layout changes for the same input.
+constexpr int kLayoutVersion = 2;
+
+// Border around each image. Filled with the image's edge pixels, so filtering
+// at the edges doesn't pick up the neighbours.
+constexpr int kPadding = 2;
+
+// Images are placed on 4x4 blocks, so a compressed block never mixes images.
+int AlignToBlock(int x) {
+  return (x + 3) & ~3;
+}
+
+// Reads the image size from the header. Only the first few bytes are read, not
+// the whole file. Returns false if the header can't be read or the image can't
+// be loaded.
+bool ReadImageSize(AssetFile& file, int* width, int* height) {
+  struct Reader {
+    AssetFile* file;
+    bool eof = false;
+  } reader = {&file};
+
+  stbi_io_callbacks callbacks;
+  callbacks.read = [](void* user, char* data, int size) -> int {
+    auto* reader = static_cast<Reader*>(user);
+    size_t bytes_read = reader->file->Read(data, size);
+    if (bytes_read < size_t(size))
+      reader->eof = true;
+    return int(bytes_read);
+  };
+  // AssetFile can't seek in compressed archives. Read and discard instead.
+  callbacks.skip = [](void* user, int n) -> void {
+    auto* reader = static_cast<Reader*>(user);
+    char buffer[256];
+    while (n > 0 && !reader->eof) {
+      int size = std::min(n, int(sizeof(buffer)));
+      size_t bytes_read = reader->file->Read(buffer, size);
+      if (bytes_read < size_t(size))
+        reader->eof = true;
+      n -= size;
+    }
+  };
+  callbacks.eof = [](void* user) -> int {
+    return static_cast<Reader*>(user)->eof;
+  };
+
+  int c;
+  if (!stbi_info_from_callbacks(&callbacks, &reader, width, height, &c))
+    return false;
+  // Image::Load() doesn't support grey+alpha. Such images are left out of the
+  // atlas and fall back to their own texture, which logs the error on load.
+  return c != 2;
+}
+
+}  // namespace
+
+TextureAtlas::TextureAtlas(int page_size) : page_size_(page_size) {
+  DCHECK(page_size > 0 && page_size % 4 == 0);
+}
+
+TextureAtlas::~TextureAtlas() = default;
+
+void TextureAtlas::AddImage(AssetId asset_id, const std::string& file_name) {
+  DCHECK(pages_.empty()) << "Already built.";
+  Entry& e = entries_.emplace_back();
+  e.asset_id = asset_id;
+  e.file_name = file_name;
+}
+
+bool TextureAtlas::Build(const std::string& cache_file) {
+  if (entries_.empty())
+    return false;
+
+  for (Entry& e : entries_) {
+    AssetFile file;
+    e.file_size = 0;
+    e.width = e.height = 0;
+    if (file.Open(e.file_name, Engine::Get().GetRootPath())) {
+      e.file_size = file.GetSize();
+      if (!ReadImageSize(file, &e.width, &e.height))
+        e.width = e.height = 0;
+    }
+  }
+
+  if (!LoadLayout(cache_file)) {
+    if (!Pack())
+      return false;
+    SaveLayout(cache_file);
+  }
+
+  size_t num_packed = 0;
+  for (size_t i = 0; i < entries_.size(); ++i) {
+    if (entries_[i].packed) {
+      index_[entries_[i].asset_id] = i;
+      ++num_packed;
+    }
+  }
+  LOG(0) << "Texture atlas: " << num_packed << " images in " << pages_.size()
+         << " pages.";
+  return num_packed > 0;
+}
+
+const TextureAtlas::Region* TextureAtlas::GetRegion(AssetId asset_id) const {
+  auto it = index_.find(asset_id);
+  return it == index_.end() ? nullptr : &entries_[it->second].region;
+}
+
+std::unique_ptr<Image> TextureAtlas::CreatePageImage(size_t page) const {
+  DCHECK(page < pages_.size());
+
+  auto page_image = std::make_unique<Image>();
+  page_image->Create(pages_[page].width, pages_[page].height);
+  page_image->Clear({0, 0, 0, 0});
+  uint8_t* dst = page_image->GetBuffer();
+  size_t dst_pitch = pages_[page].width * 4;
+
+  for (const Entry& e : entries_) {
+    if (!e.packed || e.region.page != page)
+      continue;
+
+    Image image;
+    if (!image.Load(e.file_name))
+      continue;
+    if (image.GetWidth() != e.region.width ||
+        image.GetHeight() != e.region.height) {
+      LOG(0) << "Image size doesn't match the atlas layout: " << e.file_name;
+      continue;
+    }
+
+    // Copy the rows and extend the edge pixels into the padding.
+    const uint8_t* src = image.GetBuffer();
+    size_t src_pitch = image.GetWidth() * 4;
+    int x = e.region.x;
+    for (int y = -kPadding; y < e.region.height + kPadding; ++y) {
+      const uint8_t* src_row =
+          src + std::clamp(y, 0, e.region.height - 1) * src_pitch;
+      uint8_t* dst_row = dst + (e.region.y + y) * dst_pitch;
+      memcpy(dst_row + x * 4, src_row, src_pitch);
+      for (int i = 1; i <= kPadding; ++i) {
+        memcpy(dst_row + (x - i) * 4, src_row, 4);
+        memcpy(dst_row + (x + e.region.width - 1 + i) * 4,
+               src_row + src_pitch - 4, 4);
+      }
+    }
+  }
+  return page_image;
+}
+
+bool TextureAtlas::LoadLayout(const std::string& cache_file) {
+  PersistentData data;
+  if (!data.Load(cache_file))
+    return false;
+
+  // The cache file may be stale or corrupt. Check the types before accessing
+  // the values, jsoncpp asserts on type mismatch. Reject anything that would
+  // make CreatePageImage write out of bounds.
+  const Json::Value& root = data.root();
+  if (!root.isObject())
+    return false;
+  const Json::Value& images = root["images"];
+  const Json::Value& pages = root["pages"];
+  if (!root["version"].isInt() || !root["page_size"].isInt() ||
+      !images.isArray() || !pages.isArray()) {
+    return false;
+  }
+  if (root["version"].asInt() != kLayoutVersion ||
+      root["page_size"].asInt() != page_size_ ||
+      images.size() != entries_.size()) {
+    return false;
+  }
+
+  std::vector<Page> new_pages;
+  for (const Json::Value& page : pages) {
+    if (!page.isObject() || !page["width"].isInt() || !page["height"].isInt())
+      return false;
+    Page p = {page["width"].asInt(), page["height"].asInt()};
+    if (p.width <= 0 || p.height <= 0 || p.width > page_size_ ||
+        p.height > page_size_) {
+      return false;
+    }
+    new_pages.push_back(p);
+  }
+
+  for (Json::ArrayIndex i = 0; i < images.size(); ++i) {
+    const Json::Value& image = images[i];
+    Entry& e = entries_[i];
+    if (!image.isObject() || !image["file"].isString() ||
+        !image["file_size"].isUInt64() || !image["page"].isInt() ||
+        !image["x"].isInt() || !image["y"].isInt() ||
+        !image["width"].isInt() || !image["height"].isInt()) {
+      return false;
+    }
+    if (image["file"].asString() != e.file_name ||
+        image["file_size"].asUInt64() != e.file_size ||
+        image["width"].asInt() != e.width ||
+        image["height"].asInt() != e.height) {
+      return false;
+    }
+    e.packed = image["page"].asInt() >= 0;
+    if (e.packed) {
+      e.region = {image["page"].asUInt(), image["x"].asInt(),
+                  image["y"].asInt(), e.width, e.height};
+      if (e.region.page >= new_pages.size())
+        return false;
+      const Page& page = new_pages[e.region.page];
+      if (e.region.width <= 0 || e.region.height <= 0 ||
+          e.region.x < kPadding || e.region.y < kPadding ||
+          e.region.x > page.width - e.region.width - kPadding ||
+          e.region.y > page.height - e.region.height - kPadding) {
+        return false;
+      }
+    }
+  }
+
+  pages_ = std::move(new_pages);
+
+  DLOG(0) << "Loaded texture atlas layout from " << cache_file;
+  return true;
+}
+
+void TextureAtlas::SaveLayout(const std::string& cache_file) {
+  PersistentData data;
+  Json::Value& root = data.root();
+  root["version"] = kLayoutVersion;
+  root["page_size"] = page_size_;
+  root["images"] = Json::arrayValue;
+  for (const Entry& e : entries_) {
+    Json::Value image;
+    image["file"] = e.file_name;
+    image["file_size"] = Json::UInt64(e.file_size);
+    image["page"] = e.packed ? int(e.region.page) : -1;
+    image["x"] = e.region.x;
+    image["y"] = e.region.y;
+    image["width"] = e.width;
+    image["height"] = e.height;
+    root["images"].append(image);
+  }
+  root["pages"] = Json::arrayValue;
+  for (const Page& p : pages_) {
+    Json::Value page;
+    page["width"] = p.width;
+    page["height"] = p.height;
+    root["pages"].append(page);
+  }
+  data.SaveAs(cache_file);
+}
+
+bool TextureAtlas::Pack() {
+  // Only the image sizes are needed. Build() read them from the headers.
+  struct Item {
+    size_t entry;
+    int width;
+    int height;
+  };
+  std::vector<Item> items;
+  for (size_t i = 0; i < entries_.size(); ++i) {
+    Entry& e = entries_[i];
+    e.packed = false;
+
+    if (e.width <= 0 || e.height <= 0) {
+      LOG(0) << "Failed to read image info or unsupported format: "
+             << e.file_name;
+      continue;
+    }
+    e.region.width = e.width;
+    e.region.height = e.height;
+
+    int padded_width = AlignToBlock(e.width + kPadding * 2);
+    int padded_height = AlignToBlock(e.height + kPadding * 2);
+    if (padded_width > page_size_ || padded_height > page_size_) {
+      DLOG(0) << "Image is too large for the texture atlas: " << e.file_name;
+      continue;
+    }
+    items.push_back({i, padded_width, padded_height});
+  }
+
+  // Tallest first packs best with the skyline heuristic.
+  std::sort(items.begin(), items.end(), [](const Item& a, const Item& b) {
+    return a.height > b.height || (a.height == b.height && a.width > b.width);
+  });
+
+  std::vector<SkylinePacker> packers;
+  for (const Item& item : items) {
+    int x = 0, y = 0;
+    size_t page = 0;
+    for (; page < packers.size(); ++page) {
+      if (packers[page].Insert(item.width, item.height, &x, &y))
+        break;
+    }
+    if (page == packers.size()) {
+      packers.emplace_back(page_size_, page_size_);
+      // Always fits in an empty page.
+      CHECK(packers.back().Insert(item.width, item.height, &x, &y));
+    }
+
+    Entry& e = entries_[item.entry];
+    e.packed = true;
+    e.region.page = page;
+    e.region.x = x + kPadding;
+    e.region.y = y + kPadding;
+  }
+
+  pages_.clear();
+  for (const SkylinePacker& packer : packers) {
+    pages_.push_back({packer.used_width(), packer.used_height()});
+    DLOG(0) << "Texture atlas page " << packer.used_width() << "x"
+            << packer.used_height() << ", " << packer.Occupancy() * 100
+            << "% occupied.";
+  }
+  return !items.empty();
+}
+
+}  // namespace eng
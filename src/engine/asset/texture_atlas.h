@@ -0,0 +1,87 @@
+#ifndef ENGINE_ASSET_TEXTURE_ATLAS_H
+#define ENGINE_ASSET_TEXTURE_ATLAS_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/asset_id.h"
+#include "base/flat_hash_map.h"
+
+namespace eng {
+
+class Image;
+
+// Packs images into a few large pages, so sprites that use different images
+// can share a texture and be drawn in one batch. Images are registered before
+// Build() and are loaded when a page image is created. The layout only depends
+// on the image sizes, so it is saved to a cache file and reused as long as the
+// image files and sizes don't change.
+class TextureAtlas {
+ public:
+  // Region of a page that holds an image, in pixels from the top-left corner.
+  struct Region {
+    size_t page = 0;
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+  };
+
+  static constexpr int kDefaultPageSize = 2048;
+
+  explicit TextureAtlas(int page_size = kDefaultPageSize);
+  ~TextureAtlas();
+
+  TextureAtlas(const TextureAtlas&) = delete;
+  TextureAtlas& operator=(const TextureAtlas&) = delete;
+
+  void AddImage(base::AssetId asset_id, const std::string& file_name);
+
+  // Packs the registered images. Uses the layout in the cache file instead if
+  // it matches the images, otherwise saves the new layout to it. Images that
+  // are too large for a page or fail to load are left out. Returns false if
+  // nothing was packed.
+  bool Build(const std::string& cache_file);
+
+  // Returns nullptr if the image is not packed.
+  const Region* GetRegion(base::AssetId asset_id) const;
+
+  size_t GetNumPages() const { return pages_.size(); }
+
+  // Loads the images of the given page and copies them into a new image. Safe
+  // to call from any thread after Build().
+  std::unique_ptr<Image> CreatePageImage(size_t page) const;
+
+ private:
+  struct Entry {
+    base::AssetId asset_id;
+    std::string file_name;
+    // Sizes of the file and the image, used for invalidating the cache. The
+    // image size is 0 if the header can't be read.
+    size_t file_size = 0;
+    int width = 0;
+    int height = 0;
+    bool packed = false;
+    Region region;
+  };
+
+  struct Page {
+    int width = 0;
+    int height = 0;
+  };
+
+  int page_size_;
+  std::vector<Entry> entries_;
+  std::vector<Page> pages_;
+  base::FlatHashMap<base::AssetId, size_t> index_;
+
+  bool LoadLayout(const std::string& cache_file);
+  void SaveLayout(const std::string& cache_file);
+
+  bool Pack();
+};
+
+}  // namespace eng
+
+#endif  // ENGINE_ASSET_TEXTURE_ATLAS_H
@@ -1,8 +1,9 @@
 #include "engine/audio/audio_bus.h"
 
+#include <cstring>
+
 #include "base/log.h"
 #include "engine/audio/sinc_resampler.h"
-#include "engine/engine.h"
 
 using namespace base;
 
@@ -60,12 +61,11 @@ void AudioBus::SetAudioConfig(size_t num_channels, size_t sample_rate) {
 }
 
 void AudioBus::FromInterleaved(std::unique_ptr<float[]> source_buffer,
-                               size_t samples_per_channel) {
+                               size_t samples_per_channel,
+                               size_t hw_sample_rate) {
   auto channels = Deinterleave<float>(num_channels_, samples_per_channel,
                                       std::move(source_buffer));
 
-  size_t hw_sample_rate = Engine::Get().GetAudioHardwareSampleRate();
-
   if (hw_sample_rate == sample_rate_) {
     // Passthrough
     channel_data_[0] = std::move(channels[0]);
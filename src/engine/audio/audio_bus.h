@@ -34,10 +34,11 @@ class AudioBus {
 
   // Overwrites the sample values stored in this AudioBus instance with values
   // from a given interleaved source_buffer. The expected layout of the
-  // source_buffer is [ch0, ch1, ch0, ch1, ...]. A sample-rate conversion to the
-  // system sample-rate will be made if it doesn't match.
+  // source_buffer is [ch0, ch1, ch0, ch1, ...]. A sample-rate conversion to
+  // hw_sample_rate will be made if it doesn't match.
   void FromInterleaved(std::unique_ptr<float[]> source_buffer,
-                       size_t samples_per_channel);
+                       size_t samples_per_channel,
+                       size_t hw_sample_rate);
 
  private:
   std::unique_ptr<float[]> channel_data_[2];
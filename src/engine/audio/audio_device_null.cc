@@ -0,0 +1,27 @@
+#include "engine/audio/audio_device_null.h"
+
+namespace eng {
+
+AudioDeviceNull::AudioDeviceNull(AudioDevice::Delegate* delegate,
+                                 size_t sample_rate)
+    : delegate_(delegate), sample_rate_(sample_rate) {}
+
+AudioDeviceNull::~AudioDeviceNull() = default;
+
+bool AudioDeviceNull::Initialize() {
+  return true;
+}
+
+void AudioDeviceNull::Suspend() {}
+
+void AudioDeviceNull::Resume() {}
+
+size_t AudioDeviceNull::GetHardwareSampleRate() {
+  return sample_rate_;
+}
+
+void AudioDeviceNull::RenderAudio(float* output_buffer, size_t num_frames) {
+  delegate_->RenderAudio(output_buffer, num_frames);
+}
+
+}  // namespace eng
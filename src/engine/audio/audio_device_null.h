@@ -0,0 +1,33 @@
+#ifndef ENGINE_AUDIO_AUDIO_DEVICE_NULL_H
+#define ENGINE_AUDIO_AUDIO_DEVICE_NULL_H
+
+#include "engine/audio/audio_device.h"
+
+namespace eng {
+
+// Audio device without an output. Doesn't run an audio thread. Audio is
+// rendered only when pulled via RenderAudio(), which is useful for headless
+// tools such as benchmarks.
+class AudioDeviceNull final : public AudioDevice {
+ public:
+  AudioDeviceNull(AudioDevice::Delegate* delegate, size_t sample_rate);
+  ~AudioDeviceNull() final;
+
+  bool Initialize() final;
+
+  void Suspend() final;
+  void Resume() final;
+
+  size_t GetHardwareSampleRate() final;
+
+  // Pulls num_frames of audio from the delegate.
+  void RenderAudio(float* output_buffer, size_t num_frames);
+
+ private:
+  AudioDevice::Delegate* delegate_ = nullptr;
+  size_t sample_rate_ = 0;
+};
+
+}  // namespace eng
+
+#endif  // ENGINE_AUDIO_AUDIO_DEVICE_NULL_H
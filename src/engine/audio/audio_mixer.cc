@@ -4,6 +4,7 @@
 
 #include "base/log.h"
 #include "base/task_runner.h"
+#include "base/trace.h"
 #include "engine/audio/audio_bus.h"
 #include "engine/audio/mixer_input.h"
 
@@ -19,15 +20,26 @@ using namespace base;
 
 namespace eng {
 
-AudioMixer::AudioMixer()
-    : main_thread_task_runner_(TaskRunner::GetThreadLocalTaskRunner()),
+namespace {
+
+std::unique_ptr<AudioDevice> CreatePlatformAudioDevice(
+    AudioDevice::Delegate* delegate) {
 #if defined(__ANDROID__)
-      audio_device_{std::make_unique<AudioDeviceOboe>(this)} {
+  return std::make_unique<AudioDeviceOboe>(delegate);
 #elif defined(__linux__)
-      audio_device_{std::make_unique<AudioDeviceAlsa>(this)} {
+  return std::make_unique<AudioDeviceAlsa>(delegate);
 #elif defined(_WIN32)
-      audio_device_{std::make_unique<AudioDeviceWASAPI>(this)} {
+  return std::make_unique<AudioDeviceWASAPI>(delegate);
 #endif
+}
+
+}  // namespace
+
+AudioMixer::AudioMixer() : AudioMixer(CreatePlatformAudioDevice) {}
+
+AudioMixer::AudioMixer(CreateDeviceCB create_device)
+    : main_thread_task_runner_(TaskRunner::GetThreadLocalTaskRunner()),
+      audio_device_{create_device(this)} {
   if (!audio_device_->Initialize()) {
     audio_device_.reset();
     audio_enabled_ = false;
@@ -64,6 +76,7 @@ size_t AudioMixer::GetHardwareSampleRate() const {
 }
 
 void AudioMixer::RenderAudio(float* output_buffer, size_t num_frames) {
+  TRACE_SCOPE("AudioMixer::RenderAudio");
   {
     std::unique_lock<std::mutex> scoped_lock(lock_, std::try_to_lock);
     if (scoped_lock)
@@ -142,7 +155,7 @@ void AudioMixer::RenderAudio(float* output_buffer, size_t num_frames) {
               src[1] = src[0];  // mono.
             num_samples = audio_bus->samples_per_channel();
           } else {
-            DLOG(0) << "Mixer buffer underrun!";
+            DLOG_EVERY_N_SEC(0, 1) << "Mixer buffer underrun!";
           }
         }
       }
@@ -163,7 +176,9 @@ void AudioMixer::RenderAudio(float* output_buffer, size_t num_frames) {
   for (auto it = removed_inputs_.begin(); it != removed_inputs_.end();) {
     if (!(*it)->IsStreamingInProgress()) {
       main_thread_task_runner_->PostTask(
-          HERE, std::bind(&MixerInput::OnRemovedFromMixer, *it));
+          HERE, [input = std::move(*it)]() -> void {
+            input->OnRemovedFromMixer();
+          });
       it = removed_inputs_.erase(it);
     } else {
       ++it;
@@ -1,6 +1,7 @@
 #ifndef ENGINE_AUDIO_AUDIO_MIXER_H
 #define ENGINE_AUDIO_AUDIO_MIXER_H
 
+#include <functional>
 #include <list>
 #include <memory>
 #include <mutex>
@@ -25,7 +26,13 @@ class MixerInput;
 // RenderAudio() in a background thread.
 class AudioMixer : public AudioDevice::Delegate {
  public:
+  using CreateDeviceCB =
+      std::function<std::unique_ptr<AudioDevice>(AudioDevice::Delegate*)>;
+
   AudioMixer();
+  // Outputs to the device returned by create_device instead of the platform
+  // audio device.
+  explicit AudioMixer(CreateDeviceCB create_device);
   ~AudioMixer();
 
   void AddInput(std::shared_ptr<MixerInput> mixer_input);
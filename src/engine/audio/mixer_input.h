@@ -92,7 +92,7 @@ class MixerInput : public std::enable_shared_from_this<MixerInput> {
   // Accessed by main thread only.
   bool playing_ = false;
   base::Closure end_cb_;
-  base::Closure restart_cb_;
+  base::OnceClosure restart_cb_;
 
   // Accessed by main thread and audio thread.
   std::atomic<unsigned> flags_{0};
@@ -5,12 +5,39 @@
 
 namespace eng {
 
-Drawable::Drawable() {
-  Engine::Get().AddDrawable(this);
-}
+namespace {
+
+uint64_t next_sequence = 0;
+
+}  // namespace
+
+Drawable::Drawable() : sequence_(next_sequence++) {}
 
 Drawable::~Drawable() {
-  Engine::Get().RemoveDrawable(this);
+  if (visible_)
+    Engine::Get().RemoveDrawable(this);
+}
+
+void Drawable::SetZOrder(int z) {
+  if (z == z_order_)
+    return;
+  if (visible_) {
+    Engine::Get().RemoveDrawable(this);
+    z_order_ = z;
+    Engine::Get().AddDrawable(this);
+  } else {
+    z_order_ = z;
+  }
+}
+
+void Drawable::SetVisible(bool visible) {
+  if (visible == visible_)
+    return;
+  visible_ = visible;
+  if (visible_)
+    Engine::Get().AddDrawable(this);
+  else
+    Engine::Get().RemoveDrawable(this);
 }
 
 void Drawable::SetCustomShader(const std::string& asset_name) {
@@ -21,9 +48,17 @@ void Drawable::SetCustomShader(const std::string& asset_name) {
 void Drawable::DoSetCustomUniforms() {
   if (custom_shader_) {
     for (auto& cu : custom_uniforms_)
-      std::visit([&](auto&& arg) { custom_shader_->SetUniform(cu.first, arg); },
-                 cu.second);
+      std::visit(
+          [&](auto&& arg) { custom_shader_->SetUniform(cu.second.id, arg); },
+          cu.second.value);
   }
 }
 
+Drawable::CustomUniform& Drawable::GetCustomUniform(base::AssetId name) {
+  auto [it, inserted] = custom_uniforms_.try_emplace(name);
+  if (inserted)
+    it->second.id = Shader::GetUniformId(name.GetName());
+  return it->second;
+}
+
 }  // namespace eng
@@ -1,16 +1,20 @@
 #ifndef ENGINE_DRAWABLE_H
 #define ENGINE_DRAWABLE_H
 
+#include <cstdint>
 #include <memory>
 #include <string>
-#include <unordered_map>
 #include <variant>
 
+#include "base/asset_id.h"
+#include "base/flat_hash_map.h"
 #include "base/vecmath.h"
+#include "engine/renderer/renderer_types.h"
 
 namespace eng {
 
 class Shader;
+class SpriteBatch;
 
 class Drawable {
  public:
@@ -22,8 +26,12 @@ class Drawable {
 
   virtual void Draw(float frame_frac) = 0;
 
-  void SetZOrder(int z) { z_order_ = z; }
-  void SetVisible(bool visible) { visible_ = visible; }
+  // Adds the drawable to the batch instead of drawing it with Draw(). Returns
+  // false if the drawable can't be batched, e.g. it uses a custom shader.
+  virtual bool AddToBatch(SpriteBatch* batch) { return false; }
+
+  void SetZOrder(int z);
+  void SetVisible(bool visible);
 
   int GetZOrder() const { return z_order_; }
   bool IsVisible() const { return visible_; }
@@ -32,7 +40,12 @@ class Drawable {
 
   template <typename T>
   void SetCustomUniform(const std::string& name, T value) {
-    custom_uniforms_[name] = UniformValue(value);
+    SetCustomUniform(base::AssetId(name), value);
+  }
+
+  template <typename T>
+  void SetCustomUniform(base::AssetId name, T value) {
+    GetCustomUniform(name).value = UniformValue(value);
   }
 
  protected:
@@ -47,11 +60,26 @@ class Drawable {
                                     float,
                                     int>;
 
+  struct CustomUniform {
+    // Resolved when the uniform is first set.
+    UniformId id = 0;
+    UniformValue value;
+  };
+
+  friend class RenderQueue;
+
   bool visible_ = false;
   int z_order_ = 0;
 
+  // Creation order. Breaks ties between drawables with the same z-order.
+  uint64_t sequence_ = 0;
+  // Slot in the render queue while visible.
+  size_t queue_index_ = 0;
+
   std::shared_ptr<Shader> custom_shader_;
-  std::unordered_map<std::string, UniformValue> custom_uniforms_;
+  base::FlatHashMap<base::AssetId, CustomUniform> custom_uniforms_;
+
+  CustomUniform& GetCustomUniform(base::AssetId name);
 };
 
 }  // namespace eng
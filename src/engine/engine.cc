@@ -1,8 +1,10 @@
 #include "engine/engine.h"
 
+#include "base/frame_arena.h"
 #include "base/log.h"
 #include "base/task_runner.h"
 #include "base/timer.h"
+#include "base/trace.h"
 #include "engine/animator.h"
 #include "engine/asset/font.h"
 #include "engine/asset/image.h"
@@ -23,6 +25,63 @@ using namespace base;
 
 namespace eng {
 
+namespace {
+
+Json::Value DurationToJson(const DurationHistogram& histogram) {
+  Json::Value value;
+  value["mean_us"] = histogram.mean() * 1000000;
+  value["p50_us"] = histogram.Percentile(50) * 1000000;
+  value["p99_us"] = histogram.Percentile(99) * 1000000;
+  value["max_us"] = histogram.max() * 1000000;
+  for (int i = 0; i < DurationHistogram::kNumBuckets; ++i)
+    value["buckets"].append(Json::UInt64(histogram.buckets()[i]));
+  return value;
+}
+
+Json::Value TaskMetricsToJson(const TaskMetrics& metrics) {
+  Json::Value value;
+  value["queue_depth"] = Json::UInt64(metrics.GetQueueDepth());
+  value["max_queue_depth"] = Json::UInt64(metrics.GetMaxQueueDepth());
+  value["contention_count"] = Json::UInt64(metrics.GetContentionCount());
+  value["locations"] = Json::arrayValue;
+  for (auto& stats : metrics.GetLocationStats()) {
+    Json::Value location;
+    location["function"] = stats.location.function_name();
+    location["file"] = stats.location.file_name();
+    location["line"] = stats.location.line();
+    location["count"] = Json::UInt64(stats.run_time.count());
+    location["queue_time"] = DurationToJson(stats.queue_time);
+    location["run_time"] = DurationToJson(stats.run_time);
+    value["locations"].append(location);
+  }
+  return value;
+}
+
+void ShowTaskMetrics(const char* name, const TaskMetrics& metrics) {
+  if (!ImGui::TreeNode(name))
+    return;
+
+  ImGui::Text("queue depth %zu (max %zu), contention %llu",
+              metrics.GetQueueDepth(), metrics.GetMaxQueueDepth(),
+              (unsigned long long)metrics.GetContentionCount());
+
+  // Show the locations that took the most time.
+  constexpr size_t kMaxLocations = 8;
+  auto location_stats = metrics.GetLocationStats();
+  for (size_t i = 0; i < location_stats.size() && i < kMaxLocations; ++i) {
+    auto& stats = location_stats[i];
+    ImGui::Text("%s:%d x%llu wait p99 %.2fms run p99 %.2fms max %.2fms",
+                stats.location.base_name(), stats.location.line(),
+                (unsigned long long)stats.run_time.count(),
+                stats.queue_time.Percentile(99) * 1000,
+                stats.run_time.Percentile(99) * 1000,
+                stats.run_time.max() * 1000);
+  }
+  ImGui::TreePop();
+}
+
+}  // namespace
+
 extern void KaliberMain(Platform* platform) {
   TaskRunner::CreateThreadLocalTaskRunner();
   Engine(platform).Run();
@@ -49,6 +108,7 @@ Engine::~Engine() noexcept {
   textures_.clear();
   shaders_.clear();
   quad_.Destroy();
+  sprite_batch_.Destroy();
   pass_through_shader_.Destroy();
   solid_shader_.Destroy();
   renderer_.reset();
@@ -111,6 +171,8 @@ void Engine::Initialize() {
   CHECK(game_) << "No game found to run.";
   CHECK(game_->PreInitialize()) << "Failed to pre-initialize the game.";
 
+  BuildTextureAtlas();
+
   // Create resources and let the game finalize initialization.
   CreateRenderResources();
   WaitForAsyncWork();
@@ -123,13 +185,17 @@ void Engine::Initialize() {
 }
 
 void Engine::Update(float delta_time) {
+  TRACE_SCOPE("Engine::Update");
+  FrameArena::ForCurrentThread().Reset();
+
   seconds_accumulated_ += delta_time;
   ++tick_;
 
   imgui_backend_.NewFrame(delta_time);
 
-  for (auto d : animators_)
-    d->Update(delta_time);
+  for (auto* node = animators_.head(); node != animators_.end();
+       node = node->next())
+    node->value()->Update(delta_time);
 
   game_->Update(delta_time);
 
@@ -146,6 +212,9 @@ void Engine::Update(float delta_time) {
 }
 
 void Engine::Draw(float frame_frac) {
+  TRACE_SCOPE("Engine::Draw");
+  FrameArena::ForCurrentThread().Reset();
+
   for (auto& t : pending_texture_updates_) {
     auto it = textures_.find(t.first);
     if (it == textures_.end())
@@ -156,47 +225,46 @@ void Engine::Draw(float frame_frac) {
   }
   pending_texture_updates_.clear();
 
-  for (auto d : animators_)
-    d->Evaluate(time_step_ * frame_frac);
+  for (auto* node = animators_.head(); node != animators_.end();
+       node = node->next())
+    node->value()->Evaluate(time_step_ * frame_frac);
+
+  FrameUniforms frame;
+  frame.projection = projection_;
+  frame.viewport_size = GetViewportSize();
+  frame.time = seconds_accumulated_;
+  renderer_->SetFrameUniforms(frame);
+
+  render_queue_.Prepare();
 
-  drawables_.sort(
-      [](auto& a, auto& b) { return a->GetZOrder() < b->GetZOrder(); });
+  sprite_batch_.Begin();
+  render_queue_.ForEach([&](Drawable* d) {
+    if (!d->AddToBatch(&sprite_batch_))
+      sprite_batch_.AddDrawable(d);
+  });
 
   renderer_->PrepareForDrawing();
-  for (auto d : drawables_) {
-    if (d->IsVisible())
-      d->Draw(frame_frac);
-  }
+  sprite_batch_.End(frame_frac);
   imgui_backend_.Draw();
   renderer_->Present();
+  render_state_stats_ = renderer_->GetAndResetStateStats();
 }
 
 void Engine::AddDrawable(Drawable* drawable) {
-  DCHECK(std::find(drawables_.begin(), drawables_.end(), drawable) ==
-         drawables_.end());
-  drawables_.push_back(drawable);
+  render_queue_.Add(drawable);
 }
 
 void Engine::RemoveDrawable(Drawable* drawable) {
-  auto it = std::find(drawables_.begin(), drawables_.end(), drawable);
-  if (it != drawables_.end()) {
-    drawables_.erase(it);
-    return;
-  }
+  render_queue_.Remove(drawable);
 }
 
 void Engine::AddAnimator(Animator* animator) {
-  DCHECK(std::find(animators_.begin(), animators_.end(), animator) ==
-         animators_.end());
-  animators_.push_back(animator);
+  animators_.Append(animator);
 }
 
 void Engine::RemoveAnimator(Animator* animator) {
-  auto it = std::find(animators_.begin(), animators_.end(), animator);
-  if (it != animators_.end()) {
-    animators_.erase(it);
-    return;
-  }
+  if (animator->IsInList())
+    animator->RemoveFromList();
 }
 
 void Engine::CreateRenderer(RendererType type) {
@@ -245,7 +313,8 @@ void Engine::SetImageSource(const std::string& asset_name,
 void Engine::SetImageSource(const std::string& asset_name,
                             CreateImageCB create_image,
                             bool persistent) {
-  if (textures_.contains(asset_name)) {
+  AssetId asset_id(asset_name);
+  if (textures_.contains(asset_id)) {
     DLOG(0) << "Texture already exists: " << asset_name;
     return;
   }
@@ -253,13 +322,24 @@ void Engine::SetImageSource(const std::string& asset_name,
   std::shared_ptr<Texture> texture;
   if (persistent)
     texture = std::make_shared<Texture>(renderer_.get());
-  textures_[asset_name] = {texture, texture, create_image};
+  textures_[asset_id] = {texture, texture, create_image};
+}
+
+void Engine::SetAtlasImageSource(const std::string& asset_name,
+                                 const std::string& file_name,
+                                 bool persistent) {
+  DCHECK(engine_state_ == State::kPreInitializing);
+
+  // Used if the image doesn't make it into the atlas.
+  SetImageSource(asset_name, file_name, persistent);
+  texture_atlas_.AddImage(AssetId(asset_name), file_name);
 }
 
 void Engine::RefreshImage(const std::string& asset_name) {
   DCHECK(engine_state_ != State::kPreInitializing);
 
-  auto it = textures_.find(asset_name);
+  AssetId asset_id(asset_name);
+  auto it = textures_.find(asset_id);
   if (it == textures_.end()) {
     DLOG(0) << "Texture not found: " << asset_name;
     return;
@@ -269,16 +349,23 @@ void Engine::RefreshImage(const std::string& asset_name) {
   if (texture) {
     auto image = it->second.create_image();
     if (image)
-      pending_texture_updates_[asset_name] = std::move(image);
+      pending_texture_updates_[asset_id] = std::move(image);
   }
 }
 
 std::shared_ptr<Texture> Engine::AcquireTexture(const std::string& asset_name) {
+  return AcquireTexture(AssetId(asset_name));
+}
+
+std::shared_ptr<Texture> Engine::AcquireTexture(AssetId asset_id) {
   DCHECK(engine_state_ != State::kPreInitializing);
 
-  auto it = textures_.find(asset_name);
+  if (const TextureAtlas::Region* region = texture_atlas_.GetRegion(asset_id))
+    asset_id = atlas_pages_[region->page];
+
+  auto it = textures_.find(asset_id);
   if (it == textures_.end()) {
-    DLOG(0) << "Texture not found: " << asset_name;
+    DLOG(0) << "Texture not found: " << asset_id.GetName();
     return nullptr;
   }
 
@@ -291,6 +378,10 @@ std::shared_ptr<Texture> Engine::AcquireTexture(const std::string& asset_name) {
   return texture;
 }
 
+const TextureAtlas::Region* Engine::GetAtlasRegion(AssetId asset_id) const {
+  return texture_atlas_.GetRegion(asset_id);
+}
+
 std::shared_ptr<Texture> Engine::GetTexture(TextureResource& resource,
                                             bool create) {
   std::shared_ptr<Texture> texture = resource.persistent_ptr;
@@ -306,20 +397,25 @@ std::shared_ptr<Texture> Engine::GetTexture(TextureResource& resource,
 
 void Engine::SetShaderSource(const std::string& asset_name,
                              const std::string& file_name) {
-  if (shaders_.contains(asset_name)) {
+  AssetId asset_id(asset_name);
+  if (shaders_.contains(asset_id)) {
     DLOG(0) << "Shader already exists: " << asset_name;
     return;
   }
 
-  shaders_[asset_name] = {{}, file_name};
+  shaders_[asset_id] = {{}, file_name};
 }
 
 std::shared_ptr<Shader> Engine::GetShader(const std::string& asset_name) {
+  return GetShader(AssetId(asset_name));
+}
+
+std::shared_ptr<Shader> Engine::GetShader(AssetId asset_id) {
   DCHECK(engine_state_ != State::kPreInitializing);
 
-  auto it = shaders_.find(asset_name);
+  auto it = shaders_.find(asset_id);
   if (it == shaders_.end()) {
-    DLOG(0) << "Shader not found: " << asset_name;
+    DLOG(0) << "Shader not found: " << asset_id.GetName();
     return nullptr;
   }
 
@@ -342,30 +438,33 @@ std::shared_ptr<Shader> Engine::GetShader(const std::string& asset_name) {
 void Engine::SetAudioSource(const std::string& asset_name,
                             const std::string& file_name,
                             bool stream) {
-  if (audio_buses_.contains(asset_name)) {
+  AssetId asset_id(asset_name);
+  if (audio_buses_.contains(asset_id)) {
     DLOG(0) << "AudioBus already exists: " << asset_name;
     return;
   }
 
   auto sound = std::make_shared<Sound>();
-  audio_buses_[asset_name] = sound;
+  audio_buses_[asset_id] = sound;
 
   if (engine_state_ == State::kPreInitializing) {
-    ++async_work_count_;
-    thread_pool_.PostTaskAndReply(
-        HERE, std::bind(&Sound::Load, sound, file_name, stream),
-        [&]() -> void { --async_work_count_; });
+    async_work_.Spawn(HERE,
+                      std::bind(&Sound::Load, sound, file_name, stream));
   } else {
     sound->Load(file_name, stream);
   }
 }
 
 std::shared_ptr<AudioBus> Engine::GetAudioBus(const std::string& asset_name) {
+  return GetAudioBus(AssetId(asset_name));
+}
+
+std::shared_ptr<AudioBus> Engine::GetAudioBus(AssetId asset_id) {
   DCHECK(engine_state_ != State::kPreInitializing);
 
-  auto it = audio_buses_.find(asset_name);
+  auto it = audio_buses_.find(asset_id);
   if (it == audio_buses_.end()) {
-    DLOG(0) << "AudioBus not found: " << asset_name;
+    DLOG(0) << "AudioBus not found: " << asset_id.GetName();
     return nullptr;
   }
 
@@ -442,6 +541,14 @@ bool Engine::Replay(const std::string file_name, Json::Value& payload) {
   return replaying_;
 }
 
+bool Engine::DumpTaskMetrics(const std::string& file_name) {
+  PersistentData data;
+  data.root()["main_thread"] =
+      TaskMetricsToJson(TaskRunner::GetThreadLocalTaskRunner()->GetMetrics());
+  data.root()["thread_pool"] = TaskMetricsToJson(thread_pool_.GetMetrics());
+  return data.SaveAs(file_name, PersistentData::kShared);
+}
+
 void Engine::Vibrate(int duration) {
   if (vibration_enabled_)
     platform_->Vibrate(duration);
@@ -558,16 +665,23 @@ void Engine::AddInputEvent(std::unique_ptr<InputEvent> event) {
     case InputEvent::kDragEnd:
       if (((GetViewportSize() / 2) * 0.9f - event->GetVector()).Length() <=
           0.25f) {
-        stats_visible_ = !stats_visible_;
+        SetStatsVisible(!stats_visible_);
         // TODO: Enqueue DragCancel so we can consume this event.
       }
       break;
     case InputEvent::kKeyPress:
       if (event->GetKeyPress() == 's') {
-        stats_visible_ = !stats_visible_;
+        SetStatsVisible(!stats_visible_);
+        // Consume event.
+        return;
+      }
+#if defined(ENABLE_TRACING)
+      if (event->GetKeyPress() == 't') {
+        ToggleTracing();
         // Consume event.
         return;
       }
+#endif
       break;
     default:
       break;
@@ -595,6 +709,25 @@ void Engine::CreateRendererInternal(RendererType type) {
   CreateTextureCompressors();
 }
 
+void Engine::BuildTextureAtlas() {
+  if (!texture_atlas_.Build("texture_atlas.json"))
+    return;
+
+  // Pages are created like any other persistent image.
+  for (size_t i = 0; i < texture_atlas_.GetNumPages(); ++i) {
+    std::string asset_name = "texture_atlas_page_" + std::to_string(i);
+    SetImageSource(
+        asset_name,
+        [this, i]() -> std::unique_ptr<Image> {
+          auto image = texture_atlas_.CreatePageImage(i);
+          image->Compress();
+          return image;
+        },
+        true);
+    atlas_pages_.push_back(AssetId(asset_name));
+  }
+}
+
 void Engine::CreateTextureCompressors() {
   tex_comp_alpha_.reset();
   tex_comp_opaque_.reset();
@@ -669,17 +802,17 @@ void Engine::CreateRenderResources() {
     LOG(0) << "Could not create solid shader.";
   }
 
+  sprite_batch_.CreateRenderResources(renderer_.get());
+
   imgui_backend_.CreateRenderResources(renderer_.get());
 
   for (auto& t : textures_) {
     std::shared_ptr<Texture> texture = t.second.texture.lock();
     if (texture) {
       texture->SetRenderer(renderer_.get());
-      ++async_work_count_;
-      thread_pool_.PostTaskAndReplyWithResult<std::unique_ptr<Image>>(
+      async_work_.SpawnAndReplyWithResult<std::unique_ptr<Image>>(
           HERE, t.second.create_image,
-          [&, ptr = texture](std::unique_ptr<Image> image) -> void {
-            --async_work_count_;
+          [ptr = texture](std::unique_ptr<Image> image) -> void {
             if (image)
               ptr->Update(std::move(image));
           });
@@ -690,8 +823,7 @@ void Engine::CreateRenderResources() {
     std::shared_ptr<Shader> shader = s.second.shader.lock();
     if (shader) {
       shader->SetRenderer(renderer_.get());
-      ++async_work_count_;
-      thread_pool_.PostTaskAndReplyWithResult<std::unique_ptr<ShaderSource>>(
+      async_work_.SpawnAndReplyWithResult<std::unique_ptr<ShaderSource>>(
           HERE,
           [file_name = s.second.file_name]() -> std::unique_ptr<ShaderSource> {
             auto source = std::make_unique<ShaderSource>();
@@ -700,7 +832,6 @@ void Engine::CreateRenderResources() {
             return source;
           },
           [&, ptr = shader](std::unique_ptr<ShaderSource> source) -> void {
-            --async_work_count_;
             if (source)
               ptr->Create(std::move(source), quad_.vertex_description(),
                           quad_.primitive(), false);
@@ -710,10 +841,33 @@ void Engine::CreateRenderResources() {
 }
 
 void Engine::WaitForAsyncWork() {
-  while (async_work_count_ > 0) {
+  // Help the pool with loading instead of spinning. Keep running the replies
+  // and processing platform events in between, long loads must not starve
+  // lifecycle and input events.
+  async_work_.Wait([&]() -> void {
     TaskRunner::GetThreadLocalTaskRunner()->RunTasks<Consumer::Single>();
     platform_->Update();
+  });
+
+  // Run the replies to finalize the resources on this thread.
+  TaskRunner::GetThreadLocalTaskRunner()->RunTasks<Consumer::Single>();
+}
+
+void Engine::SetStatsVisible(bool visible) {
+  stats_visible_ = visible;
+  TaskRunner::GetThreadLocalTaskRunner()->GetMetrics().SetEnabled(visible);
+  thread_pool_.GetMetrics().SetEnabled(visible);
+}
+
+void Engine::ToggleTracing() {
+  if (!IsTracing()) {
+    LOG(0) << "Tracing started.";
+    StartTracing();
+    return;
   }
+  std::string file_path = GetSharedDataPath() + "trace.json";
+  if (StopTracing(file_path))
+    LOG(0) << "Trace saved to " << file_path;
 }
 
 void Engine::ShowStats() {
@@ -727,6 +881,29 @@ void Engine::ShowStats() {
   ImGui::Begin("Stats", nullptr, window_flags);
   ImGui::Text("%s", renderer_->GetDebugName());
   ImGui::Text("%d fps", fps_);
+  ImGui::Text("%zu drawables", render_queue_.size());
+  ImGui::Text("%zu sprites in %zu batches, %zu draw calls",
+              sprite_batch_.num_sprites(), sprite_batch_.num_batches(),
+              sprite_batch_.num_draw_calls());
+  ImGui::Text("%zu uniforms set, %zu skipped",
+              render_state_stats_.uniforms_issued,
+              render_state_stats_.uniforms_skipped);
+  ImGui::Text("%zu state changes, %zu skipped",
+              render_state_stats_.states_issued,
+              render_state_stats_.states_skipped);
+  FrameArena& arena = FrameArena::ForCurrentThread();
+  ImGui::Text("frame arena %zu KB (peak %zu KB, capacity %zu KB)",
+              arena.GetBytesUsed() / 1024, arena.GetPeakBytesUsed() / 1024,
+              arena.GetCapacity() / 1024);
+  ShowTaskMetrics("Main thread tasks",
+                  TaskRunner::GetThreadLocalTaskRunner()->GetMetrics());
+  ShowTaskMetrics("Thread pool tasks", thread_pool_.GetMetrics());
+  if (ImGui::Button("Dump task metrics"))
+    DumpTaskMetrics("task_metrics.json");
+#if defined(ENABLE_TRACING)
+  if (ImGui::Button(IsTracing() ? "Stop tracing" : "Start tracing"))
+    ToggleTracing();
+#endif
   ImGui::End();
 }
 
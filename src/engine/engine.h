@@ -3,17 +3,24 @@
 
 #include <deque>
 #include <functional>
-#include <list>
 #include <memory>
-#include <unordered_map>
+#include <vector>
 
+#include "base/asset_id.h"
+#include "base/flat_hash_map.h"
+#include "base/linked_list.h"
 #include "base/random.h"
+#include "base/task_group.h"
 #include "base/thread_pool.h"
 #include "base/vecmath.h"
+#include "engine/asset/texture_atlas.h"
 #include "engine/imgui_backend.h"
 #include "engine/persistent_data.h"
+#include "engine/render_queue.h"
+#include "engine/sprite_batch.h"
 #include "engine/platform/platform_observer.h"
 #include "engine/renderer/geometry.h"
+#include "engine/renderer/renderer_types.h"
 #include "engine/renderer/shader.h"
 #include "engine/renderer/texture.h"
 
@@ -68,17 +75,33 @@ class Engine : public PlatformObserver {
                       CreateImageCB create_image,
                       bool persistent = false);
 
+  // Like SetImageSource, but the image is packed into a shared atlas page at
+  // load time, so it can be batched with other atlas images. Atlas pages are
+  // persistent. |persistent| applies if the image doesn't fit in the atlas and
+  // gets its own texture. Must be called during pre-initialization.
+  void SetAtlasImageSource(const std::string& asset_name,
+                           const std::string& file_name,
+                           bool persistent = false);
+
   void RefreshImage(const std::string& asset_name);
+  // Images in the atlas return the page texture.
   std::shared_ptr<Texture> AcquireTexture(const std::string& asset_name);
+  std::shared_ptr<Texture> AcquireTexture(base::AssetId asset_id);
+
+  // Region of the atlas page the image is packed into, or nullptr if the image
+  // has its own texture.
+  const TextureAtlas::Region* GetAtlasRegion(base::AssetId asset_id) const;
 
   void SetShaderSource(const std::string& asset_name,
                        const std::string& file_name);
   std::shared_ptr<Shader> GetShader(const std::string& asset_name);
+  std::shared_ptr<Shader> GetShader(base::AssetId asset_id);
 
   void SetAudioSource(const std::string& asset_name,
                       const std::string& file_name,
                       bool stream = false);
   std::shared_ptr<AudioBus> GetAudioBus(const std::string& asset_name);
+  std::shared_ptr<AudioBus> GetAudioBus(base::AssetId asset_id);
 
   std::unique_ptr<InputEvent> GetNextInputEvent();
 
@@ -87,6 +110,10 @@ class Engine : public PlatformObserver {
 
   bool Replay(const std::string file_name, Json::Value& payload);
 
+  // Writes the task scheduler metrics to a JSON file in the shared data
+  // directory. Metrics are collected while stats are visible.
+  bool DumpTaskMetrics(const std::string& file_name);
+
   // Vibrate (if supported by the platform) for the specified duration.
   void Vibrate(int duration);
 
@@ -189,21 +216,28 @@ class Engine : public PlatformObserver {
   std::unique_ptr<TextureCompressor> tex_comp_opaque_;
   std::unique_ptr<TextureCompressor> tex_comp_alpha_;
 
-  std::list<Drawable*> drawables_;
+  // Visible drawables in draw order.
+  RenderQueue render_queue_;
+  SpriteBatch sprite_batch_;
+
+  base::LinkedList<Animator> animators_;
 
-  std::list<Animator*> animators_;
+  // Resources mapped by interned asset name.
+  base::FlatHashMap<base::AssetId, TextureResource> textures_;
 
-  // Resources mapped by asset name.
-  std::unordered_map<std::string, TextureResource> textures_;
-  std::unordered_map<std::string, ShaderResource> shaders_;
-  std::unordered_map<std::string, std::shared_ptr<AudioBus>> audio_buses_;
+  TextureAtlas texture_atlas_;
+  // Texture resources of the atlas pages.
+  std::vector<base::AssetId> atlas_pages_;
+  base::FlatHashMap<base::AssetId, ShaderResource> shaders_;
+  base::FlatHashMap<base::AssetId, std::shared_ptr<AudioBus>> audio_buses_;
 
-  std::unordered_map<std::string, std::unique_ptr<Image>>
+  base::FlatHashMap<base::AssetId, std::unique_ptr<Image>>
       pending_texture_updates_;
 
   State engine_state_ = State::kUninitialized;
 
-  size_t async_work_count_ = 0;
+  // Loading work spawned while creating render resources.
+  base::TaskGroup async_work_;
 
   bool stats_visible_ = false;
 
@@ -212,6 +246,9 @@ class Engine : public PlatformObserver {
   float fps_seconds_ = 0;
   int fps_ = 0;
 
+  // Of the last frame.
+  RenderStateStats render_state_stats_;
+
   float seconds_accumulated_ = 0.0f;
   float time_step_ = 1.0f / 60.0f;
   size_t tick_ = 0;
@@ -243,6 +280,8 @@ class Engine : public PlatformObserver {
 
   void CreateRendererInternal(RendererType type);
 
+  void BuildTextureAtlas();
+
   void CreateTextureCompressors();
 
   void CreateProjectionMatrix();
@@ -255,6 +294,12 @@ class Engine : public PlatformObserver {
 
   std::shared_ptr<Texture> GetTexture(TextureResource& resource, bool create);
 
+  void SetStatsVisible(bool visible);
+
+  // Starts tracing or stops and writes the trace to trace.json in the shared
+  // data directory.
+  void ToggleTracing();
+
   void ShowStats();
 
   Engine(const Engine&) = delete;
@@ -5,11 +5,31 @@
 #include "engine/renderer/geometry.h"
 #include "engine/renderer/shader.h"
 #include "engine/renderer/texture.h"
+#include "engine/sprite_batch.h"
 
 using namespace base;
 
 namespace eng {
 
+namespace {
+
+struct Uniforms {
+  UniformId offset = Shader::GetUniformId("offset");
+  UniformId scale = Shader::GetUniformId("scale");
+  UniformId rotation = Shader::GetUniformId("rotation");
+  UniformId tex_offset = Shader::GetUniformId("tex_offset");
+  UniformId tex_scale = Shader::GetUniformId("tex_scale");
+  UniformId color = Shader::GetUniformId("color");
+  UniformId texture_0 = Shader::GetUniformId("texture_0");
+};
+
+const Uniforms& GetUniforms() {
+  static const Uniforms uniforms;
+  return uniforms;
+}
+
+}  // namespace
+
 ImageQuad::ImageQuad() = default;
 
 ImageQuad::~ImageQuad() {
@@ -21,6 +41,7 @@ ImageQuad& ImageQuad::Create(const std::string& asset_name,
                              int frame_width,
                              int frame_height) {
   texture_ = Engine::Get().AcquireTexture(asset_name);
+  atlas_region_ = Engine::Get().GetAtlasRegion(AssetId(asset_name));
   num_frames_ = std::move(num_frames);
   frame_width_ = frame_width;
   frame_height_ = frame_height;
@@ -35,6 +56,7 @@ ImageQuad& ImageQuad::Create(const std::string& asset_name,
 
 void ImageQuad::Destroy() {
   texture_.reset();
+  atlas_region_ = nullptr;
 }
 
 void ImageQuad::SetFrame(size_t frame) {
@@ -55,41 +77,68 @@ void ImageQuad::Draw(float frame_frac) {
 
   texture_->Activate(0);
 
-  Vector2f tex_scale = {GetFrameWidth() / texture_->GetWidth(),
-                        GetFrameHeight() / texture_->GetHeight()};
-
   Shader* shader = GetCustomShader().get();
   if (!shader)
     shader = &Engine::Get().GetPassThroughShader();
 
+  const Uniforms& u = GetUniforms();
   shader->Activate();
-  shader->SetUniform("offset", position_);
-  shader->SetUniform("scale", GetSize());
-  shader->SetUniform("rotation", rotation_);
-  shader->SetUniform("tex_offset", GetUVOffset(current_frame_));
-  shader->SetUniform("tex_scale", tex_scale);
-  shader->SetUniform("projection", Engine::Get().GetProjectionMatrix());
-  shader->SetUniform("color", color_);
-  shader->SetUniform("texture_0", 0);
+  shader->SetUniform(u.offset, position_);
+  shader->SetUniform(u.scale, GetSize());
+  shader->SetUniform(u.rotation, rotation_);
+  shader->SetUniform(u.tex_offset, GetUVOffset(current_frame_));
+  shader->SetUniform(u.tex_scale, GetUVScale());
+  shader->SetUniform(u.color, color_);
+  shader->SetUniform(u.texture_0, 0);
   DoSetCustomUniforms();
   Engine::Get().GetQuad().Draw();
 }
 
+bool ImageQuad::AddToBatch(SpriteBatch* batch) {
+  DCHECK(IsVisible());
+
+  if (GetCustomShader())
+    return false;
+
+  if (!texture_ || !texture_->IsValid())
+    return true;
+
+  batch->AddQuad(texture_.get(), position_, GetSize(), rotation_,
+                 GetUVOffset(current_frame_), GetUVScale(), color_);
+  return true;
+}
+
 float ImageQuad::GetFrameWidth() const {
-  return frame_width_ > 0 ? (float)frame_width_
-                          : texture_->GetWidth() / (float)num_frames_[0];
+  if (frame_width_ > 0)
+    return (float)frame_width_;
+  int width = atlas_region_ ? atlas_region_->width : texture_->GetWidth();
+  return width / (float)num_frames_[0];
 }
 
 float ImageQuad::GetFrameHeight() const {
-  return frame_height_ > 0 ? (float)frame_height_
-                           : texture_->GetHeight() / (float)num_frames_[1];
+  if (frame_height_ > 0)
+    return (float)frame_height_;
+  int height = atlas_region_ ? atlas_region_->height : texture_->GetHeight();
+  return height / (float)num_frames_[1];
 }
 
-// Return the uv offset for the given frame.
+// Return the uv offset for the given frame, in units of frame size.
 Vector2f ImageQuad::GetUVOffset(size_t frame) const {
   DCHECK(frame < GetNumFrames())
       << "asset: " << asset_name_ << " frame: " << frame;
-  return {(float)(frame % num_frames_[0]), (float)(frame / num_frames_[0])};
+  Vector2f offset = {(float)(frame % num_frames_[0]),
+                     (float)(frame / num_frames_[0])};
+  if (atlas_region_) {
+    offset += {atlas_region_->x / GetFrameWidth(),
+               atlas_region_->y / GetFrameHeight()};
+  }
+  return offset;
+}
+
+// Return the size of a frame in uv space.
+Vector2f ImageQuad::GetUVScale() const {
+  return {GetFrameWidth() / texture_->GetWidth(),
+          GetFrameHeight() / texture_->GetHeight()};
 }
 
 }  // namespace eng
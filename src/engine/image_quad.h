@@ -7,6 +7,7 @@
 
 #include "base/vecmath.h"
 #include "engine/animatable.h"
+#include "engine/asset/texture_atlas.h"
 
 namespace eng {
 
@@ -33,9 +34,12 @@ class ImageQuad final : public Animatable {
 
   // Drawable interface.
   void Draw(float frame_frac) final;
+  bool AddToBatch(SpriteBatch* batch) final;
 
  private:
   std::shared_ptr<Texture> texture_;
+  // Set if the image is packed into an atlas page. texture_ is the page then.
+  const TextureAtlas::Region* atlas_region_ = nullptr;
 
   size_t current_frame_ = 0;
   std::array<int, 2> num_frames_ = {1, 1};  // horizontal, vertical
@@ -50,6 +54,7 @@ class ImageQuad final : public Animatable {
   float GetFrameHeight() const;
 
   base::Vector2f GetUVOffset(size_t frame) const;
+  base::Vector2f GetUVScale() const;
 };
 
 }  // namespace eng
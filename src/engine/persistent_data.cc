@@ -1,6 +1,7 @@
 #include "engine/persistent_data.h"
 
 #include <memory>
+#include <sstream>
 
 #include "base/file.h"
 #include "engine/engine.h"
@@ -0,0 +1,16 @@
+#include "engine/platform/platform.h"
+
+#include <native_app_glue/android_native_app_glue.h>
+#include <unistd.h>
+
+namespace eng {
+
+void KaliberMain(Platform* platform);
+
+}  // namespace eng
+
+void android_main(android_app* app) {
+  eng::Platform platform(app);
+  eng::KaliberMain(&platform);
+  _exit(0);
+}
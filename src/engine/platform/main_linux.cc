@@ -0,0 +1,13 @@
+#include "engine/platform/platform.h"
+
+namespace eng {
+
+void KaliberMain(Platform* platform);
+
+}  // namespace eng
+
+int main(int argc, char** argv) {
+  eng::Platform platform;
+  eng::KaliberMain(&platform);
+  return 0;
+}
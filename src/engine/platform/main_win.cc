@@ -0,0 +1,16 @@
+#include "engine/platform/platform.h"
+
+namespace eng {
+
+void KaliberMain(Platform* platform);
+
+}  // namespace eng
+
+int WINAPI WinMain(HINSTANCE instance,
+                   HINSTANCE prev_instance,
+                   PSTR cmd_line,
+                   int cmd_show) {
+  eng::Platform platform(instance, cmd_show);
+  eng::KaliberMain(&platform);
+  return 0;
+}
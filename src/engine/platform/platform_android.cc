@@ -201,8 +201,6 @@ int32_t GetDensityDpi(android_app* app) {
 
 namespace eng {
 
-void KaliberMain(Platform* platform);
-
 int32_t Platform::HandleInput(android_app* app, AInputEvent* event) {
   Platform* platform = reinterpret_cast<Platform*>(app->userData);
 
@@ -437,9 +435,3 @@ ANativeWindow* Platform::GetWindow() {
 }
 
 }  // namespace eng
-
-void android_main(android_app* app) {
-  eng::Platform platform(app);
-  eng::KaliberMain(&platform);
-  _exit(0);
-}
@@ -14,8 +14,6 @@ using namespace base;
 
 namespace eng {
 
-void KaliberMain(Platform* platform);
-
 Platform::Platform() {
   LOG(0) << "Initializing platform.";
 
@@ -191,9 +189,3 @@ XVisualInfo* Platform::GetXVisualInfo(Display* display) {
 }
 
 }  // namespace eng
-
-int main(int argc, char** argv) {
-  eng::Platform platform;
-  eng::KaliberMain(&platform);
-  return 0;
-}
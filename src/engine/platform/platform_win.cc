@@ -11,8 +11,6 @@ using namespace base;
 
 namespace eng {
 
-void KaliberMain(Platform* platform);
-
 Platform::Platform(HINSTANCE instance, int cmd_show)
     : instance_(instance), cmd_show_(cmd_show) {
   LOG(0) << "Initializing platform.";
@@ -155,12 +153,3 @@ LRESULT CALLBACK Platform::WndProc(HWND wnd,
 }
 
 }  // namespace eng
-
-int WINAPI WinMain(HINSTANCE instance,
-                   HINSTANCE prev_instance,
-                   PSTR cmd_line,
-                   int cmd_show) {
-  eng::Platform platform(instance, cmd_show);
-  eng::KaliberMain(&platform);
-  return 0;
-}
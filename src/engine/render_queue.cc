@@ -0,0 +1,106 @@
+#include "engine/render_queue.h"
+
+#include <algorithm>
+
+#include "base/log.h"
+#include "engine/drawable.h"
+
+namespace eng {
+
+RenderQueue::RenderQueue() = default;
+
+RenderQueue::~RenderQueue() = default;
+
+void RenderQueue::Add(Drawable* drawable) {
+  Bucket* bucket = GetBucket(drawable->GetZOrder());
+  auto& drawables = bucket->drawables;
+  // Drawables are usually made visible in creation order. Otherwise the bucket
+  // needs sorting.
+  if (!drawables.empty() && drawables.back()->sequence_ > drawable->sequence_)
+    bucket->unsorted = true;
+  drawable->queue_index_ = drawables.size();
+  drawables.push_back(drawable);
+  ++size_;
+  if (bucket->unsorted)
+    MarkDirty(bucket);
+}
+
+void RenderQueue::Remove(Drawable* drawable) {
+  auto it = buckets_.find(drawable->GetZOrder());
+  DCHECK(it != buckets_.end());
+  Bucket* bucket = it->second.get();
+  auto& drawables = bucket->drawables;
+  DCHECK(drawable->queue_index_ < drawables.size());
+  DCHECK(drawables[drawable->queue_index_] == drawable);
+
+  --size_;
+  drawables[drawable->queue_index_] = nullptr;
+  ++bucket->num_removed;
+  // Trim the null slots at the end, so the last slot is never null.
+  while (!drawables.empty() && !drawables.back()) {
+    drawables.pop_back();
+    --bucket->num_removed;
+  }
+  if (!bucket->num_removed)
+    return;
+  MarkDirty(bucket);
+  // Don't let the null slots pile up if Prepare() is not called for a while.
+  if (!iterating_ && bucket->num_removed > drawables.size() / 2 + 16)
+    Compact(bucket);
+}
+
+void RenderQueue::Prepare() {
+  DCHECK(!iterating_);
+  for (Bucket* bucket : dirty_buckets_) {
+    Compact(bucket);
+    if (bucket->unsorted) {
+      std::sort(bucket->drawables.begin(), bucket->drawables.end(),
+                [](Drawable* a, Drawable* b) {
+                  return a->sequence_ < b->sequence_;
+                });
+      for (size_t i = 0; i < bucket->drawables.size(); ++i)
+        bucket->drawables[i]->queue_index_ = i;
+      bucket->unsorted = false;
+    }
+    bucket->dirty = false;
+  }
+  dirty_buckets_.clear();
+}
+
+RenderQueue::Bucket* RenderQueue::GetBucket(int z_order) {
+  auto [it, inserted] = buckets_.try_emplace(z_order);
+  if (inserted) {
+    it->second = std::make_unique<Bucket>();
+    it->second->z_order = z_order;
+    // New z-orders are rare, so keep the buckets in a sorted vector.
+    auto pos = std::lower_bound(
+        sorted_buckets_.begin(), sorted_buckets_.end(), z_order,
+        [](Bucket* bucket, int z) { return bucket->z_order < z; });
+    sorted_buckets_.insert(pos, it->second.get());
+  }
+  return it->second.get();
+}
+
+void RenderQueue::MarkDirty(Bucket* bucket) {
+  if (!bucket->dirty) {
+    bucket->dirty = true;
+    dirty_buckets_.push_back(bucket);
+  }
+}
+
+void RenderQueue::Compact(Bucket* bucket) {
+  if (!bucket->num_removed)
+    return;
+  auto& drawables = bucket->drawables;
+  size_t count = 0;
+  for (Drawable* drawable : drawables) {
+    if (drawable) {
+      drawable->queue_index_ = count;
+      drawables[count++] = drawable;
+    }
+  }
+  drawables.resize(count);
+  bucket->num_removed = 0;
+}
+
+}  // namespace eng
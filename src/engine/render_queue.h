@@ -0,0 +1,82 @@
+#ifndef ENGINE_RENDER_QUEUE_H
+#define ENGINE_RENDER_QUEUE_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "base/flat_hash_map.h"
+
+namespace eng {
+
+class Drawable;
+
+// Holds the visible drawables in draw order, i.e. by z-order and then by
+// creation order. Drawables are kept in one bucket per z-order. Add and Remove
+// are O(1), buckets that changed are sorted again on the next Prepare().
+class RenderQueue {
+ public:
+  RenderQueue();
+  ~RenderQueue();
+
+  RenderQueue(const RenderQueue&) = delete;
+  RenderQueue& operator=(const RenderQueue&) = delete;
+
+  void Add(Drawable* drawable);
+  void Remove(Drawable* drawable);
+
+  // Compacts and sorts the buckets that changed since the last call.
+  void Prepare();
+
+  // Calls fn for every drawable in draw order. fn may add and remove
+  // drawables. Drawables removed while iterating are skipped, drawables added
+  // while iterating may be skipped.
+  template <typename Fn>
+  void ForEach(Fn fn) {
+    ++iterating_;
+    // Adding a drawable with a new z-order inserts into sorted_buckets_, so
+    // iterate by index.
+    for (size_t i = 0; i < sorted_buckets_.size(); ++i) {
+      Bucket* bucket = sorted_buckets_[i];
+      for (size_t j = 0; j < bucket->drawables.size(); ++j) {
+        if (bucket->drawables[j])
+          fn(bucket->drawables[j]);
+      }
+      // Buckets inserted before this one shifted it forward. Don't visit it
+      // again.
+      while (sorted_buckets_[i] != bucket)
+        ++i;
+    }
+    --iterating_;
+  }
+
+  // Number of drawables in the queue.
+  size_t size() const { return size_; }
+
+ private:
+  struct Bucket {
+    int z_order = 0;
+    // Removed drawables leave a null slot behind until the bucket is
+    // compacted.
+    std::vector<Drawable*> drawables;
+    size_t num_removed = 0;
+    // In dirty_buckets_.
+    bool dirty = false;
+    // Drawables are not in creation order.
+    bool unsorted = false;
+  };
+
+  base::FlatHashMap<int, std::unique_ptr<Bucket>> buckets_;
+  std::vector<Bucket*> sorted_buckets_;
+  std::vector<Bucket*> dirty_buckets_;
+  size_t size_ = 0;
+  int iterating_ = 0;
+
+  Bucket* GetBucket(int z_order);
+  void MarkDirty(Bucket* bucket);
+  void Compact(Bucket* bucket);
+};
+
+}  // namespace eng
+
+#endif  // ENGINE_RENDER_QUEUE_H
@@ -1,12 +1,12 @@
 #include "engine/renderer/opengl/renderer_opengl.h"
 
-#include <algorithm>
 #include <cstring>
 #include <sstream>
+#include <type_traits>
 #include <unordered_set>
 
-#include "base/hash.h"
 #include "base/log.h"
+#include "base/trace.h"
 #include "base/vecmath.h"
 #include "engine/asset/image.h"
 #include "engine/asset/mesh.h"
@@ -34,7 +34,10 @@ const std::string kAttributeNames[eng::kAttribType_Max] = {
 }  // namespace
 
 RendererOpenGL::RendererOpenGL(base::Closure context_lost_cb)
-    : Renderer(context_lost_cb) {}
+    : Renderer(context_lost_cb),
+      frame_projection_id_(GetUniformId("frame_projection")),
+      frame_viewport_size_id_(GetUniformId("frame_viewport_size")),
+      frame_time_id_(GetUniformId("frame_time")) {}
 
 RendererOpenGL::~RendererOpenGL() {
   Shutdown();
@@ -55,20 +58,28 @@ int RendererOpenGL::GetScreenHeight() const {
 }
 
 void RendererOpenGL::SetViewport(int x, int y, int width, int height) {
-  glViewport(0, 0, width, height);
+  SetViewportInternal(width, height);
 }
 
 void RendererOpenGL::ResetViewport() {
-  glViewport(0, 0, screen_width_, screen_height_);
+  SetViewportInternal(screen_width_, screen_height_);
 }
 
 void RendererOpenGL::SetScissor(int x, int y, int width, int height) {
-  glScissor(x, screen_height_ - y - height, width, height);
-  glEnable(GL_SCISSOR_TEST);
+  std::array<GLint, 4> scissor = {x, screen_height_ - y - height, width,
+                                  height};
+  if (scissor != scissor_) {
+    glScissor(scissor[0], scissor[1], scissor[2], scissor[3]);
+    scissor_ = scissor;
+    ++state_stats_.states_issued;
+  } else {
+    ++state_stats_.states_skipped;
+  }
+  SetScissorTest(true);
 }
 
 void RendererOpenGL::ResetScissor() {
-  glDisable(GL_SCISSOR_TEST);
+  SetScissorTest(false);
 }
 
 uint64_t RendererOpenGL::CreateGeometry(std::unique_ptr<Mesh> mesh) {
@@ -261,6 +272,7 @@ void RendererOpenGL::UpdateTexture(uint64_t resource_id,
                                    ImageFormat format,
                                    size_t data_size,
                                    uint8_t* image_data) {
+  TRACE_SCOPE("RendererOpenGL::UpdateTexture");
   auto it = textures_.find(resource_id);
   if (it == textures_.end())
     return;
@@ -336,6 +348,9 @@ void RendererOpenGL::ActivateTexture(uint64_t resource_id,
     glActiveTexture(GL_TEXTURE0 + texture_unit);
     glBindTexture(GL_TEXTURE_2D, it->second);
     active_texture_id_[texture_unit] = it->second;
+    ++state_stats_.states_issued;
+  } else {
+    ++state_stats_.states_skipped;
   }
 }
 
@@ -383,7 +398,17 @@ uint64_t RendererOpenGL::CreateShader(
   }
 
   uint64_t resource_id = ++last_resource_id_;
-  shaders_[resource_id] = {id, {}, enable_depth_test};
+  ShaderOpenGL& shader = shaders_[resource_id] = {id, {}, enable_depth_test};
+
+  // Resolve the frame uniforms now. Most shaders don't use them, so they
+  // shouldn't be reported as missing.
+  for (UniformId frame_id :
+       {frame_projection_id_, frame_viewport_size_id_, frame_time_id_}) {
+    if (frame_id >= shader.uniforms.size())
+      shader.uniforms.resize(frame_id + 1);
+    shader.uniforms[frame_id].location =
+        glGetUniformLocation(id, GetUniformName(frame_id).c_str());
+  }
   return resource_id;
 }
 
@@ -404,88 +429,90 @@ void RendererOpenGL::ActivateShader(uint64_t resource_id) {
   if (it->second.id != active_shader_id_) {
     glUseProgram(it->second.id);
     active_shader_id_ = it->second.id;
-    if (it->second.enable_depth_test)
-      glEnable(GL_DEPTH_TEST);
-    else
-      glDisable(GL_DEPTH_TEST);
+    ++state_stats_.states_issued;
+    SetDepthTest(it->second.enable_depth_test);
+  } else {
+    ++state_stats_.states_skipped;
   }
+  UpdateFrameUniforms(it->second);
 }
 
 void RendererOpenGL::SetUniform(uint64_t resource_id,
-                                const std::string& name,
+                                UniformId id,
                                 const base::Vector2f& val) {
   auto it = shaders_.find(resource_id);
   if (it == shaders_.end())
     return;
 
-  GLint index = GetUniformLocation(it->second.id, name, it->second.uniforms);
-  if (index >= 0)
-    glUniform2fv(index, 1, val.GetData());
+  UniformOpenGL& uniform = GetUniform(it->second, id);
+  if (uniform.location >= 0 && UpdateUniformValue(uniform, val))
+    glUniform2fv(uniform.location, 1, val.GetData());
 }
 
 void RendererOpenGL::SetUniform(uint64_t resource_id,
-                                const std::string& name,
+                                UniformId id,
                                 const base::Vector3f& val) {
   auto it = shaders_.find(resource_id);
   if (it == shaders_.end())
     return;
 
-  GLint index = GetUniformLocation(it->second.id, name, it->second.uniforms);
-  if (index >= 0)
-    glUniform3fv(index, 1, val.GetData());
+  UniformOpenGL& uniform = GetUniform(it->second, id);
+  if (uniform.location >= 0 && UpdateUniformValue(uniform, val))
+    glUniform3fv(uniform.location, 1, val.GetData());
 }
 
 void RendererOpenGL::SetUniform(uint64_t resource_id,
-                                const std::string& name,
+                                UniformId id,
                                 const base::Vector4f& val) {
   auto it = shaders_.find(resource_id);
   if (it == shaders_.end())
     return;
 
-  GLint index = GetUniformLocation(it->second.id, name, it->second.uniforms);
-  if (index >= 0)
-    glUniform4fv(index, 1, val.GetData());
+  UniformOpenGL& uniform = GetUniform(it->second, id);
+  if (uniform.location >= 0 && UpdateUniformValue(uniform, val))
+    glUniform4fv(uniform.location, 1, val.GetData());
 }
 
 void RendererOpenGL::SetUniform(uint64_t resource_id,
-                                const std::string& name,
+                                UniformId id,
                                 const base::Matrix4f& val) {
   auto it = shaders_.find(resource_id);
   if (it == shaders_.end())
     return;
 
-  GLint index = GetUniformLocation(it->second.id, name, it->second.uniforms);
-  if (index >= 0)
-    glUniformMatrix4fv(index, 1, GL_FALSE, val.GetData());
+  UniformOpenGL& uniform = GetUniform(it->second, id);
+  if (uniform.location >= 0 && UpdateUniformValue(uniform, val))
+    glUniformMatrix4fv(uniform.location, 1, GL_FALSE, val.GetData());
 }
 
-void RendererOpenGL::SetUniform(uint64_t resource_id,
-                                const std::string& name,
-                                float val) {
+void RendererOpenGL::SetUniform(uint64_t resource_id, UniformId id, float val) {
   auto it = shaders_.find(resource_id);
   if (it == shaders_.end())
     return;
 
-  GLint index = GetUniformLocation(it->second.id, name, it->second.uniforms);
-  if (index >= 0)
-    glUniform1f(index, val);
+  UniformOpenGL& uniform = GetUniform(it->second, id);
+  if (uniform.location >= 0 && UpdateUniformValue(uniform, val))
+    glUniform1f(uniform.location, val);
 }
 
-void RendererOpenGL::SetUniform(uint64_t resource_id,
-                                const std::string& name,
-                                int val) {
+void RendererOpenGL::SetUniform(uint64_t resource_id, UniformId id, int val) {
   auto it = shaders_.find(resource_id);
   if (it == shaders_.end())
     return;
 
-  GLint index = GetUniformLocation(it->second.id, name, it->second.uniforms);
-  if (index >= 0)
-    glUniform1i(index, val);
+  UniformOpenGL& uniform = GetUniform(it->second, id);
+  if (uniform.location >= 0 && UpdateUniformValue(uniform, val))
+    glUniform1i(uniform.location, val);
+}
+
+void RendererOpenGL::SetFrameUniforms(const FrameUniforms& frame) {
+  frame_uniforms_ = frame;
+  ++frame_uniforms_generation_;
 }
 
 void RendererOpenGL::PrepareForDrawing() {
-  glViewport(0, 0, screen_width_, screen_height_);
-  glDisable(GL_SCISSOR_TEST);
+  SetViewportInternal(screen_width_, screen_height_);
+  SetScissorTest(false);
 }
 
 void RendererOpenGL::ContextLost() {
@@ -577,6 +604,8 @@ bool RendererOpenGL::InitCommon() {
 
   glClearColor(0, 0, 0, 1);
 
+  ResetStateCache();
+
   is_initialized_ = true;
 
   return true;
@@ -647,6 +676,7 @@ bool RendererOpenGL::SetupVertexLayout(
 }
 
 GLuint RendererOpenGL::CreateShader(const char* source, GLenum type) {
+  TRACE_SCOPE("RendererOpenGL::CreateShader");
   GLuint shader = glCreateShader(type);
   if (shader) {
     glShaderSource(shader, 1, &source, NULL);
@@ -688,33 +718,105 @@ bool RendererOpenGL::BindAttributeLocation(GLuint id,
   return current > 0;
 }
 
-GLint RendererOpenGL::GetUniformLocation(
-    GLuint id,
-    const std::string& name,
-    std::vector<std::pair<size_t, GLuint>>& uniforms) {
-  // Check if we've encountered this uniform before.
-  auto hash = KR2Hash(name);
-  auto it = std::find_if(uniforms.begin(), uniforms.end(),
-                         [&](auto& r) { return hash == std::get<0>(r); });
-  GLint index;
-  if (it != uniforms.end()) {
-    // Yes, we already have the mapping.
-    index = std::get<1>(*it);
-  } else {
-    // No, ask the driver for the mapping and save it.
-    index = glGetUniformLocation(id, name.c_str());
-    if (index >= 0) {
-      DCHECK(std::find_if(uniforms.begin(), uniforms.end(),
-                          [&](auto& r) { return hash == std::get<0>(r); }) ==
-             uniforms.end())
-          << "Hash collision";
-      uniforms.emplace_back(std::make_pair(hash, index));
-    } else {
-      LOG(0) << "Cannot find uniform " << name.c_str() << " (shader: " << id
+RendererOpenGL::UniformOpenGL& RendererOpenGL::GetUniform(ShaderOpenGL& shader,
+                                                          UniformId id) {
+  if (id >= shader.uniforms.size())
+    shader.uniforms.resize(id + 1);
+
+  // Ask the driver only the first time the uniform is used.
+  UniformOpenGL& uniform = shader.uniforms[id];
+  if (uniform.location == kUnresolvedLocation) {
+    const std::string& name = GetUniformName(id);
+    uniform.location = glGetUniformLocation(shader.id, name.c_str());
+    if (uniform.location < 0) {
+      LOG(0) << "Cannot find uniform " << name << " (shader: " << shader.id
              << ")";
     }
   }
-  return index;
+  return uniform;
+}
+
+template <typename T>
+bool RendererOpenGL::UpdateUniformValue(UniformOpenGL& uniform, const T& val) {
+  static_assert(std::is_trivially_copyable_v<T> &&
+                sizeof(T) <= sizeof(uniform.value));
+  if (uniform.value_size == sizeof(T) &&
+      memcmp(uniform.value.data(), &val, sizeof(T)) == 0) {
+    ++state_stats_.uniforms_skipped;
+    return false;
+  }
+  memcpy(uniform.value.data(), &val, sizeof(T));
+  uniform.value_size = sizeof(T);
+  ++state_stats_.uniforms_issued;
+  return true;
+}
+
+void RendererOpenGL::UpdateFrameUniforms(ShaderOpenGL& shader) {
+  if (shader.frame_uniforms_generation == frame_uniforms_generation_)
+    return;
+  shader.frame_uniforms_generation = frame_uniforms_generation_;
+
+  UniformOpenGL& projection = shader.uniforms[frame_projection_id_];
+  if (projection.location >= 0 &&
+      UpdateUniformValue(projection, frame_uniforms_.projection)) {
+    glUniformMatrix4fv(projection.location, 1, GL_FALSE,
+                       frame_uniforms_.projection.GetData());
+  }
+  UniformOpenGL& viewport_size = shader.uniforms[frame_viewport_size_id_];
+  if (viewport_size.location >= 0 &&
+      UpdateUniformValue(viewport_size, frame_uniforms_.viewport_size)) {
+    glUniform2fv(viewport_size.location, 1,
+                 frame_uniforms_.viewport_size.GetData());
+  }
+  UniformOpenGL& time = shader.uniforms[frame_time_id_];
+  if (time.location >= 0 && UpdateUniformValue(time, frame_uniforms_.time))
+    glUniform1f(time.location, frame_uniforms_.time);
+}
+
+void RendererOpenGL::SetViewportInternal(int width, int height) {
+  std::array<GLint, 4> viewport = {0, 0, width, height};
+  if (viewport == viewport_) {
+    ++state_stats_.states_skipped;
+    return;
+  }
+  glViewport(0, 0, width, height);
+  viewport_ = viewport;
+  ++state_stats_.states_issued;
+}
+
+void RendererOpenGL::SetScissorTest(bool enable) {
+  if (scissor_test_ == enable) {
+    ++state_stats_.states_skipped;
+    return;
+  }
+  if (enable)
+    glEnable(GL_SCISSOR_TEST);
+  else
+    glDisable(GL_SCISSOR_TEST);
+  scissor_test_ = enable;
+  ++state_stats_.states_issued;
+}
+
+void RendererOpenGL::SetDepthTest(bool enable) {
+  if (depth_test_ == enable) {
+    ++state_stats_.states_skipped;
+    return;
+  }
+  if (enable)
+    glEnable(GL_DEPTH_TEST);
+  else
+    glDisable(GL_DEPTH_TEST);
+  depth_test_ = enable;
+  ++state_stats_.states_issued;
+}
+
+void RendererOpenGL::ResetStateCache() {
+  active_shader_id_ = 0;
+  active_texture_id_ = {};
+  viewport_.fill(-1);
+  scissor_.fill(-1);
+  scissor_test_ = -1;
+  depth_test_ = -1;
 }
 
 }  // namespace eng
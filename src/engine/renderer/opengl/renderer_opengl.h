@@ -72,21 +72,21 @@ class RendererOpenGL final : public Renderer {
   void ActivateShader(uint64_t resource_id) final;
 
   void SetUniform(uint64_t resource_id,
-                  const std::string& name,
+                  UniformId id,
                   const base::Vector2f& val) final;
   void SetUniform(uint64_t resource_id,
-                  const std::string& name,
+                  UniformId id,
                   const base::Vector3f& val) final;
   void SetUniform(uint64_t resource_id,
-                  const std::string& name,
+                  UniformId id,
                   const base::Vector4f& val) final;
   void SetUniform(uint64_t resource_id,
-                  const std::string& name,
+                  UniformId id,
                   const base::Matrix4f& val) final;
-  void SetUniform(uint64_t resource_id,
-                  const std::string& name,
-                  float val) final;
-  void SetUniform(uint64_t resource_id, const std::string& name, int val) final;
+  void SetUniform(uint64_t resource_id, UniformId id, float val) final;
+  void SetUniform(uint64_t resource_id, UniformId id, int val) final;
+
+  void SetFrameUniforms(const FrameUniforms& frame) final;
 
   void PrepareForDrawing() final;
   void Present() final;
@@ -117,13 +117,24 @@ class RendererOpenGL final : public Renderer {
     GLuint index_buffer_id = 0;
   };
 
+  static constexpr GLint kUnresolvedLocation = -2;
+
+  struct UniformOpenGL {
+    // -1 if the shader doesn't have the uniform.
+    GLint location = kUnresolvedLocation;
+    // Last value sent to the driver. Uniform values are part of the program
+    // object, so they stay valid when switching shaders.
+    size_t value_size = 0;
+    std::array<float, 16> value;
+  };
+
   struct ShaderOpenGL {
     GLuint id = 0;
-    std::vector<std::pair<size_t,  // Uniform name hash
-                          GLuint   // Uniform index
-                          >>
-        uniforms;
+    // Indexed by UniformId.
+    std::vector<UniformOpenGL> uniforms;
     bool enable_depth_test = false;
+    // Frame uniforms are up to date if it matches frame_uniforms_generation_.
+    uint64_t frame_uniforms_generation = 0;
   };
 
   std::unordered_map<uint64_t, GeometryOpenGL> geometries_;
@@ -131,8 +142,23 @@ class RendererOpenGL final : public Renderer {
   std::unordered_map<uint64_t, GLuint> textures_;
   uint64_t last_resource_id_ = 0;
 
+  // There are no uniform blocks in the GLSL versions we target, so the frame
+  // uniforms are plain uniforms. They are set when a shader is activated, once
+  // per frame.
+  FrameUniforms frame_uniforms_;
+  uint64_t frame_uniforms_generation_ = 0;
+  UniformId frame_projection_id_;
+  UniformId frame_viewport_size_id_;
+  UniformId frame_time_id_;
+
+  // Shadow of the driver state, used for skipping redundant calls.
   GLuint active_shader_id_ = 0;
   std::array<GLuint, kMaxTextureUnits> active_texture_id_ = {};
+  std::array<GLint, 4> viewport_ = {};
+  std::array<GLint, 4> scissor_ = {};
+  // -1 if unknown.
+  int scissor_test_ = -1;
+  int depth_test_ = -1;
 
   bool vertex_array_objects_ = false;
   bool npot_ = false;
@@ -169,9 +195,16 @@ class RendererOpenGL final : public Renderer {
                          std::vector<GeometryOpenGL::Element>& vertex_layout);
   GLuint CreateShader(const char* source, GLenum type);
   bool BindAttributeLocation(GLuint id, const VertexDescription& vd);
-  GLint GetUniformLocation(GLuint id,
-                           const std::string& name,
-                           std::vector<std::pair<size_t, GLuint>>& uniforms);
+  UniformOpenGL& GetUniform(ShaderOpenGL& shader, UniformId id);
+  template <typename T>
+  bool UpdateUniformValue(UniformOpenGL& uniform, const T& val);
+
+  void UpdateFrameUniforms(ShaderOpenGL& shader);
+
+  void SetViewportInternal(int width, int height);
+  void SetScissorTest(bool enable);
+  void SetDepthTest(bool enable);
+  void ResetStateCache();
 };
 
 }  // namespace eng
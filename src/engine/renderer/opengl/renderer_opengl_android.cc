@@ -3,6 +3,7 @@
 #include <android/native_window.h>
 
 #include "base/log.h"
+#include "base/trace.h"
 #include "engine/platform/platform.h"
 #include "third_party/android/GLContext.h"
 
@@ -51,13 +52,13 @@ void RendererOpenGL::Shutdown() {
 }
 
 void RendererOpenGL::Present() {
+  TRACE_SCOPE("RendererOpenGL::Present");
   if (EGL_SUCCESS != ndk_helper::GLContext::GetInstance()->Swap()) {
     ContextLost();
     return;
   }
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-  active_shader_id_ = 0;
-  active_texture_id_ = {};
+  ResetStateCache();
   fps_++;
 }
 
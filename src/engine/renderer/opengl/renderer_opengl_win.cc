@@ -1,6 +1,7 @@
 #include "engine/renderer/opengl/renderer_opengl.h"
 
 #include "base/log.h"
+#include "base/trace.h"
 #include "engine/platform/platform.h"
 
 namespace eng {
@@ -69,10 +70,10 @@ void RendererOpenGL::Shutdown() {
 }
 
 void RendererOpenGL::Present() {
+  TRACE_SCOPE("RendererOpenGL::Present");
   SwapBuffers(dc_);
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-  active_shader_id_ = 0;
-  active_texture_id_ = {};
+  ResetStateCache();
   fps_++;
 }
 
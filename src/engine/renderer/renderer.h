@@ -17,6 +17,16 @@ class Platform;
 
 enum class RendererType { kUnknown, kVulkan, kOpenGL };
 
+// Values shared by all shaders in a frame, read with the FRAME_* shader
+// macros. Matches the std140 layout of the Frame block in shader_source.cc.
+struct FrameUniforms {
+  base::Matrix4f projection;
+  // Size of the viewport in the units of the projection.
+  base::Vector2f viewport_size;
+  // Seconds since the engine started.
+  float time = 0;
+};
+
 class Renderer {
  public:
   static const unsigned kInvalidId = 0;
@@ -79,24 +89,25 @@ class Renderer {
   virtual void DestroyShader(uint64_t resource_id) = 0;
   virtual void ActivateShader(uint64_t resource_id) = 0;
 
+  // Uniforms that are not found in the shader are ignored.
   virtual void SetUniform(uint64_t resource_id,
-                          const std::string& name,
+                          UniformId id,
                           const base::Vector2f& val) = 0;
   virtual void SetUniform(uint64_t resource_id,
-                          const std::string& name,
+                          UniformId id,
                           const base::Vector3f& val) = 0;
   virtual void SetUniform(uint64_t resource_id,
-                          const std::string& name,
+                          UniformId id,
                           const base::Vector4f& val) = 0;
   virtual void SetUniform(uint64_t resource_id,
-                          const std::string& name,
+                          UniformId id,
                           const base::Matrix4f& val) = 0;
-  virtual void SetUniform(uint64_t resource_id,
-                          const std::string& name,
-                          float val) = 0;
-  virtual void SetUniform(uint64_t resource_id,
-                          const std::string& name,
-                          int val) = 0;
+  virtual void SetUniform(uint64_t resource_id, UniformId id, float val) = 0;
+  virtual void SetUniform(uint64_t resource_id, UniformId id, int val) = 0;
+
+  // Sets the frame uniforms for all shaders. Call once per frame, before
+  // drawing.
+  virtual void SetFrameUniforms(const FrameUniforms& frame) = 0;
 
   virtual void PrepareForDrawing() = 0;
   virtual void Present() = 0;
@@ -110,6 +121,12 @@ class Renderer {
 
   virtual size_t GetAndResetFPS() = 0;
 
+  RenderStateStats GetAndResetStateStats() {
+    RenderStateStats stats = state_stats_;
+    state_stats_ = {};
+    return stats;
+  }
+
   virtual const char* GetDebugName() = 0;
 
   virtual RendererType GetRendererType() { return RendererType::kUnknown; }
@@ -134,6 +151,8 @@ class Renderer {
 
   TextureCompression texture_compression_;
 
+  RenderStateStats state_stats_;
+
   base::Closure context_lost_cb_;
 
   Renderer(const Renderer&) = delete;
@@ -1,6 +1,9 @@
 #include "engine/renderer/renderer_types.h"
 
 #include <cstring>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
 
 #include "base/log.h"
 
@@ -10,10 +13,39 @@ namespace {
 // e.g. "p3f;c4b" for "position 3 floats, color 4 bytes".
 const char kLayoutDelimiter[] = ";/ \t";
 
+// Uniform names are never removed. Deque keeps the references returned by
+// GetUniformName valid as it grows.
+struct UniformTable {
+  std::unordered_map<std::string, eng::UniformId> ids;
+  std::deque<std::string> names;
+  std::mutex lock;
+};
+
+UniformTable& GetUniformTable() {
+  static UniformTable* table = new UniformTable;
+  return *table;
+}
+
 }  // namespace
 
 namespace eng {
 
+UniformId GetUniformId(const std::string& name) {
+  UniformTable& table = GetUniformTable();
+  std::lock_guard<std::mutex> scoped_lock(table.lock);
+  auto [it, inserted] = table.ids.try_emplace(name, table.names.size());
+  if (inserted)
+    table.names.push_back(name);
+  return it->second;
+}
+
+const std::string& GetUniformName(UniformId id) {
+  UniformTable& table = GetUniformTable();
+  std::lock_guard<std::mutex> scoped_lock(table.lock);
+  DCHECK(id < table.names.size());
+  return table.names[id];
+}
+
 const char* ImageFormatToString(ImageFormat format) {
   switch (format) {
     case ImageFormat::kRGBA32:
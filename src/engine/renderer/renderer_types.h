@@ -1,6 +1,7 @@
 #ifndef ENGINE_RENDERER_RENDERER_TYPES_H
 #define ENGINE_RENDERER_RENDERER_TYPES_H
 
+#include <cstdint>
 #include <string>
 #include <tuple>
 #include <vector>
@@ -43,6 +44,24 @@ using DataTypeSize = size_t;
 using VertexDescription =
     std::vector<std::tuple<AttribType, DataType, ElementCount, DataTypeSize>>;
 
+// Small integer for a uniform name, shared by all shaders and renderers.
+// Resolve it once and pass it to SetUniform instead of the name, so the
+// per-call lookup is an array index.
+using UniformId = uint32_t;
+
+UniformId GetUniformId(const std::string& name);
+const std::string& GetUniformName(UniformId id);
+
+// State changes that were sent to the driver versus the ones skipped because
+// they wouldn't change anything.
+struct RenderStateStats {
+  size_t uniforms_issued = 0;
+  size_t uniforms_skipped = 0;
+  // Shaders, textures, viewport, scissor and depth test.
+  size_t states_issued = 0;
+  size_t states_skipped = 0;
+};
+
 const char* ImageFormatToString(ImageFormat format);
 
 bool IsCompressedFormat(ImageFormat format);
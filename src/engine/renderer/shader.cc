@@ -46,34 +46,58 @@ void Shader::Activate() {
     renderer_->ActivateShader(resource_id_);
 }
 
-void Shader::SetUniform(const std::string& name, const Vector2f& v) {
+void Shader::SetUniform(UniformId id, const Vector2f& v) {
   if (IsValid())
-    renderer_->SetUniform(resource_id_, name, v);
+    renderer_->SetUniform(resource_id_, id, v);
 }
 
-void Shader::SetUniform(const std::string& name, const Vector3f& v) {
+void Shader::SetUniform(UniformId id, const Vector3f& v) {
   if (IsValid())
-    renderer_->SetUniform(resource_id_, name, v);
+    renderer_->SetUniform(resource_id_, id, v);
 }
 
-void Shader::SetUniform(const std::string& name, const Vector4f& v) {
+void Shader::SetUniform(UniformId id, const Vector4f& v) {
   if (IsValid())
-    renderer_->SetUniform(resource_id_, name, v);
+    renderer_->SetUniform(resource_id_, id, v);
 }
 
-void Shader::SetUniform(const std::string& name, const Matrix4f& m) {
+void Shader::SetUniform(UniformId id, const Matrix4f& m) {
   if (IsValid())
-    renderer_->SetUniform(resource_id_, name, m);
+    renderer_->SetUniform(resource_id_, id, m);
 }
 
-void Shader::SetUniform(const std::string& name, float f) {
+void Shader::SetUniform(UniformId id, float f) {
   if (IsValid())
-    renderer_->SetUniform(resource_id_, name, f);
+    renderer_->SetUniform(resource_id_, id, f);
 }
 
-void Shader::SetUniform(const std::string& name, int i) {
+void Shader::SetUniform(UniformId id, int i) {
   if (IsValid())
-    renderer_->SetUniform(resource_id_, name, i);
+    renderer_->SetUniform(resource_id_, id, i);
+}
+
+void Shader::SetUniform(const std::string& name, const Vector2f& v) {
+  SetUniform(GetUniformId(name), v);
+}
+
+void Shader::SetUniform(const std::string& name, const Vector3f& v) {
+  SetUniform(GetUniformId(name), v);
+}
+
+void Shader::SetUniform(const std::string& name, const Vector4f& v) {
+  SetUniform(GetUniformId(name), v);
+}
+
+void Shader::SetUniform(const std::string& name, const Matrix4f& m) {
+  SetUniform(GetUniformId(name), m);
+}
+
+void Shader::SetUniform(const std::string& name, float f) {
+  SetUniform(GetUniformId(name), f);
+}
+
+void Shader::SetUniform(const std::string& name, int i) {
+  SetUniform(GetUniformId(name), i);
 }
 
 }  // namespace eng
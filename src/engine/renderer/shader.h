@@ -31,6 +31,19 @@ class Shader : public RenderResource {
 
   void Activate();
 
+  // Resolve uniform ids once and use them in the draw loop. Setting uniforms
+  // by name looks the name up on every call.
+  static UniformId GetUniformId(const std::string& name) {
+    return eng::GetUniformId(name);
+  }
+
+  void SetUniform(UniformId id, const base::Vector2f& v);
+  void SetUniform(UniformId id, const base::Vector3f& v);
+  void SetUniform(UniformId id, const base::Vector4f& v);
+  void SetUniform(UniformId id, const base::Matrix4f& m);
+  void SetUniform(UniformId id, float f);
+  void SetUniform(UniformId id, int i);
+
   void SetUniform(const std::string& name, const base::Vector2f& v);
   void SetUniform(const std::string& name, const base::Vector3f& v);
   void SetUniform(const std::string& name, const base::Vector4f& v);
@@ -7,6 +7,7 @@
 
 #include "base/hash.h"
 #include "base/log.h"
+#include "base/trace.h"
 #include "base/vecmath.h"
 #include "engine/asset/image.h"
 #include "engine/asset/mesh.h"
@@ -78,9 +79,16 @@ constexpr VkFormat kVkDataType[kDataType_Max][4] = {
 
 constexpr size_t kMaxDescriptorsPerPool = 64;
 
+// Set of the Frame uniform block. Must match the FRAME_UNIFORMS macro in
+// shader_source.cc. Lower sets are for textures.
+constexpr uint32_t kFrameDescriptorSet = 3;
+static_assert(sizeof(FrameUniforms) == 76,
+              "Must match the std140 layout of the Frame block.");
+
 std::vector<uint8_t> CompileGlsl(EShLanguage stage,
                                  const char* source_code,
                                  std::string* error) {
+  TRACE_SCOPE("CompileGlsl");
   const int kClientInputSemanticsVersion = 100;  // maps to #define VULKAN 100
   const int kDefaultVersion = 450;
 
@@ -280,8 +288,7 @@ void RendererVulkan::SetViewport(int x, int y, int width, int height) {
   viewport.height = -(float)height;
   viewport.minDepth = 0;
   viewport.maxDepth = 1.0;
-  vkCmdSetViewport(frames_[current_frame_].draw_command_buffer, 0, 1,
-                   &viewport);
+  SetViewportInternal(viewport);
 }
 
 void RendererVulkan::ResetViewport() {
@@ -292,8 +299,7 @@ void RendererVulkan::ResetViewport() {
   viewport.height = -(float)context_.GetWindowHeight();
   viewport.minDepth = 0;
   viewport.maxDepth = 1.0;
-  vkCmdSetViewport(frames_[current_frame_].draw_command_buffer, 0, 1,
-                   &viewport);
+  SetViewportInternal(viewport);
 }
 
 void RendererVulkan::SetScissor(int x, int y, int width, int height) {
@@ -311,7 +317,7 @@ void RendererVulkan::SetScissor(int x, int y, int width, int height) {
   scissor.offset.y = y;
   scissor.extent.width = width;
   scissor.extent.height = height;
-  vkCmdSetScissor(frames_[current_frame_].draw_command_buffer, 0, 1, &scissor);
+  SetScissorInternal(scissor);
 }
 
 void RendererVulkan::ResetScissor() {
@@ -320,7 +326,7 @@ void RendererVulkan::ResetScissor() {
   scissor.offset.y = 0;
   scissor.extent.width = context_.GetWindowWidth();
   scissor.extent.height = context_.GetWindowHeight();
-  vkCmdSetScissor(frames_[current_frame_].draw_command_buffer, 0, 1, &scissor);
+  SetScissorInternal(scissor);
 }
 
 uint64_t RendererVulkan::CreateGeometry(std::unique_ptr<Mesh> mesh) {
@@ -412,18 +418,26 @@ void RendererVulkan::Draw(uint64_t resource_id,
   if (it == geometries_.end())
     return;
 
-  // Update the values of push constants for the active shader if dirty.
+  // Update the values of push constants for the active shader if dirty or if
+  // they were overwritten by another shader.
   if (active_shader_id_ != kInvalidId) {
     auto active_shader = shaders_.find(active_shader_id_);
     if (active_shader != shaders_.end() &&
-        active_shader->second.push_constants_dirty) {
-      active_shader->second.push_constants_dirty = false;
-      vkCmdPushConstants(
-          frames_[current_frame_].draw_command_buffer,
-          active_shader->second.pipeline_layout,
-          VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0,
-          active_shader->second.push_constants_size,
-          active_shader->second.push_constants.get());
+        active_shader->second.push_constants_size) {
+      if (active_shader->second.push_constants_dirty ||
+          pushed_shader_id_ != active_shader_id_) {
+        active_shader->second.push_constants_dirty = false;
+        pushed_shader_id_ = active_shader_id_;
+        vkCmdPushConstants(
+            frames_[current_frame_].draw_command_buffer,
+            active_shader->second.pipeline_layout,
+            VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0,
+            active_shader->second.push_constants_size,
+            active_shader->second.push_constants.get());
+        ++state_stats_.states_issued;
+      } else {
+        ++state_stats_.states_skipped;
+      }
     }
   }
 
@@ -466,6 +480,7 @@ void RendererVulkan::UpdateTexture(uint64_t resource_id,
                                    ImageFormat format,
                                    size_t data_size,
                                    uint8_t* image_data) {
+  TRACE_SCOPE("RendererVulkan::UpdateTexture");
   auto it = textures_.find(resource_id);
   if (it == textures_.end())
     return;
@@ -530,9 +545,12 @@ void RendererVulkan::ActivateTexture(uint64_t resource_id,
   if (it == textures_.end())
     return;
 
-  if (active_descriptor_sets_[texture_unit] !=
+  if (active_descriptor_sets_[texture_unit] ==
       std::get<0>(it->second.desc_set)) {
+    ++state_stats_.states_skipped;
+  } else {
     active_descriptor_sets_[texture_unit] = std::get<0>(it->second.desc_set);
+    ++state_stats_.states_issued;
     if (active_shader_id_ != kInvalidId) {
       auto active_shader = shaders_.find(active_shader_id_);
       if (active_shader != shaders_.end() &&
@@ -752,8 +770,11 @@ void RendererVulkan::ActivateShader(uint64_t resource_id) {
   if (it == shaders_.end())
     return;
 
-  if (active_shader_id_ != resource_id) {
+  if (active_shader_id_ == resource_id) {
+    ++state_stats_.states_skipped;
+  } else {
     active_shader_id_ = resource_id;
+    ++state_stats_.states_issued;
     vkCmdBindPipeline(frames_[current_frame_].draw_command_buffer,
                       VK_PIPELINE_BIND_POINT_GRAPHICS, it->second.pipeline);
 
@@ -765,71 +786,81 @@ void RendererVulkan::ActivateShader(uint64_t resource_id) {
                                 &active_descriptor_sets_[i], 0, nullptr);
       }
     }
+
+    if (it->second.use_frame_uniforms) {
+      vkCmdBindDescriptorSets(frames_[current_frame_].draw_command_buffer,
+                              VK_PIPELINE_BIND_POINT_GRAPHICS,
+                              it->second.pipeline_layout, kFrameDescriptorSet,
+                              1, &frames_[current_frame_].uniform_desc_set, 0,
+                              nullptr);
+    }
   }
 }
 
 void RendererVulkan::SetUniform(uint64_t resource_id,
-                                const std::string& name,
+                                UniformId id,
                                 const base::Vector2f& val) {
   auto it = shaders_.find(resource_id);
   if (it == shaders_.end())
     return;
 
-  SetUniformInternal(it->second, name, val);
+  SetUniformInternal(it->second, id, val);
 }
 
 void RendererVulkan::SetUniform(uint64_t resource_id,
-                                const std::string& name,
+                                UniformId id,
                                 const base::Vector3f& val) {
   auto it = shaders_.find(resource_id);
   if (it == shaders_.end())
     return;
 
-  SetUniformInternal(it->second, name, val);
+  SetUniformInternal(it->second, id, val);
 }
 
 void RendererVulkan::SetUniform(uint64_t resource_id,
-                                const std::string& name,
+                                UniformId id,
                                 const base::Vector4f& val) {
   auto it = shaders_.find(resource_id);
   if (it == shaders_.end())
     return;
 
-  SetUniformInternal(it->second, name, val);
+  SetUniformInternal(it->second, id, val);
 }
 
 void RendererVulkan::SetUniform(uint64_t resource_id,
-                                const std::string& name,
+                                UniformId id,
                                 const base::Matrix4f& val) {
   auto it = shaders_.find(resource_id);
   if (it == shaders_.end())
     return;
 
-  SetUniformInternal(it->second, name, val);
+  SetUniformInternal(it->second, id, val);
 }
 
-void RendererVulkan::SetUniform(uint64_t resource_id,
-                                const std::string& name,
-                                float val) {
+void RendererVulkan::SetUniform(uint64_t resource_id, UniformId id, float val) {
   auto it = shaders_.find(resource_id);
   if (it == shaders_.end())
     return;
 
-  SetUniformInternal(it->second, name, val);
+  SetUniformInternal(it->second, id, val);
 }
 
-void RendererVulkan::SetUniform(uint64_t resource_id,
-                                const std::string& name,
-                                int val) {
+void RendererVulkan::SetUniform(uint64_t resource_id, UniformId id, int val) {
   auto it = shaders_.find(resource_id);
   if (it == shaders_.end())
     return;
 
-  for (auto& sampler_name : it->second.sampler_uniform_names) {
-    if (name == sampler_name)
-      return;
+  SetUniformInternal(it->second, id, val);
+}
+
+void RendererVulkan::SetFrameUniforms(const FrameUniforms& frame) {
+  // The buffer of the current frame is not in use by the GPU, so it's safe to
+  // write into it.
+  frame_uniforms_ = frame;
+  if (frames_[current_frame_].uniform_data) {
+    memcpy(frames_[current_frame_].uniform_data, &frame_uniforms_,
+           sizeof(frame_uniforms_));
   }
-  SetUniformInternal(it->second, name, val);
 }
 
 void RendererVulkan::PrepareForDrawing() {
@@ -838,6 +869,7 @@ void RendererVulkan::PrepareForDrawing() {
 }
 
 void RendererVulkan::Present() {
+  TRACE_SCOPE("RendererVulkan::Present");
   DrawListEnd();
   SwapBuffers();
 }
@@ -911,8 +943,8 @@ bool RendererVulkan::InitializeInternal() {
     }
   }
 
-  // In this simple engine we use only one descriptor set layout that is for
-  // textures. We use push constants for everything else.
+  // All texture descriptor sets use the same layout. Frame uniforms have their
+  // own. We use push constants for everything else.
   VkDescriptorSetLayoutBinding ds_layout_binding;
   ds_layout_binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
   ds_layout_binding.descriptorCount = 1;
@@ -962,6 +994,9 @@ bool RendererVulkan::InitializeInternal() {
     return false;
   }
 
+  if (!CreateFrameUniforms())
+    return false;
+
   texture_compression_.dxt1 = IsFormatSupported(VK_FORMAT_BC1_RGB_UNORM_BLOCK);
   texture_compression_.s3tc = IsFormatSupported(VK_FORMAT_BC3_UNORM_BLOCK);
 
@@ -1000,10 +1035,11 @@ bool RendererVulkan::InitializeInternal() {
 void RendererVulkan::Shutdown() {
   LOG(0) << "Shutting down renderer.";
   if (device_ != VK_NULL_HANDLE) {
-    task_runner_.CancelTasks();
     quit_.store(true, std::memory_order_relaxed);
     semaphore_.release();
     setup_thread_.join();
+    // Cancel once the setup thread stopped consuming tasks.
+    task_runner_.CancelTasks();
 
     for (size_t i = 0; i < staging_buffers_.size(); i++) {
       auto [buffer, allocation] = staging_buffers_[i].buffer;
@@ -1021,6 +1057,8 @@ void RendererVulkan::Shutdown() {
       vkDestroyCommandPool(device_, frames_[i].draw_command_pool, nullptr);
     }
 
+    DestroyFrameUniforms();
+
     vmaDestroyAllocator(allocator_);
 
     vkDestroyDescriptorSetLayout(device_, descriptor_set_layout_, nullptr);
@@ -1045,6 +1083,12 @@ void RendererVulkan::Shutdown() {
 void RendererVulkan::BeginFrame() {
   FreePendingResources(current_frame_);
 
+  // Start with the last frame's values in case they aren't set in this frame.
+  if (frames_[current_frame_].uniform_data) {
+    memcpy(frames_[current_frame_].uniform_data, &frame_uniforms_,
+           sizeof(frame_uniforms_));
+  }
+
   context_.AppendCommandBuffer(frames_[current_frame_].setup_command_buffer);
   context_.AppendCommandBuffer(frames_[current_frame_].draw_command_buffer);
 
@@ -1335,6 +1379,141 @@ bool RendererVulkan::InsertStagingBuffer() {
   return true;
 }
 
+bool RendererVulkan::CreateFrameUniforms() {
+  VkDescriptorSetLayoutBinding ds_layout_binding;
+  ds_layout_binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+  ds_layout_binding.descriptorCount = 1;
+  ds_layout_binding.binding = 0;
+  ds_layout_binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+  ds_layout_binding.pImmutableSamplers = nullptr;
+
+  VkDescriptorSetLayoutCreateInfo ds_layout_info;
+  ds_layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+  ds_layout_info.pNext = nullptr;
+  ds_layout_info.flags = 0;
+  ds_layout_info.bindingCount = 1;
+  ds_layout_info.pBindings = &ds_layout_binding;
+
+  VkResult err = vkCreateDescriptorSetLayout(device_, &ds_layout_info, nullptr,
+                                             &frame_descriptor_set_layout_);
+  if (err) {
+    DLOG(0) << "Error (" << string_VkResult(err)
+            << ") creating descriptor set layout for frame uniforms";
+    return false;
+  }
+
+  // One descriptor set per frame.
+  VkDescriptorPoolSize sizes;
+  sizes.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+  sizes.descriptorCount = frames_.size();
+
+  VkDescriptorPoolCreateInfo descriptor_pool_create_info;
+  descriptor_pool_create_info.sType =
+      VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+  descriptor_pool_create_info.pNext = nullptr;
+  descriptor_pool_create_info.flags = 0;
+  descriptor_pool_create_info.maxSets = frames_.size();
+  descriptor_pool_create_info.poolSizeCount = 1;
+  descriptor_pool_create_info.pPoolSizes = &sizes;
+
+  err = vkCreateDescriptorPool(device_, &descriptor_pool_create_info, nullptr,
+                               &frame_descriptor_pool_);
+  if (err) {
+    DLOG(0) << "vkCreateDescriptorPool failed with error "
+            << string_VkResult(err);
+    return false;
+  }
+
+  // std140 rounds the block size up to a multiple of 16.
+  VkDeviceSize buffer_size = (sizeof(FrameUniforms) + 15) & ~15;
+
+  for (Frame& frame : frames_) {
+    VkBufferCreateInfo buffer_info;
+    buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    buffer_info.pNext = nullptr;
+    buffer_info.flags = 0;
+    buffer_info.size = buffer_size;
+    buffer_info.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+    buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    buffer_info.queueFamilyIndexCount = 0;
+    buffer_info.pQueueFamilyIndices = nullptr;
+
+    VmaAllocationCreateInfo alloc_info;
+    alloc_info.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT |
+                       VMA_ALLOCATION_CREATE_MAPPED_BIT;  // Stay mapped.
+    alloc_info.usage = VMA_MEMORY_USAGE_AUTO_PREFER_HOST;
+    alloc_info.requiredFlags = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT |
+                               VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+    alloc_info.preferredFlags = 0;
+    alloc_info.memoryTypeBits = 0;
+    alloc_info.pool = nullptr;
+    alloc_info.pUserData = nullptr;
+
+    VmaAllocationInfo allocation_info;
+    err = vmaCreateBuffer(allocator_, &buffer_info, &alloc_info,
+                          &std::get<0>(frame.uniform_buffer),
+                          &std::get<1>(frame.uniform_buffer), &allocation_info);
+    if (err) {
+      DLOG(0) << "vmaCreateBuffer failed with error " << string_VkResult(err);
+      return false;
+    }
+    frame.uniform_data = allocation_info.pMappedData;
+    memset(frame.uniform_data, 0, buffer_size);
+
+    VkDescriptorSetAllocateInfo descriptor_set_allocate_info;
+    descriptor_set_allocate_info.sType =
+        VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    descriptor_set_allocate_info.pNext = nullptr;
+    descriptor_set_allocate_info.descriptorPool = frame_descriptor_pool_;
+    descriptor_set_allocate_info.descriptorSetCount = 1;
+    descriptor_set_allocate_info.pSetLayouts = &frame_descriptor_set_layout_;
+
+    err = vkAllocateDescriptorSets(device_, &descriptor_set_allocate_info,
+                                   &frame.uniform_desc_set);
+    if (err) {
+      DLOG(0) << "Cannot allocate descriptor sets, error "
+              << string_VkResult(err);
+      return false;
+    }
+
+    VkDescriptorBufferInfo buffer_desc_info;
+    buffer_desc_info.buffer = std::get<0>(frame.uniform_buffer);
+    buffer_desc_info.offset = 0;
+    buffer_desc_info.range = buffer_size;
+
+    VkWriteDescriptorSet write;
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.pNext = nullptr;
+    write.dstSet = frame.uniform_desc_set;
+    write.dstBinding = 0;
+    write.dstArrayElement = 0;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    write.pImageInfo = nullptr;
+    write.pBufferInfo = &buffer_desc_info;
+    write.pTexelBufferView = nullptr;
+
+    vkUpdateDescriptorSets(device_, 1, &write, 0, nullptr);
+  }
+  return true;
+}
+
+void RendererVulkan::DestroyFrameUniforms() {
+  for (Frame& frame : frames_) {
+    auto [buffer, allocation] = frame.uniform_buffer;
+    if (buffer != VK_NULL_HANDLE)
+      vmaDestroyBuffer(allocator_, buffer, allocation);
+    frame.uniform_buffer = {VK_NULL_HANDLE, nullptr};
+    frame.uniform_data = nullptr;
+    frame.uniform_desc_set = VK_NULL_HANDLE;
+  }
+  // Destroying the pool frees the descriptor sets.
+  vkDestroyDescriptorPool(device_, frame_descriptor_pool_, nullptr);
+  frame_descriptor_pool_ = VK_NULL_HANDLE;
+  vkDestroyDescriptorSetLayout(device_, frame_descriptor_set_layout_, nullptr);
+  frame_descriptor_set_layout_ = VK_NULL_HANDLE;
+}
+
 RendererVulkan::DescPool* RendererVulkan::AllocateDescriptorPool() {
   DescPool* selected_pool = nullptr;
 
@@ -1742,19 +1921,39 @@ bool RendererVulkan::CreatePipelineLayout(
   do {
     uint32_t binding_count = 0;
 
-    // Validate that the vertex shader has no descriptor binding.
+    // Validate that the vertex shader has no descriptor binding other than the
+    // frame uniforms.
     result = spvReflectEnumerateDescriptorBindings(&module_vertex,
                                                    &binding_count, nullptr);
     if (result != SPV_REFLECT_RESULT_SUCCESS) {
-      DLOG(0) << "SPIR-V reflection failed to enumerate fragment shader "
+      DLOG(0) << "SPIR-V reflection failed to enumerate vertex shader "
                  "descriptor bindings.";
       break;
     }
-    if (binding_count > 0) {
+    if (binding_count > 1) {
       DLOG(0) << "SPIR-V reflection found " << binding_count
               << " descriptor bindings in vertex shader.";
       break;
     }
+    if (binding_count == 1) {
+      SpvReflectDescriptorBinding* binding = nullptr;
+      result = spvReflectEnumerateDescriptorBindings(&module_vertex,
+                                                     &binding_count, &binding);
+      if (result != SPV_REFLECT_RESULT_SUCCESS) {
+        DLOG(0) << "SPIR-V reflection failed to get descriptor bindings for "
+                   "vertex shader.";
+        break;
+      }
+      if (binding->set != kFrameDescriptorSet || binding->binding != 0 ||
+          binding->descriptor_type !=
+              SPV_REFLECT_DESCRIPTOR_TYPE_UNIFORM_BUFFER) {
+        DLOG(0) << "SPIR-V reflection found descriptor binding "
+                << binding->name
+                << " in vertex shader. Only the frame uniforms are supported.";
+        break;
+      }
+      shader.use_frame_uniforms = true;
+    }
 
     // Validate that the fragment shader has max 1 desriptor binding.
     result = spvReflectEnumerateDescriptorBindings(&module_fragment,
@@ -1809,6 +2008,12 @@ bool RendererVulkan::CreatePipelineLayout(
       }
     }
 
+    if (shader.use_frame_uniforms &&
+        shader.desc_set_count > kFrameDescriptorSet) {
+      DLOG(0) << "Too many textures for a shader that uses frame uniforms.";
+      break;
+    }
+
     if (active_descriptor_sets_.size() < shader.desc_set_count)
       active_descriptor_sets_.resize(shader.desc_set_count);
 
@@ -1905,18 +2110,23 @@ bool RendererVulkan::CreatePipelineLayout(
       }
     }
 
-    // Use the same layout for all descriptor sets.
+    // Use the same layout for all texture descriptor sets. The sets between
+    // the textures and the frame uniforms are unused, but still need a layout.
     std::vector<VkDescriptorSetLayout> desc_set_layouts;
     for (size_t i = 0; i < binding_count; ++i)
       desc_set_layouts.push_back(descriptor_set_layout_);
+    if (shader.use_frame_uniforms) {
+      desc_set_layouts.resize(kFrameDescriptorSet, descriptor_set_layout_);
+      desc_set_layouts.push_back(frame_descriptor_set_layout_);
+    }
 
     VkPipelineLayoutCreateInfo pipeline_layout_create_info;
     pipeline_layout_create_info.sType =
         VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
     pipeline_layout_create_info.pNext = nullptr;
     pipeline_layout_create_info.flags = 0;
-    if (binding_count > 0) {
-      pipeline_layout_create_info.setLayoutCount = binding_count;
+    if (!desc_set_layouts.empty()) {
+      pipeline_layout_create_info.setLayoutCount = desc_set_layouts.size();
       pipeline_layout_create_info.pSetLayouts = desc_set_layouts.data();
     } else {
       pipeline_layout_create_info.setLayoutCount = 0;
@@ -2010,6 +2220,9 @@ void RendererVulkan::SwapBuffers() {
   current_frame_ = (current_frame_ + 1) % frames_.size();
 
   active_shader_id_ = kInvalidId;
+  pushed_shader_id_ = kInvalidId;
+  viewport_valid_ = false;
+  scissor_valid_ = false;
   for (auto& ds : active_descriptor_sets_)
     ds = VK_NULL_HANDLE;
 
@@ -2026,30 +2239,81 @@ void RendererVulkan::SetupThreadMain() {
   }
 }
 
+void RendererVulkan::SetViewportInternal(const VkViewport& viewport) {
+  if (viewport_valid_ && !memcmp(&viewport_, &viewport, sizeof(viewport))) {
+    ++state_stats_.states_skipped;
+    return;
+  }
+  viewport_ = viewport;
+  viewport_valid_ = true;
+  ++state_stats_.states_issued;
+  vkCmdSetViewport(frames_[current_frame_].draw_command_buffer, 0, 1,
+                   &viewport);
+}
+
+void RendererVulkan::SetScissorInternal(const VkRect2D& scissor) {
+  if (scissor_valid_ && !memcmp(&scissor_, &scissor, sizeof(scissor))) {
+    ++state_stats_.states_skipped;
+    return;
+  }
+  scissor_ = scissor;
+  scissor_valid_ = true;
+  ++state_stats_.states_issued;
+  vkCmdSetScissor(frames_[current_frame_].draw_command_buffer, 0, 1, &scissor);
+}
+
 template <typename T>
 bool RendererVulkan::SetUniformInternal(ShaderVulkan& shader,
-                                        const std::string& name,
+                                        UniformId id,
                                         T val) {
-  auto hash = KR2Hash(name);
-  auto it = std::find_if(shader.variables.begin(), shader.variables.end(),
-                         [&](auto& r) { return hash == std::get<0>(r); });
-  if (it == shader.variables.end()) {
-    DLOG(0) << "No variable found with name " << name;
+  int variable = GetVariableIndex(shader, id);
+  if (variable < 0)
     return false;
-  }
 
-  if (std::get<1>(*it) != sizeof(val)) {
-    DLOG(0) << "Size mismatch for variable " << name;
+  auto& r = shader.variables[variable];
+  if (std::get<1>(r) != sizeof(val)) {
+    DLOG(0) << "Size mismatch for variable " << GetUniformName(id);
     return false;
   }
 
-  auto* dst =
-      reinterpret_cast<T*>(shader.push_constants.get() + std::get<2>(*it));
-  *dst = val;
+  // Skip if the value is unchanged.
+  auto* dst = shader.push_constants.get() + std::get<2>(r);
+  if (memcmp(dst, &val, sizeof(val)) == 0) {
+    ++state_stats_.uniforms_skipped;
+    return true;
+  }
+  memcpy(dst, &val, sizeof(val));
   shader.push_constants_dirty = true;
+  ++state_stats_.uniforms_issued;
   return true;
 }
 
+int RendererVulkan::GetVariableIndex(ShaderVulkan& shader, UniformId id) {
+  if (id >= shader.variable_indices.size())
+    shader.variable_indices.resize(id + 1, kUnresolvedVariable);
+
+  // Look up the name only the first time the uniform is used.
+  int& variable = shader.variable_indices[id];
+  if (variable == kUnresolvedVariable) {
+    const std::string& name = GetUniformName(id);
+    auto hash = KR2Hash(name);
+    auto it = std::find_if(shader.variables.begin(), shader.variables.end(),
+                           [&](auto& r) { return hash == std::get<0>(r); });
+    if (it != shader.variables.end()) {
+      variable = it - shader.variables.begin();
+    } else {
+      variable = -1;
+      // Samplers are bound with descriptor sets.
+      if (std::find(shader.sampler_uniform_names.begin(),
+                    shader.sampler_uniform_names.end(),
+                    name) == shader.sampler_uniform_names.end()) {
+        DLOG(0) << "No variable found with name " << name;
+      }
+    }
+  }
+  return variable;
+}
+
 bool RendererVulkan::IsFormatSupported(VkFormat format) {
   VkFormatProperties properties;
   vkGetPhysicalDeviceFormatProperties(context_.GetPhysicalDevice(), format,
@@ -73,21 +73,21 @@ class RendererVulkan final : public Renderer {
   void ActivateShader(uint64_t resource_id) final;
 
   void SetUniform(uint64_t resource_id,
-                  const std::string& name,
+                  UniformId id,
                   const base::Vector2f& val) final;
   void SetUniform(uint64_t resource_id,
-                  const std::string& name,
+                  UniformId id,
                   const base::Vector3f& val) final;
   void SetUniform(uint64_t resource_id,
-                  const std::string& name,
+                  UniformId id,
                   const base::Vector4f& val) final;
   void SetUniform(uint64_t resource_id,
-                  const std::string& name,
+                  UniformId id,
                   const base::Matrix4f& val) final;
-  void SetUniform(uint64_t resource_id,
-                  const std::string& name,
-                  float val) final;
-  void SetUniform(uint64_t resource_id, const std::string& name, int val) final;
+  void SetUniform(uint64_t resource_id, UniformId id, float val) final;
+  void SetUniform(uint64_t resource_id, UniformId id, int val) final;
+
+  void SetFrameUniforms(const FrameUniforms& frame) final;
 
   void PrepareForDrawing() final;
   void Present() final;
@@ -130,17 +130,22 @@ class RendererVulkan final : public Renderer {
     VkIndexType index_type = VK_INDEX_TYPE_NONE_KHR;
   };
 
+  static constexpr int kUnresolvedVariable = -2;
+
   struct ShaderVulkan {
     std::vector<std::tuple<size_t,  // Variable name hash
                            size_t,  // Variable size
                            size_t   // Push constant offset
                            >>
         variables;
+    // Indexed by UniformId. -1 if the shader doesn't have the variable.
+    std::vector<int> variable_indices;
     bool push_constants_dirty = false;
     std::unique_ptr<char[]> push_constants;
     size_t push_constants_size = 0;
     std::vector<std::string> sampler_uniform_names;
     size_t desc_set_count = 0;
+    bool use_frame_uniforms = false;
     VkPipelineLayout pipeline_layout = VK_NULL_HANDLE;
     VkPipeline pipeline = VK_NULL_HANDLE;
   };
@@ -164,6 +169,11 @@ class RendererVulkan final : public Renderer {
     VkCommandPool draw_command_pool = VK_NULL_HANDLE;
     VkCommandBuffer draw_command_buffer = VK_NULL_HANDLE;
 
+    // Frame uniforms. The buffer stays mapped.
+    Buffer<VkBuffer> uniform_buffer{VK_NULL_HANDLE, nullptr};
+    void* uniform_data = nullptr;
+    VkDescriptorSet uniform_desc_set = VK_NULL_HANDLE;
+
     BufferDeathRow buffers_to_destroy;
     ImageDeathRow images_to_destroy;
     DescSetDeathRow desc_sets_to_destroy;
@@ -199,12 +209,25 @@ class RendererVulkan final : public Renderer {
   uint64_t max_staging_buffer_size_ = 16 * 1024 * 1024;
   bool staging_buffer_used_ = false;
 
+  // Shadow of the command buffer state, used for skipping redundant commands.
+  // Reset when a new frame starts recording.
   uint64_t active_shader_id_ = 0;
+  // Shader whose push constants were pushed last. Pushing constants of another
+  // shader overwrites them.
+  uint64_t pushed_shader_id_ = 0;
+  bool viewport_valid_ = false;
+  VkViewport viewport_;
+  bool scissor_valid_ = false;
+  VkRect2D scissor_;
 
   std::vector<std::unique_ptr<DescPool>> desc_pools_;
   VkDescriptorSetLayout descriptor_set_layout_ = VK_NULL_HANDLE;
   std::vector<VkDescriptorSet> active_descriptor_sets_;
 
+  VkDescriptorSetLayout frame_descriptor_set_layout_ = VK_NULL_HANDLE;
+  VkDescriptorPool frame_descriptor_pool_ = VK_NULL_HANDLE;
+  FrameUniforms frame_uniforms_;
+
   VkSampler sampler_ = VK_NULL_HANDLE;
 
   std::thread setup_thread_;
@@ -233,6 +256,9 @@ class RendererVulkan final : public Renderer {
                              uint32_t& alloc_size);
   bool InsertStagingBuffer();
 
+  bool CreateFrameUniforms();
+  void DestroyFrameUniforms();
+
   DescPool* AllocateDescriptorPool();
   void FreeDescriptorPool(DescPool* desc_pool);
 
@@ -288,8 +314,12 @@ class RendererVulkan final : public Renderer {
 
   void SetupThreadMain();
 
+  void SetViewportInternal(const VkViewport& viewport);
+  void SetScissorInternal(const VkRect2D& scissor);
+
   template <typename T>
-  bool SetUniformInternal(ShaderVulkan& shader, const std::string& name, T val);
+  bool SetUniformInternal(ShaderVulkan& shader, UniformId id, T val);
+  int GetVariableIndex(ShaderVulkan& shader, UniformId id);
 
   bool IsFormatSupported(VkFormat format);
 
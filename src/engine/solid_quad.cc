@@ -6,9 +6,26 @@
 #include "engine/engine.h"
 #include "engine/renderer/geometry.h"
 #include "engine/renderer/shader.h"
+#include "engine/sprite_batch.h"
 
 namespace eng {
 
+namespace {
+
+struct Uniforms {
+  UniformId offset = Shader::GetUniformId("offset");
+  UniformId scale = Shader::GetUniformId("scale");
+  UniformId rotation = Shader::GetUniformId("rotation");
+  UniformId color = Shader::GetUniformId("color");
+};
+
+const Uniforms& GetUniforms() {
+  static const Uniforms uniforms;
+  return uniforms;
+}
+
+}  // namespace
+
 void SolidQuad::Draw(float frame_frac) {
   DCHECK(IsVisible());
 
@@ -16,14 +33,25 @@ void SolidQuad::Draw(float frame_frac) {
   if (!shader)
     shader = &Engine::Get().GetSolidShader();
 
+  const Uniforms& u = GetUniforms();
   shader->Activate();
-  shader->SetUniform("offset", position_);
-  shader->SetUniform("scale", GetSize());
-  shader->SetUniform("rotation", rotation_);
-  shader->SetUniform("projection", Engine::Get().GetProjectionMatrix());
-  shader->SetUniform("color", color_);
+  shader->SetUniform(u.offset, position_);
+  shader->SetUniform(u.scale, GetSize());
+  shader->SetUniform(u.rotation, rotation_);
+  shader->SetUniform(u.color, color_);
   DoSetCustomUniforms();
   Engine::Get().GetQuad().Draw();
 }
 
+bool SolidQuad::AddToBatch(SpriteBatch* batch) {
+  DCHECK(IsVisible());
+
+  if (GetCustomShader())
+    return false;
+
+  batch->AddQuad(nullptr, position_, GetSize(), rotation_, {0, 0}, {1, 1},
+                 color_);
+  return true;
+}
+
 }  // namespace eng
@@ -19,6 +19,7 @@ class SolidQuad final : public Animatable {
 
   // Drawable interface.
   void Draw(float frame_frac) final;
+  bool AddToBatch(SpriteBatch* batch) final;
 
  private:
   base::Vector4f color_ = {1, 1, 1, 1};
@@ -0,0 +1,166 @@
+#include "engine/sprite_batch.h"
+
+#include <algorithm>
+
+#include "base/log.h"
+#include "engine/asset/shader_source.h"
+#include "engine/drawable.h"
+#include "engine/renderer/texture.h"
+
+using namespace base;
+
+namespace eng {
+
+namespace {
+
+const char vertex_description[] = "p2f;t2f;c4f";
+
+constexpr size_t kIndicesPerQuad = 6;
+
+// Limited by 16-bit indices.
+constexpr size_t kMaxQuadsPerGeometry =
+    65536 / TransformBatch::kVerticesPerQuad;
+
+}  // namespace
+
+SpriteBatch::SpriteBatch()
+    : texture_0_id_(Shader::GetUniformId("texture_0")) {
+  if (!ParseVertexDescription(vertex_description, vertex_description_))
+    LOG(0) << "Failed to parse vertex description.";
+
+  // Two triangles per quad, the vertices are in triangle strip order.
+  indices_.reserve(kMaxQuadsPerGeometry * kIndicesPerQuad);
+  for (size_t i = 0; i < kMaxQuadsPerGeometry; ++i) {
+    size_t first_vertex = i * TransformBatch::kVerticesPerQuad;
+    for (size_t index : {0, 1, 2, 2, 1, 3})
+      indices_.push_back(static_cast<uint16_t>(first_vertex + index));
+  }
+}
+
+SpriteBatch::~SpriteBatch() = default;
+
+void SpriteBatch::CreateRenderResources(Renderer* renderer) {
+  renderer_ = renderer;
+  shader_.SetRenderer(renderer);
+  solid_shader_.SetRenderer(renderer);
+  for (auto& g : geometries_)
+    g.SetRenderer(renderer);
+
+  auto source = std::make_unique<ShaderSource>();
+  if (source->Load("engine/sprite.glsl")) {
+    shader_.Create(std::move(source), vertex_description_, kPrimitive_Triangles,
+                   false);
+  } else {
+    LOG(0) << "Could not create sprite shader.";
+  }
+
+  source = std::make_unique<ShaderSource>();
+  if (source->Load("engine/sprite_solid.glsl")) {
+    solid_shader_.Create(std::move(source), vertex_description_,
+                         kPrimitive_Triangles, false);
+  } else {
+    LOG(0) << "Could not create solid sprite shader.";
+  }
+}
+
+void SpriteBatch::Destroy() {
+  geometries_.clear();
+  shader_.Destroy();
+  solid_shader_.Destroy();
+}
+
+void SpriteBatch::Begin() {
+  transform_batch_.Clear();
+  colors_.clear();
+  commands_.clear();
+}
+
+void SpriteBatch::AddQuad(Texture* texture,
+                          const Vector2f& position,
+                          const Vector2f& size,
+                          const Vector2f& rotation,
+                          const Vector2f& uv_offset,
+                          const Vector2f& uv_scale,
+                          const Vector4f& color) {
+  size_t quad = transform_batch_.size();
+  transform_batch_.Add(position, size, rotation, uv_offset, uv_scale);
+  colors_.push_back(color);
+
+  // Extend the last batch if possible. Batches can't span geometries.
+  if (!commands_.empty()) {
+    Command& last = commands_.back();
+    if (!last.drawable && last.texture == texture &&
+        quad % kMaxQuadsPerGeometry != 0) {
+      ++last.num_quads;
+      return;
+    }
+  }
+  commands_.push_back({nullptr, texture, quad, 1});
+}
+
+void SpriteBatch::AddDrawable(Drawable* drawable) {
+  commands_.push_back({drawable, nullptr, 0, 0});
+}
+
+void SpriteBatch::End(float frame_frac) {
+  UpdateGeometries();
+
+  num_sprites_ = transform_batch_.size();
+  num_batches_ = 0;
+  num_draw_calls_ = 0;
+
+  for (Command& command : commands_) {
+    ++num_draw_calls_;
+    if (command.drawable) {
+      command.drawable->Draw(frame_frac);
+      continue;
+    }
+    ++num_batches_;
+
+    Shader* shader = command.texture ? &shader_ : &solid_shader_;
+    shader->Activate();
+    if (command.texture) {
+      command.texture->Activate(0);
+      shader->SetUniform(texture_0_id_, 0);
+    }
+    size_t first_quad = command.first_quad % kMaxQuadsPerGeometry;
+    geometries_[command.first_quad / kMaxQuadsPerGeometry].Draw(
+        command.num_quads * kIndicesPerQuad, first_quad * kIndicesPerQuad);
+  }
+}
+
+void SpriteBatch::UpdateGeometries() {
+  size_t num_quads = transform_batch_.size();
+  if (num_quads == 0)
+    return;
+
+  transformed_.resize(transform_batch_.GetNumVertices());
+  transform_batch_.Transform(transformed_.data());
+
+  vertices_.resize(transformed_.size());
+  for (size_t i = 0; i < transformed_.size(); ++i) {
+    const TransformBatch::Vertex& src = transformed_[i];
+    vertices_[i] = {src.x, src.y, src.u, src.v,
+                    colors_[i / TransformBatch::kVerticesPerQuad]};
+  }
+
+  // The renderer may read the vertices until the frame is presented, so they
+  // are kept until the next frame.
+  size_t num_geometries =
+      (num_quads + kMaxQuadsPerGeometry - 1) / kMaxQuadsPerGeometry;
+  for (size_t i = 0; i < num_geometries; ++i) {
+    if (geometries_.size() <= i)
+      geometries_.emplace_back(renderer_);
+    if (!geometries_[i].IsValid())
+      geometries_[i].Create(kPrimitive_Triangles, vertex_description_,
+                            kDataType_UShort);
+    size_t first_quad = i * kMaxQuadsPerGeometry;
+    size_t count = std::min(num_quads - first_quad, kMaxQuadsPerGeometry);
+    geometries_[i].Update(
+        count * TransformBatch::kVerticesPerQuad,
+        &vertices_[first_quad * TransformBatch::kVerticesPerQuad],
+        count * kIndicesPerQuad, indices_.data());
+  }
+}
+
+}  // namespace eng
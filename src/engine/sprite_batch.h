@@ -0,0 +1,106 @@
+#ifndef ENGINE_SPRITE_BATCH_H
+#define ENGINE_SPRITE_BATCH_H
+
+#include <cstdint>
+#include <vector>
+
+#include "base/transform_batch.h"
+#include "base/vecmath.h"
+#include "engine/renderer/geometry.h"
+#include "engine/renderer/renderer_types.h"
+#include "engine/renderer/shader.h"
+
+namespace eng {
+
+class Drawable;
+class Renderer;
+class Texture;
+
+// Merges the draws of consecutive sprites that share the same texture into a
+// single draw call. Collects a frame worth of quads, transforms them on the CPU
+// and uploads the vertices once. Then draws the batches and the drawables that
+// can't be batched in the order they were added. e.g.
+//   batch.Begin();
+//   for (auto* d : drawables) {
+//     if (!d->AddToBatch(&batch))
+//       batch.AddDrawable(d);
+//   }
+//   renderer->PrepareForDrawing();
+//   batch.End(frame_frac);
+class SpriteBatch {
+ public:
+  SpriteBatch();
+  ~SpriteBatch();
+
+  SpriteBatch(const SpriteBatch&) = delete;
+  SpriteBatch& operator=(const SpriteBatch&) = delete;
+
+  void CreateRenderResources(Renderer* renderer);
+  void Destroy();
+
+  void Begin();
+
+  // Adds a quad drawn with the same transform as the pass-through shader. Quads
+  // without a texture are drawn with a solid color. The texture must stay alive
+  // until End().
+  void AddQuad(Texture* texture,
+               const base::Vector2f& position,
+               const base::Vector2f& size,
+               const base::Vector2f& rotation,
+               const base::Vector2f& uv_offset,
+               const base::Vector2f& uv_scale,
+               const base::Vector4f& color);
+
+  // Adds a drawable that is drawn with its own Draw() call. Breaks the batch.
+  void AddDrawable(Drawable* drawable);
+
+  // Uploads the vertices and draws everything that was added since Begin().
+  void End(float frame_frac);
+
+  // Stats of the last frame.
+  size_t num_sprites() const { return num_sprites_; }
+  size_t num_batches() const { return num_batches_; }
+  size_t num_draw_calls() const { return num_draw_calls_; }
+
+ private:
+  // Matches the "p2f;t2f;c4f" vertex description.
+  struct Vertex {
+    float x, y;
+    float u, v;
+    base::Vector4f color;
+  };
+
+  // A range of quads or a single drawable.
+  struct Command {
+    Drawable* drawable = nullptr;
+    Texture* texture = nullptr;
+    size_t first_quad = 0;
+    size_t num_quads = 0;
+  };
+
+  VertexDescription vertex_description_;
+  Shader shader_;
+  Shader solid_shader_;
+  UniformId texture_0_id_;
+  // Indices are 16-bit, so the vertices are split into chunks of
+  // kMaxQuadsPerGeometry quads. Each chunk is uploaded to its own geometry.
+  std::vector<Geometry> geometries_;
+  std::vector<uint16_t> indices_;
+  Renderer* renderer_ = nullptr;
+
+  base::TransformBatch transform_batch_;
+  std::vector<base::Vector4f> colors_;
+  std::vector<base::TransformBatch::Vertex> transformed_;
+  std::vector<Vertex> vertices_;
+  std::vector<Command> commands_;
+
+  size_t num_sprites_ = 0;
+  size_t num_batches_ = 0;
+  size_t num_draw_calls_ = 0;
+
+  void UpdateGeometries();
+};
+
+}  // namespace eng
+
+#endif  // ENGINE_SPRITE_BATCH_H